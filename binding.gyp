@@ -1,9 +1,56 @@
 {
+  "variables": {
+    # Linux only: "xlib" opens the shared connection through Xlib, "xcb" uses
+    # libxcb directly (node-gyp rebuild --linux_backend=xcb)
+    "linux_backend%": "xlib",
+    # Also build the lib/core test and benchmark executables
+    # (node-gyp rebuild --core_tests=true, see npm run test:core)
+    "core_tests%": "false",
+    # Linux only: also build the stand-in window manager, synthetic client
+    # and per-call baseline used by the Xvfb benchmarks and tests (see npm run
+    # bench:e2e, bench:calls, test:e2e)
+    "e2e_bench%": "false"
+  },
+  "target_defaults": {
+    "cflags!": [ "-fno-exceptions" ],
+    "cflags_cc!": [ "-fno-exceptions" ]
+  },
   "targets": [
+    {
+      # Platform-independent window model: records, filtering, z-order,
+      # hit-testing, occlusion, layout batches and tiling, diffing and
+      # serialization. No N-API or window-system dependency.
+      "target_name": "window_core",
+      "type": "static_library",
+      "sources": [
+        "lib/core/layout.cc",
+        "lib/core/monitors.cc",
+        "lib/core/spatial_index.cc",
+        "lib/core/stats.cc",
+        "lib/core/summary_fields.cc",
+        "lib/core/tiling.cc",
+        "lib/core/trace.cc",
+        "lib/core/visible_region.cc",
+        "lib/core/window_cache.cc",
+        "lib/core/window_columns.cc",
+        "lib/core/window_diff.cc",
+        "lib/core/window_filter.cc",
+        "lib/core/z_order.cc"
+      ],
+      "direct_dependent_settings": {
+        "include_dirs": [ "lib" ]
+      },
+      # std::regex reports bad title patterns from setWindowFilters by throwing
+      "xcode_settings": { "GCC_ENABLE_CPP_EXCEPTIONS": "YES" },
+      "msvs_settings": { "VCCLCompilerTool": { "ExceptionHandling": 1 } },
+      "conditions": [
+        # Linked into the addon's shared object
+        ["OS=='linux'", { "cflags": [ "-fPIC" ] }]
+      ]
+    },
     {
       "target_name": "addon",
-      "cflags!": [ "-fno-exceptions" ],
-      "cflags_cc!": [ "-fno-exceptions" ],
+      "dependencies": [ "window_core" ],
       "conditions":[
         ["OS=='win'", {
       	  "sources": [ "lib/windows.cc" ],
@@ -14,7 +61,15 @@
           "libraries": [ '-framework AppKit', '-framework ApplicationServices' ]
       	}],
         ["OS=='linux'", {
-          "sources": [ "lib/linux.cpp" ]
+          "sources": [ "lib/linux.cpp" ],
+          "conditions": [
+            ["linux_backend=='xcb'", {
+              "defines": [ "WM_BACKEND_XCB" ],
+              "libraries": [ "-lxcb", "-lxcb-randr" ]
+            }, {
+              "libraries": [ "-lX11", "-lX11-xcb", "-lxcb", "-lxcb-randr" ]
+            }]
+          ]
         }]
       ],
       "include_dirs": [
@@ -22,5 +77,45 @@
       ],
       'defines': [ 'NAPI_DISABLE_CPP_EXCEPTIONS' ],
     }
+  ],
+  "conditions": [
+    ["core_tests=='true'", {
+      "targets": [
+        {
+          "target_name": "core_test",
+          "type": "executable",
+          "dependencies": [ "window_core" ],
+          "sources": [ "test/core/core_test.cc" ]
+        },
+        {
+          "target_name": "core_bench",
+          "type": "executable",
+          "dependencies": [ "window_core" ],
+          "sources": [ "test/core/core_bench.cc" ]
+        }
+      ]
+    }],
+    ["e2e_bench=='true' and OS=='linux'", {
+      "targets": [
+        {
+          "target_name": "stub_wm",
+          "type": "executable",
+          "sources": [ "test/e2e/stub_wm.cc" ],
+          "libraries": [ "-lxcb" ]
+        },
+        {
+          "target_name": "spawn_windows",
+          "type": "executable",
+          "sources": [ "test/e2e/spawn_windows.cc" ],
+          "libraries": [ "-lxcb" ]
+        },
+        {
+          "target_name": "baseline_calls",
+          "type": "executable",
+          "sources": [ "test/e2e/baseline_calls.cc" ],
+          "libraries": [ "-lX11" ]
+        }
+      ]
+    }]
   ]
 }
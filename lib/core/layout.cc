@@ -0,0 +1,46 @@
+#include "layout.h"
+
+#include <unordered_map>
+
+namespace wm {
+
+std::vector<LayoutChange> coalesceLayoutChanges (const std::vector<LayoutChange>& changes,
+                                                 std::vector<uint32_t>& slots) {
+    // Last occurrence of every window decides its position in the batch
+    std::unordered_map<int64_t, uint32_t> last;
+    for (uint32_t i = 0; i < changes.size (); ++i) last[changes[i].id] = i;
+
+    std::unordered_map<int64_t, uint32_t> slotOf;
+    std::vector<LayoutChange> merged;
+    merged.reserve (last.size ());
+    for (uint32_t i = 0; i < changes.size (); ++i) {
+        if (last[changes[i].id] != i) continue;
+        slotOf[changes[i].id] = static_cast<uint32_t> (merged.size ());
+        merged.push_back ({ changes[i].id, Rect{}, 0, LAYOUT_KEEP, false });
+    }
+
+    slots.resize (changes.size ());
+    for (uint32_t i = 0; i < changes.size (); ++i) {
+        const LayoutChange& change = changes[i];
+        uint32_t slot = slotOf[change.id];
+        LayoutChange& target = merged[slot];
+        slots[i] = slot;
+
+        target.bounds = resolveLayoutBounds (target.bounds, change);
+        target.boundsFields |= change.boundsFields;
+        if (change.visibility != LAYOUT_KEEP) target.visibility = change.visibility;
+        target.raise = target.raise || change.raise;
+    }
+    return merged;
+}
+
+Rect resolveLayoutBounds (const Rect& current, const LayoutChange& change) {
+    Rect bounds = current;
+    if (change.boundsFields & LAYOUT_X) bounds.x = change.bounds.x;
+    if (change.boundsFields & LAYOUT_Y) bounds.y = change.bounds.y;
+    if (change.boundsFields & LAYOUT_WIDTH) bounds.width = change.bounds.width;
+    if (change.boundsFields & LAYOUT_HEIGHT) bounds.height = change.bounds.height;
+    return bounds;
+}
+
+} // namespace wm
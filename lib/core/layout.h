@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// Bounds properties set by a layout entry; the others keep their value
+enum LayoutBoundsField : unsigned {
+    LAYOUT_X = 1 << 0,
+    LAYOUT_Y = 1 << 1,
+    LAYOUT_WIDTH = 1 << 2,
+    LAYOUT_HEIGHT = 1 << 3,
+    LAYOUT_POSITION = LAYOUT_X | LAYOUT_Y,
+    LAYOUT_SIZE = LAYOUT_WIDTH | LAYOUT_HEIGHT,
+    LAYOUT_BOUNDS = LAYOUT_POSITION | LAYOUT_SIZE
+};
+
+enum LayoutVisibility { LAYOUT_KEEP, LAYOUT_SHOW, LAYOUT_HIDE };
+
+// One entry of applyLayout: bounds in native pixels, as reported by
+// getWindowsSummary
+struct LayoutChange {
+    int64_t id;
+    Rect bounds;
+    unsigned boundsFields;
+    LayoutVisibility visibility;
+    bool raise;
+};
+
+struct LayoutResult {
+    int64_t id;
+    bool ok;
+    std::string error;
+};
+
+// Merges the entries of the same window so each window is touched once per
+// batch (DeferWindowPos rejects duplicates). Later entries win property by
+// property, and a window is placed at its last occurrence, so the last
+// raised window ends up on top. `slots[i]` is the merged index of entry i.
+std::vector<LayoutChange> coalesceLayoutChanges (const std::vector<LayoutChange>& changes,
+                                                 std::vector<uint32_t>& slots);
+
+// `current` with the properties set by `change` replaced
+Rect resolveLayoutBounds (const Rect& current, const LayoutChange& change);
+
+} // namespace wm
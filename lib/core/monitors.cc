@@ -0,0 +1,68 @@
+#include "monitors.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wm {
+
+Rect intersectRects (const Rect& a, const Rect& b) {
+    int x0 = std::max (a.x, b.x);
+    int y0 = std::max (a.y, b.y);
+    int x1 = std::min (a.x + a.width, b.x + b.width);
+    int y1 = std::min (a.y + a.height, b.y + b.height);
+    if (x1 <= x0 || y1 <= y0) return { x0, y0, 0, 0 };
+    return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+int monitorForRect (const std::vector<MonitorRecord>& monitors, const Rect& rect) {
+    int best = -1;
+    int64_t bestArea = 0;
+    for (size_t i = 0; i < monitors.size (); ++i) {
+        Rect overlap = intersectRects (monitors[i].bounds, rect);
+        int64_t area = static_cast<int64_t> (overlap.width) * overlap.height;
+        if (area > bestArea) {
+            best = static_cast<int> (i);
+            bestArea = area;
+        }
+    }
+    if (best >= 0) return best;
+
+    // Squared distance from the center to the nearest point of each monitor
+    int64_t cx = rect.x + rect.width / 2;
+    int64_t cy = rect.y + rect.height / 2;
+    int64_t bestDistance = 0;
+    for (size_t i = 0; i < monitors.size (); ++i) {
+        const Rect& b = monitors[i].bounds;
+        int64_t dx = std::max<int64_t> ({ b.x - cx, 0, cx - (static_cast<int64_t> (b.x) + b.width) });
+        int64_t dy = std::max<int64_t> ({ b.y - cy, 0, cy - (static_cast<int64_t> (b.y) + b.height) });
+        int64_t distance = dx * dx + dy * dy;
+        if (best < 0 || distance < bestDistance) {
+            best = static_cast<int> (i);
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+double scaleFromPhysicalSize (int widthPixels, int widthMillimeters) {
+    if (widthPixels <= 0 || widthMillimeters < 100) return 1;
+    double dpi = widthPixels * 25.4 / widthMillimeters;
+    if (dpi > 600) return 1;
+    return dpi >= 192 ? 2 : 1;
+}
+
+Rect logicalRect (const Rect& physical, double scale) {
+    if (!(scale > 0) || scale == 1) return physical;
+    return { static_cast<int> (std::floor (physical.x / scale)), static_cast<int> (std::floor (physical.y / scale)),
+             static_cast<int> (std::floor (physical.width / scale)),
+             static_cast<int> (std::floor (physical.height / scale)) };
+}
+
+void computeLogicalBounds (std::vector<WindowRecord>& windows, const std::vector<MonitorRecord>& monitors) {
+    for (auto& window : windows) {
+        int monitor = monitorForRect (monitors, window.bounds);
+        window.logicalBounds = logicalRect (window.bounds, monitor < 0 ? 1 : monitors[monitor].scaleFactor);
+    }
+}
+
+} // namespace wm
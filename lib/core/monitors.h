@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// One monitor as reported by getMonitorInfo; `id` is the native handle
+// (HMONITOR, CGDirectDisplayID or RandR monitor name atom).
+struct MonitorRecord {
+    int64_t id;
+    Rect bounds;
+    Rect workArea;
+    bool isPrimary;
+    double scaleFactor;
+};
+
+// Overlap of two rectangles; width and height are 0 if they do not overlap
+Rect intersectRects (const Rect& a, const Rect& b);
+
+// Index of the monitor sharing the largest area with `rect`. A rectangle
+// that is on no monitor belongs to the one nearest to its center, as with
+// MONITOR_DEFAULTTONEAREST. -1 without monitors.
+int monitorForRect (const std::vector<MonitorRecord>& monitors, const Rect& rect);
+
+// Scale factor of a monitor nobody configured one for, from its RandR size
+// in pixels and millimeters. Guessed as GDK does: 2 from 192 dpi on, else
+// 1. Sizes under 100 mm or above 600 dpi are taken as bogus (projectors and
+// TVs often report 16 x 9 mm or nothing) and give 1.
+double scaleFromPhysicalSize (int widthPixels, int widthMillimeters);
+
+// `physical` divided by `scale` and rounded down, as Windows reports
+// coordinates to processes that are not DPI aware
+Rect logicalRect (const Rect& physical, double scale);
+
+// Fills logicalBounds of every window from its bounds and the scale factor
+// of the monitor it is mostly on (see monitorForRect); 1 without monitors.
+void computeLogicalBounds (std::vector<WindowRecord>& windows, const std::vector<MonitorRecord>& monitors);
+
+} // namespace wm
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace wm {
+
+struct ProcessInfo {
+    int64_t pid;
+    // Platform-specific start time; a reused pid gets a different one
+    uint64_t startTime;
+    std::string path;
+    // Executable file name, the last component of `path`
+    std::string name;
+    // Owned by the backend (a process HANDLE, a pidfd, ...), released through
+    // ProcessSource::release
+    intptr_t handle;
+};
+
+struct ProcessCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t expired;
+    size_t size;
+};
+
+// How a backend fills and validates cache entries.
+struct ProcessSource {
+    // Fills startTime, path and handle for a running pid; false if it is gone
+    // or cannot be queried.
+    bool (*load) (int64_t pid, ProcessInfo& info);
+    // True while the process `info` was loaded from still runs under its pid.
+    bool (*alive) (const ProcessInfo& info);
+    // Frees whatever load attached to `info`; may be null.
+    void (*release) (ProcessInfo& info);
+};
+
+inline std::string executableName (const std::string& path) {
+    size_t slash = path.find_last_of ("/\\");
+    return slash == std::string::npos ? path : path.substr (slash + 1);
+}
+
+// Process metadata keyed by pid. Every hit is checked with source.alive, so
+// an entry is dropped as soon as its process exits or the pid is reused;
+// retain() additionally drops processes that no longer own any window.
+// Lookups that never reach retain() (getWindowProcess, initWindow, ...) are
+// bounded by `capacity`: a full cache first drops exited processes, then the
+// least recently used entry, so backend handles never pile up.
+// Thread-safe: shared by the JS thread and the monitor thread.
+class ProcessCache {
+public:
+    static const size_t DEFAULT_CAPACITY = 512;
+
+    explicit ProcessCache (ProcessSource source, size_t capacity = DEFAULT_CAPACITY)
+    : source_ (source), capacity_ (capacity ? capacity : 1) {}
+    ~ProcessCache () { clear (); }
+
+    ProcessCache (const ProcessCache&) = delete;
+    ProcessCache& operator= (const ProcessCache&) = delete;
+
+    // Copies the entry for `pid` into `out`, loading it on a miss. Returns
+    // false if the process is not running or cannot be queried.
+    bool lookup (int64_t pid, ProcessInfo& out) {
+        std::lock_guard<std::mutex> lock (mutex_);
+
+        auto it = entries_.find (pid);
+        if (it != entries_.end ()) {
+            if (source_.alive (it->second.info)) {
+                ++hits_;
+                it->second.lastUsed = ++clock_;
+                out = it->second.info;
+                return true;
+            }
+            ++expired_;
+            releaseEntry (it->second.info);
+            entries_.erase (it);
+        }
+
+        ++misses_;
+        ProcessInfo info{};
+        info.pid = pid;
+        if (!source_.load (pid, info)) return false;
+
+        info.name = executableName (info.path);
+        out = info;
+        if (entries_.size () >= capacity_) makeRoom ();
+        entries_.emplace (pid, Entry{ std::move (info), ++clock_ });
+        return true;
+    }
+
+    // Drops every entry whose pid is not in `livePids`.
+    void retain (const std::unordered_set<int64_t>& livePids) {
+        std::lock_guard<std::mutex> lock (mutex_);
+        for (auto it = entries_.begin (); it != entries_.end ();) {
+            if (livePids.count (it->first)) {
+                ++it;
+                continue;
+            }
+            ++expired_;
+            releaseEntry (it->second.info);
+            it = entries_.erase (it);
+        }
+    }
+
+    void clear () {
+        std::lock_guard<std::mutex> lock (mutex_);
+        for (auto& entry : entries_) releaseEntry (entry.second.info);
+        entries_.clear ();
+    }
+
+    ProcessCacheStats stats () const {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return { hits_, misses_, expired_, entries_.size () };
+    }
+
+    void resetStats () {
+        std::lock_guard<std::mutex> lock (mutex_);
+        hits_ = misses_ = expired_ = 0;
+    }
+
+private:
+    struct Entry {
+        ProcessInfo info;
+        uint64_t lastUsed;
+    };
+
+    void releaseEntry (ProcessInfo& info) {
+        if (source_.release) source_.release (info);
+    }
+
+    // Called with the cache full: drops every exited process, or the least
+    // recently used entry if they all still run.
+    void makeRoom () {
+        auto oldest = entries_.end ();
+        for (auto it = entries_.begin (); it != entries_.end ();) {
+            if (!source_.alive (it->second.info)) {
+                ++expired_;
+                releaseEntry (it->second.info);
+                it = entries_.erase (it);
+                continue;
+            }
+            if (oldest == entries_.end () || it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+            ++it;
+        }
+        if (entries_.size () < capacity_ || oldest == entries_.end ()) return;
+
+        ++expired_;
+        releaseEntry (oldest->second.info);
+        entries_.erase (oldest);
+    }
+
+    mutable std::mutex mutex_;
+    ProcessSource source_;
+    size_t capacity_;
+    std::unordered_map<int64_t, Entry> entries_;
+    uint64_t clock_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t expired_ = 0;
+};
+
+} // namespace wm
@@ -0,0 +1,123 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+
+namespace wm {
+
+static bool contains (const Rect& rect, int x, int y) {
+    return x >= rect.x && y >= rect.y && static_cast<int64_t> (x) < static_cast<int64_t> (rect.x) + rect.width &&
+           static_cast<int64_t> (y) < static_cast<int64_t> (rect.y) + rect.height;
+}
+
+static bool overlaps (const Rect& a, const Rect& b) {
+    return static_cast<int64_t> (a.x) < static_cast<int64_t> (b.x) + b.width &&
+           static_cast<int64_t> (b.x) < static_cast<int64_t> (a.x) + a.width &&
+           static_cast<int64_t> (a.y) < static_cast<int64_t> (b.y) + b.height &&
+           static_cast<int64_t> (b.y) < static_cast<int64_t> (a.y) + a.height;
+}
+
+SpatialIndex::SpatialIndex (std::vector<WindowRecord> windows, int cellSize)
+: cellSize_ (cellSize > 0 ? cellSize : DEFAULT_CELL_SIZE) {
+    windows_.reserve (windows.size ());
+    for (auto& window : windows) {
+        if (window.isVisible && window.bounds.width > 0 && window.bounds.height > 0) {
+            windows_.push_back (std::move (window));
+        }
+    }
+
+    // zOrder -1 (not in the stacking order) sorts below everything else
+    std::stable_sort (windows_.begin (), windows_.end (), [] (const WindowRecord& a, const WindowRecord& b) {
+        unsigned za = static_cast<unsigned> (a.zOrder);
+        unsigned zb = static_cast<unsigned> (b.zOrder);
+        return za < zb;
+    });
+
+    for (uint32_t i = 0; i < windows_.size (); ++i) {
+        const Rect& b = windows_[i].bounds;
+        int x0 = cell (b.x);
+        int y0 = cell (b.y);
+        int x1 = cell (static_cast<int> (std::min<int64_t> (static_cast<int64_t> (b.x) + b.width - 1, INT32_MAX)));
+        int y1 = cell (static_cast<int> (std::min<int64_t> (static_cast<int64_t> (b.y) + b.height - 1, INT32_MAX)));
+
+        int64_t cellCount = (static_cast<int64_t> (x1) - x0 + 1) * (static_cast<int64_t> (y1) - y0 + 1);
+        if (cellCount > MAX_CELLS_PER_WINDOW) {
+            oversized_.push_back (i);
+            continue;
+        }
+
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (int cy = y0; cy <= y1; ++cy) cells_[cellKey (cx, cy)].push_back (i);
+        }
+    }
+}
+
+int SpatialIndex::cell (int coordinate) const {
+    // Floor division, so negative coordinates (monitors left of or above the
+    // primary one) get their own cells
+    int q = coordinate / cellSize_;
+    return (coordinate % cellSize_ < 0) ? q - 1 : q;
+}
+
+const WindowRecord* SpatialIndex::at (int x, int y) const {
+    uint32_t best = UINT32_MAX;
+
+    auto it = cells_.find (cellKey (cell (x), cell (y)));
+    if (it != cells_.end ()) {
+        for (uint32_t i : it->second) {
+            if (contains (windows_[i].bounds, x, y)) {
+                best = i;
+                break;
+            }
+        }
+    }
+
+    for (uint32_t i : oversized_) {
+        if (i >= best) break;
+        if (contains (windows_[i].bounds, x, y)) {
+            best = i;
+            break;
+        }
+    }
+
+    return best != UINT32_MAX ? &windows_[best] : nullptr;
+}
+
+std::vector<const WindowRecord*> SpatialIndex::intersecting (const Rect& rect) const {
+    std::vector<const WindowRecord*> result;
+    if (rect.width <= 0 || rect.height <= 0 || windows_.empty ()) return result;
+
+    std::vector<uint32_t> candidates (oversized_);
+
+    int x0 = cell (rect.x);
+    int y0 = cell (rect.y);
+    int x1 = cell (static_cast<int> (std::min<int64_t> (static_cast<int64_t> (rect.x) + rect.width - 1, INT32_MAX)));
+    int y1 = cell (static_cast<int> (std::min<int64_t> (static_cast<int64_t> (rect.y) + rect.height - 1, INT32_MAX)));
+
+    // A query covering more cells than exist is cheaper as a scan of them all
+    int64_t cellCount = (static_cast<int64_t> (x1) - x0 + 1) * (static_cast<int64_t> (y1) - y0 + 1);
+    if (cellCount > static_cast<int64_t> (cells_.size ())) {
+        for (const auto& entry : cells_) {
+            int cx = static_cast<int32_t> (static_cast<uint64_t> (entry.first) >> 32);
+            int cy = static_cast<int32_t> (static_cast<uint32_t> (entry.first));
+            if (cx < x0 || cx > x1 || cy < y0 || cy > y1) continue;
+            candidates.insert (candidates.end (), entry.second.begin (), entry.second.end ());
+        }
+    } else {
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (int cy = y0; cy <= y1; ++cy) {
+                auto it = cells_.find (cellKey (cx, cy));
+                if (it != cells_.end ()) candidates.insert (candidates.end (), it->second.begin (), it->second.end ());
+            }
+        }
+    }
+
+    std::sort (candidates.begin (), candidates.end ());
+    candidates.erase (std::unique (candidates.begin (), candidates.end ()), candidates.end ());
+
+    for (uint32_t i : candidates) {
+        if (overlaps (windows_[i].bounds, rect)) result.push_back (&windows_[i]);
+    }
+    return result;
+}
+
+} // namespace wm
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// Uniform grid over the rectangles of the visible windows of one snapshot,
+// answering hit-tests and rectangle queries in z-order without touching the
+// window system. Each window is listed in every cell it overlaps, topmost
+// first; windows spanning more than MAX_CELLS_PER_WINDOW cells (bogus or
+// off-screen bounds) are kept in a short list checked by every query.
+class SpatialIndex {
+public:
+    static constexpr int DEFAULT_CELL_SIZE = 256;
+    static constexpr int64_t MAX_CELLS_PER_WINDOW = 4096;
+
+    explicit SpatialIndex (std::vector<WindowRecord> windows, int cellSize = DEFAULT_CELL_SIZE);
+
+    // Topmost visible window containing the point, nullptr if none
+    const WindowRecord* at (int x, int y) const;
+
+    // Visible windows overlapping `rect`, topmost first
+    std::vector<const WindowRecord*> intersecting (const Rect& rect) const;
+
+    size_t size () const {
+        return windows_.size ();
+    }
+
+private:
+    int cell (int coordinate) const;
+    static int64_t cellKey (int cx, int cy) {
+        return static_cast<int64_t> ((static_cast<uint64_t> (static_cast<uint32_t> (cx)) << 32) |
+                                     static_cast<uint32_t> (cy));
+    }
+
+    int cellSize_;
+    // Sorted topmost first, so ascending indices are in z-order
+    std::vector<WindowRecord> windows_;
+    std::unordered_map<int64_t, std::vector<uint32_t>> cells_;
+    std::vector<uint32_t> oversized_;
+};
+
+// The index built from the latest monitor snapshot. Published by the
+// monitor thread and read by queries on the JS thread.
+class SharedSpatialIndex {
+public:
+    std::shared_ptr<const SpatialIndex> get () const {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return current_;
+    }
+
+    void set (std::shared_ptr<const SpatialIndex> index) {
+        std::lock_guard<std::mutex> lock (mutex_);
+        current_ = std::move (index);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const SpatialIndex> current_;
+};
+
+} // namespace wm
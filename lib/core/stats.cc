@@ -0,0 +1,109 @@
+#include "stats.h"
+
+#include <algorithm>
+
+namespace wm {
+
+unsigned LatencyHistogram::bucketFor (uint64_t nanoseconds) {
+    // Below 8ns every value has its own bucket
+    if (nanoseconds < 2 * SUB_BUCKETS) return static_cast<unsigned> (nanoseconds);
+
+    unsigned msb = 63;
+    while (!(nanoseconds >> msb)) --msb;
+    unsigned sub = static_cast<unsigned> (nanoseconds >> (msb - 2)) & (SUB_BUCKETS - 1);
+    return std::min ((msb - 1) * SUB_BUCKETS + sub, BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::bucketStart (unsigned bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    unsigned msb = bucket / SUB_BUCKETS + 1;
+    return static_cast<uint64_t> (SUB_BUCKETS + bucket % SUB_BUCKETS) << (msb - 2);
+}
+
+void LatencyHistogram::record (uint64_t nanoseconds) {
+    count_.fetch_add (1, std::memory_order_relaxed);
+    total_.fetch_add (nanoseconds, std::memory_order_relaxed);
+    buckets_[bucketFor (nanoseconds)].fetch_add (1, std::memory_order_relaxed);
+
+    uint64_t max = max_.load (std::memory_order_relaxed);
+    while (nanoseconds > max && !max_.compare_exchange_weak (max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+LatencySnapshot LatencyHistogram::snapshot () const {
+    LatencySnapshot result{};
+    uint64_t counts[BUCKETS];
+    uint64_t count = 0;
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+        counts[i] = buckets_[i].load (std::memory_order_relaxed);
+        count += counts[i];
+    }
+    if (count == 0) return result;
+
+    double max = static_cast<double> (max_.load (std::memory_order_relaxed));
+    result.count = count;
+    result.meanUs = static_cast<double> (total_.load (std::memory_order_relaxed)) / count / 1000;
+    result.maxUs = max / 1000;
+
+    // Middle of the bucket holding the sample of rank ceil(p * count)
+    auto percentile = [&] (double p) {
+        uint64_t rank = std::max<uint64_t> (1, static_cast<uint64_t> (p * count + 0.999999));
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen < rank) continue;
+            double start = static_cast<double> (bucketStart (i));
+            double end = i + 1 < BUCKETS ? static_cast<double> (bucketStart (i + 1)) - 1 : start;
+            return std::min ((start + end) / 2, max) / 1000;
+        }
+        return max / 1000;
+    };
+    result.p50Us = percentile (0.50);
+    result.p95Us = percentile (0.95);
+    result.p99Us = percentile (0.99);
+    return result;
+}
+
+void LatencyHistogram::reset () {
+    count_.store (0, std::memory_order_relaxed);
+    total_.store (0, std::memory_order_relaxed);
+    max_.store (0, std::memory_order_relaxed);
+    for (auto& bucket : buckets_) bucket.store (0, std::memory_order_relaxed);
+}
+
+ExportStats* Stats::exportStats (const std::string& name) {
+    std::lock_guard<std::mutex> lock (mutex_);
+    for (const auto& entry : exports_) {
+        if (entry->name == name) return entry.get ();
+    }
+    exports_.emplace_back (new ExportStats (name));
+    return exports_.back ().get ();
+}
+
+std::vector<const ExportStats*> Stats::exports () const {
+    std::lock_guard<std::mutex> lock (mutex_);
+    std::vector<const ExportStats*> result;
+    result.reserve (exports_.size ());
+    for (const auto& entry : exports_) result.push_back (entry.get ());
+    return result;
+}
+
+void Stats::reset () {
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        for (auto& entry : exports_) {
+            entry->calls.store (0, std::memory_order_relaxed);
+            entry->latency.reset ();
+        }
+    }
+    for (auto& counter : counters_) counter.store (0, std::memory_order_relaxed);
+    for (auto& timer : timers_) timer.reset ();
+}
+
+Stats& stats () {
+    // Never destroyed: the monitor threads may still record during exit
+    static Stats* instance = new Stats ();
+    return *instance;
+}
+
+} // namespace wm
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wm {
+
+struct LatencySnapshot {
+    uint64_t count;
+    double meanUs;
+    double p50Us;
+    double p95Us;
+    double p99Us;
+    double maxUs;
+};
+
+// Lock-free latency histogram. Buckets are log-linear in nanoseconds: four
+// per power of two, so a percentile is off by at most 12.5% of its value.
+// record() is a handful of relaxed atomic adds; readers may see a sample
+// half-recorded, which is fine for monitoring.
+class LatencyHistogram {
+public:
+    static const unsigned SUB_BUCKETS = 4;
+    static const unsigned BUCKETS = 44 * SUB_BUCKETS;
+
+    LatencyHistogram () { reset (); }
+
+    LatencyHistogram (const LatencyHistogram&) = delete;
+    LatencyHistogram& operator= (const LatencyHistogram&) = delete;
+
+    void record (uint64_t nanoseconds);
+    LatencySnapshot snapshot () const;
+    void reset ();
+
+    // Bucket holding `nanoseconds` and the smallest value of a bucket
+    static unsigned bucketFor (uint64_t nanoseconds);
+    static uint64_t bucketStart (unsigned bucket);
+
+private:
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> total_;
+    std::atomic<uint64_t> max_;
+    std::atomic<uint64_t> buckets_[BUCKETS];
+};
+
+// Event counters reported by getStats(). What a native call is depends on
+// the backend: an X reply or request check on Linux, a Win32 or Core
+// Graphics query elsewhere.
+enum StatCounter {
+    STAT_NATIVE_CALLS,
+    // Everything the monitor was woken up for
+    STAT_MONITOR_EVENTS,
+    // Events that call for a new snapshot; the throttle merges most of them
+    STAT_MONITOR_RELEVANT_EVENTS,
+    // Snapshots taken, and those that had nothing to deliver
+    STAT_MONITOR_REFRESHES,
+    STAT_MONITOR_UNCHANGED,
+    // Updates delivered to JS, folded into a pending one while JS was busy,
+    // and dropped because monitoring stopped or the queue refused them
+    STAT_MONITOR_DISPATCHED,
+    STAT_MONITOR_MERGED,
+    STAT_MONITOR_DROPPED,
+    STAT_COUNTER_COUNT
+};
+
+// Where the time of a summary goes: collecting records off the JS thread,
+// turning them into JS values, and the monitor callbacks themselves.
+enum StatTimer { TIMER_COLLECT, TIMER_MARSHAL, TIMER_CALLBACK, TIMER_COUNT };
+
+struct ExportStats {
+    explicit ExportStats (std::string exportName) : name (std::move (exportName)), calls (0) {}
+
+    const std::string name;
+    std::atomic<uint64_t> calls;
+    LatencyHistogram latency;
+};
+
+// Process-wide instrumentation. Counters and histograms are atomics, so
+// recording never locks; only registering an export does.
+class Stats {
+public:
+    // Entry for the export `name`, created on first use. The pointer stays
+    // valid for the lifetime of the process.
+    ExportStats* exportStats (const std::string& name);
+    std::vector<const ExportStats*> exports () const;
+
+    void add (StatCounter counter, uint64_t amount = 1) {
+        counters_[counter].fetch_add (amount, std::memory_order_relaxed);
+    }
+    uint64_t counter (StatCounter counter) const {
+        return counters_[counter].load (std::memory_order_relaxed);
+    }
+
+    LatencyHistogram& timer (StatTimer timer) {
+        return timers_[timer];
+    }
+    const LatencyHistogram& timer (StatTimer timer) const {
+        return timers_[timer];
+    }
+
+    // Zeroes everything; registered exports stay registered
+    void reset ();
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ExportStats>> exports_;
+    std::atomic<uint64_t> counters_[STAT_COUNTER_COUNT] = {};
+    LatencyHistogram timers_[TIMER_COUNT];
+};
+
+Stats& stats ();
+
+// Records the lifetime of the scope into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer (LatencyHistogram& histogram)
+    : histogram_ (histogram), start_ (std::chrono::steady_clock::now ()) {}
+    explicit ScopedTimer (StatTimer timer) : ScopedTimer (stats ().timer (timer)) {}
+
+    ~ScopedTimer () {
+        auto elapsed = std::chrono::steady_clock::now () - start_;
+        histogram_.record (std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ());
+    }
+
+    ScopedTimer (const ScopedTimer&) = delete;
+    ScopedTimer& operator= (const ScopedTimer&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace wm
@@ -0,0 +1,63 @@
+#include "summary_fields.h"
+
+#include "window_filter.h"
+
+namespace wm {
+
+unsigned summaryFieldFromName (const std::string& name) {
+    static const struct {
+        const char* name;
+        SummaryField field;
+    } FIELDS[] = {
+        { "id", SUMMARY_ID },
+        { "title", SUMMARY_TITLE },
+        { "path", SUMMARY_PATH },
+        { "processId", SUMMARY_PROCESS_ID },
+        { "bounds", SUMMARY_BOUNDS },
+        { "zOrder", SUMMARY_Z_ORDER },
+        { "isVisible", SUMMARY_IS_VISIBLE },
+        { "visibleFraction", SUMMARY_VISIBLE_FRACTION },
+        { "visibleRects", SUMMARY_VISIBLE_RECTS },
+        { "logicalBounds", SUMMARY_LOGICAL_BOUNDS },
+    };
+
+    for (const auto& entry : FIELDS) {
+        if (name == entry.name) return entry.field;
+    }
+    return 0;
+}
+
+unsigned summaryFieldsToCollect (unsigned requested, unsigned filterFields) {
+    unsigned fields = requested;
+    if (filterFields & FILTER_PID) fields |= SUMMARY_PROCESS_ID;
+    if (filterFields & FILTER_BOUNDS) fields |= SUMMARY_BOUNDS;
+    if (filterFields & FILTER_TITLE) fields |= SUMMARY_TITLE;
+    if (filterFields & FILTER_PATH) fields |= SUMMARY_PATH;
+
+    // The executable path is looked up by pid
+    if (fields & SUMMARY_PATH) fields |= SUMMARY_PROCESS_ID;
+    // Occlusion is worked out from the geometry and stacking of all windows
+    if (fields & SUMMARY_VISIBLE_REGION) fields |= SUMMARY_BOUNDS | SUMMARY_Z_ORDER | SUMMARY_IS_VISIBLE;
+    if (fields & SUMMARY_LOGICAL_BOUNDS) fields |= SUMMARY_BOUNDS;
+    return fields;
+}
+
+void projectWindowRecords (std::vector<WindowRecord>& windows, unsigned fields) {
+    // Visible-region fields are only computed on request, and then both
+    if ((fields & SUMMARY_ALL) == SUMMARY_ALL && (fields & SUMMARY_VISIBLE_REGION) != SUMMARY_VISIBLE_FRACTION) {
+        return;
+    }
+
+    for (auto& window : windows) {
+        if (!(fields & SUMMARY_ID)) window.id = 0;
+        if (!(fields & SUMMARY_TITLE)) std::string ().swap (window.title);
+        if (!(fields & SUMMARY_PATH)) std::string ().swap (window.path);
+        if (!(fields & SUMMARY_PROCESS_ID)) window.processId = 0;
+        if (!(fields & SUMMARY_BOUNDS)) window.bounds = Rect{};
+        if (!(fields & SUMMARY_Z_ORDER)) window.zOrder = 0;
+        if (!(fields & SUMMARY_IS_VISIBLE)) window.isVisible = false;
+        if (!(fields & SUMMARY_VISIBLE_RECTS)) std::vector<Rect> ().swap (window.visibleRects);
+    }
+}
+
+} // namespace wm
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// WindowRecord fields requested through getWindowsSummary({ fields }).
+// Backends skip the queries behind the fields nobody asked for. SUMMARY_ALL
+// is what a call without fields returns; the visible-region fields are
+// computed from every window of the snapshot and only on request, as are
+// the logical bounds.
+enum SummaryField : unsigned {
+    SUMMARY_ID = 1 << 0,
+    SUMMARY_TITLE = 1 << 1,
+    SUMMARY_PATH = 1 << 2,
+    SUMMARY_PROCESS_ID = 1 << 3,
+    SUMMARY_BOUNDS = 1 << 4,
+    SUMMARY_Z_ORDER = 1 << 5,
+    SUMMARY_IS_VISIBLE = 1 << 6,
+    SUMMARY_ALL = (1 << 7) - 1,
+    SUMMARY_VISIBLE_FRACTION = 1 << 7,
+    SUMMARY_VISIBLE_RECTS = 1 << 8,
+    SUMMARY_VISIBLE_REGION = SUMMARY_VISIBLE_FRACTION | SUMMARY_VISIBLE_RECTS,
+    SUMMARY_LOGICAL_BOUNDS = 1 << 9
+};
+
+// Bit for a JS property name ("id", "title", ..., "isVisible"), 0 if unknown
+unsigned summaryFieldFromName (const std::string& name);
+
+// Fields a backend has to collect: the requested ones plus those the active
+// filter rules read (`filterFields` is WindowFilter::fields ()).
+unsigned summaryFieldsToCollect (unsigned requested, unsigned filterFields);
+
+// Resets the fields not in `fields`, so values that were only collected for
+// filtering do not leak into the result.
+void projectWindowRecords (std::vector<WindowRecord>& windows, unsigned fields);
+
+} // namespace wm
@@ -0,0 +1,101 @@
+#include "tiling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace wm {
+
+namespace {
+
+// Start and length of part `index` of `parts` along [start, start + length)
+// with `gap` between consecutive parts
+void splitSpan (int start, int length, int gap, int parts, int index, int& partStart, int& partLength) {
+    int64_t available = std::max<int64_t> (static_cast<int64_t> (length) - static_cast<int64_t> (gap) * (parts - 1), 0);
+    int64_t begin = available * index / parts;
+    int64_t end = available * (index + 1) / parts;
+    partStart = start + static_cast<int> (begin) + gap * index;
+    partLength = static_cast<int> (end - begin);
+}
+
+Rect cell (const Rect& area, int gap, int columns, int column, int rows, int row) {
+    Rect r{};
+    splitSpan (area.x, area.width, gap, columns, column, r.x, r.width);
+    splitSpan (area.y, area.height, gap, rows, row, r.y, r.height);
+    return r;
+}
+
+Rect undecorate (const Rect& tile, const Insets& decoration) {
+    Rect r{ tile.x + decoration.left, tile.y + decoration.top,
+            tile.width - decoration.left - decoration.right,
+            tile.height - decoration.top - decoration.bottom };
+    r.width = std::max (r.width, 1);
+    r.height = std::max (r.height, 1);
+    return r;
+}
+
+} // namespace
+
+std::vector<Rect> tileArea (const TilingSpec& spec, const Rect& area, size_t count) {
+    std::vector<Rect> tiles;
+    if (count == 0) return tiles;
+    tiles.reserve (count);
+
+    Rect inner{ area.x + spec.outerGap, area.y + spec.outerGap,
+                std::max (area.width - 2 * spec.outerGap, 0),
+                std::max (area.height - 2 * spec.outerGap, 0) };
+    int n = static_cast<int> (count);
+
+    switch (spec.mode) {
+    case TILING_COLUMNS:
+        for (int i = 0; i < n; ++i) tiles.push_back (cell (inner, spec.gap, n, i, 1, 0));
+        break;
+
+    case TILING_GRID: {
+        int columns = spec.columns > 0 ? std::min (spec.columns, n)
+                                       : static_cast<int> (std::ceil (std::sqrt (static_cast<double> (n))));
+        int rows = (n + columns - 1) / columns;
+        for (int i = 0; i < n; ++i) {
+            int row = i / columns;
+            // The last row may be short; its tiles share the full width
+            int inRow = row == rows - 1 ? n - row * columns : columns;
+            tiles.push_back (cell (inner, spec.gap, inRow, i % columns, rows, row));
+        }
+        break;
+    }
+
+    case TILING_MASTER_STACK: {
+        int masters = std::max (std::min (spec.masterCount, n), 1);
+        int stacked = n - masters;
+        Rect master = inner;
+        Rect stack{};
+        if (stacked > 0) {
+            double ratio = std::min (std::max (spec.masterRatio, 0.05), 0.95);
+            int available = std::max (inner.width - spec.gap, 0);
+            master.width = static_cast<int> (std::lround (available * ratio));
+            stack = { inner.x + master.width + spec.gap, inner.y, available - master.width, inner.height };
+        }
+        for (int i = 0; i < masters; ++i) tiles.push_back (cell (master, spec.gap, 1, 0, masters, i));
+        for (int i = 0; i < stacked; ++i) tiles.push_back (cell (stack, spec.gap, 1, 0, stacked, i));
+        break;
+    }
+    }
+
+    for (Rect& tile : tiles) tile = undecorate (tile, spec.decoration);
+    return tiles;
+}
+
+std::vector<Rect> computeTiling (const TilingSpec& spec, const std::vector<Rect>& areas, size_t count) {
+    std::vector<Rect> tiles;
+    if (areas.empty ()) return tiles;
+    tiles.reserve (count);
+
+    for (size_t i = 0; i < areas.size (); ++i) {
+        size_t share = count / areas.size () + (i < count % areas.size () ? 1 : 0);
+        std::vector<Rect> area = tileArea (spec, areas[i], share);
+        tiles.insert (tiles.end (), area.begin (), area.end ());
+    }
+    return tiles;
+}
+
+} // namespace wm
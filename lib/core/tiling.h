@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+enum TilingMode { TILING_GRID, TILING_MASTER_STACK, TILING_COLUMNS };
+
+// Space the window system adds around the rectangle a window is moved to:
+// the frame of a reparenting X window manager, or the invisible resize
+// borders included in a Win32 window rectangle (negative insets).
+struct Insets {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+struct TilingSpec {
+    TilingMode mode;
+    // Between two tiles, and between the tiles and the work-area edges
+    int gap;
+    int outerGap;
+    Insets decoration;
+    // Master-stack: share of the width taken by the master column and the
+    // number of windows stacked in it
+    double masterRatio;
+    int masterCount;
+    // Grid: fixed column count, 0 picks the smallest square grid
+    int columns;
+};
+
+// Rectangles for `count` windows inside `area`, in window order. Tiles of a
+// row or column split the length left after the gaps to the pixel, and are
+// shrunk by the decoration insets so that the decorated windows fill exactly
+// the tile.
+std::vector<Rect> tileArea (const TilingSpec& spec, const Rect& area, size_t count);
+
+// Spreads `count` windows over the work areas in order, as evenly as
+// possible (earlier areas take the extra windows), and tiles each area.
+std::vector<Rect> computeTiling (const TilingSpec& spec, const std::vector<Rect>& areas, size_t count);
+
+} // namespace wm
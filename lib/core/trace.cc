@@ -0,0 +1,229 @@
+#include "trace.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace wm {
+
+TraceBuffer::TraceBuffer (size_t capacity)
+: capacity_ (capacity ? capacity : 1), slots_ (new Slot[capacity_]), head_ (0) {
+    for (size_t i = 0; i < capacity_; ++i) slots_[i].sequence.store (0, std::memory_order_relaxed);
+}
+
+void TraceBuffer::record (const TraceEvent& event) {
+    uint64_t index = head_.fetch_add (1, std::memory_order_relaxed);
+    Slot& slot = slots_[index % capacity_];
+
+    slot.sequence.store (2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    slot.name.store (event.name, std::memory_order_relaxed);
+    slot.phase.store (event.phase, std::memory_order_relaxed);
+    slot.timestamp.store (event.timestamp, std::memory_order_relaxed);
+    slot.duration.store (event.duration, std::memory_order_relaxed);
+    slot.id.store (event.id, std::memory_order_relaxed);
+    slot.thread.store (event.thread, std::memory_order_relaxed);
+    slot.argName.store (event.argName, std::memory_order_relaxed);
+    slot.argValue.store (event.argValue, std::memory_order_relaxed);
+    slot.sequence.store (2 * index + 2, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceBuffer::events () const {
+    uint64_t head = head_.load (std::memory_order_acquire);
+    uint64_t first = head > capacity_ ? head - capacity_ : 0;
+
+    std::vector<TraceEvent> result;
+    result.reserve (head - first);
+    for (uint64_t index = first; index < head; ++index) {
+        const Slot& slot = slots_[index % capacity_];
+        uint64_t published = 2 * index + 2;
+        if (slot.sequence.load (std::memory_order_acquire) != published) continue;
+
+        TraceEvent event;
+        event.name = slot.name.load (std::memory_order_relaxed);
+        event.phase = static_cast<TracePhase> (slot.phase.load (std::memory_order_relaxed));
+        event.timestamp = slot.timestamp.load (std::memory_order_relaxed);
+        event.duration = slot.duration.load (std::memory_order_relaxed);
+        event.id = slot.id.load (std::memory_order_relaxed);
+        event.thread = slot.thread.load (std::memory_order_relaxed);
+        event.argName = slot.argName.load (std::memory_order_relaxed);
+        event.argValue = slot.argValue.load (std::memory_order_relaxed);
+
+        // A writer that lapped the ring meanwhile invalidates the copy
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (slot.sequence.load (std::memory_order_relaxed) != published) continue;
+        result.push_back (event);
+    }
+    return result;
+}
+
+uint64_t TraceBuffer::overwritten () const {
+    uint64_t head = head_.load (std::memory_order_relaxed);
+    return head > capacity_ ? head - capacity_ : 0;
+}
+
+void TraceBuffer::clear () {
+    // Old slots carry sequence numbers of indices that are no longer read
+    head_.store (0, std::memory_order_relaxed);
+    for (size_t i = 0; i < capacity_; ++i) slots_[i].sequence.store (0, std::memory_order_relaxed);
+}
+
+void Tracer::start (size_t capacity) {
+    std::lock_guard<std::mutex> lock (mutex_);
+    TraceBuffer* buffer = buffer_.load (std::memory_order_relaxed);
+    if (!buffer || buffer->capacity () != capacity) {
+        buffers_.emplace_back (new TraceBuffer (capacity));
+        buffer = buffers_.back ().get ();
+    } else {
+        buffer->clear ();
+    }
+    buffer_.store (buffer, std::memory_order_release);
+    enabled_.store (true, std::memory_order_relaxed);
+}
+
+void Tracer::stop () {
+    enabled_.store (false, std::memory_order_relaxed);
+}
+
+void Tracer::record (const TraceEvent& event) {
+    if (!enabled ()) return;
+    TraceBuffer* buffer = buffer_.load (std::memory_order_acquire);
+    if (buffer) buffer->record (event);
+}
+
+uint32_t Tracer::currentThread () {
+    static std::atomic<uint32_t> next{ 1 };
+    thread_local uint32_t thread = next.fetch_add (1, std::memory_order_relaxed);
+    return thread;
+}
+
+void Tracer::nameThread (const char* name) {
+    uint32_t thread = currentThread ();
+    std::lock_guard<std::mutex> lock (mutex_);
+    for (auto& entry : threadNames_) {
+        if (entry.first == thread) {
+            entry.second = name;
+            return;
+        }
+    }
+    threadNames_.emplace_back (thread, name);
+}
+
+namespace {
+
+// Names are literals from this library, but keep the output valid JSON
+void appendString (std::string& out, const char* value) {
+    out += '"';
+    for (const char* c = value; *c; ++c) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        if (static_cast<unsigned char> (*c) >= 0x20) out += *c;
+    }
+    out += '"';
+}
+
+void appendMicroseconds (std::string& out, uint64_t nanoseconds) {
+    char buffer[32];
+    snprintf (buffer, sizeof buffer, "%" PRIu64 ".%03u", nanoseconds / 1000,
+              static_cast<unsigned> (nanoseconds % 1000));
+    out += buffer;
+}
+
+} // namespace
+
+std::string Tracer::json () const {
+    std::vector<TraceEvent> events;
+    uint64_t overwritten = 0;
+    std::vector<std::pair<uint32_t, std::string>> threadNames;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        TraceBuffer* buffer = buffer_.load (std::memory_order_acquire);
+        if (buffer) {
+            events = buffer->events ();
+            overwritten = buffer->overwritten ();
+        }
+        threadNames = threadNames_;
+    }
+
+    std::string out = "{\"traceEvents\":[";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"node-window-manager\"}}";
+    for (const auto& entry : threadNames) {
+        out += ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string (entry.first);
+        out += ",\"args\":{\"name\":";
+        appendString (out, entry.second.c_str ());
+        out += "}}";
+    }
+
+    for (const TraceEvent& event : events) {
+        out += ",{\"name\":";
+        appendString (out, event.name);
+        out += ",\"cat\":\"wm\",\"ph\":\"";
+        out += static_cast<char> (event.phase);
+        out += "\",\"pid\":1,\"tid\":" + std::to_string (event.thread) + ",\"ts\":";
+        appendMicroseconds (out, event.timestamp);
+
+        switch (event.phase) {
+        case TRACE_COMPLETE:
+            out += ",\"dur\":";
+            appendMicroseconds (out, event.duration);
+            break;
+        case TRACE_INSTANT:
+            out += ",\"s\":\"t\"";
+            break;
+        case TRACE_ASYNC_BEGIN:
+        case TRACE_ASYNC_END:
+            out += ",\"id\":\"" + std::to_string (event.id) + "\"";
+            break;
+        }
+
+        out += ",\"args\":{";
+        bool first = true;
+        if (event.id) {
+            out += "\"update\":" + std::to_string (event.id);
+            first = false;
+        }
+        if (event.argName) {
+            if (!first) out += ',';
+            appendString (out, event.argName);
+            out += ':' + std::to_string (event.argValue);
+        }
+        out += "}}";
+    }
+
+    out += "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":" + std::to_string (overwritten) + "}}";
+    return out;
+}
+
+Tracer& tracer () {
+    // Never destroyed: the monitor threads may still record during exit
+    static Tracer* instance = new Tracer ();
+    return *instance;
+}
+
+uint64_t traceNow () {
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+           std::chrono::steady_clock::now ().time_since_epoch ())
+    .count ();
+}
+
+void traceInstant (const char* name, uint64_t id, const char* argName, int64_t argValue) {
+    Tracer& t = tracer ();
+    if (!t.enabled ()) return;
+    t.record ({ name, TRACE_INSTANT, traceNow (), 0, id, Tracer::currentThread (), argName, argValue });
+}
+
+void traceAsync (const char* name, uint64_t id, uint64_t begin, uint64_t end) {
+    Tracer& t = tracer ();
+    if (!t.enabled ()) return;
+    uint32_t thread = Tracer::currentThread ();
+    t.record ({ name, TRACE_ASYNC_BEGIN, begin, 0, id, thread, nullptr, 0 });
+    t.record ({ name, TRACE_ASYNC_END, end, 0, id, thread, "latencyUs", static_cast<int64_t> ((end - begin) / 1000) });
+}
+
+TraceScope::~TraceScope () {
+    if (!start_) return;
+    Tracer& t = tracer ();
+    uint64_t end = traceNow ();
+    t.record ({ name_, TRACE_COMPLETE, start_, end - start_, id_, Tracer::currentThread (), nullptr, 0 });
+}
+
+} // namespace wm
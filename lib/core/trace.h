@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wm {
+
+// Chrome trace_event phases used by the monitors
+enum TracePhase : char {
+    TRACE_COMPLETE = 'X',
+    TRACE_INSTANT = 'i',
+    TRACE_ASYNC_BEGIN = 'b',
+    TRACE_ASYNC_END = 'e'
+};
+
+// `name` and `argName` must be string literals: only the pointers are kept.
+struct TraceEvent {
+    const char* name;
+    TracePhase phase;
+    // steady_clock nanoseconds, the clock process.hrtime() reads on Linux
+    uint64_t timestamp;
+    uint64_t duration;
+    // Monitor update the event belongs to; 0 for none
+    uint64_t id;
+    uint32_t thread;
+    const char* argName;
+    int64_t argValue;
+};
+
+// Fixed-size multi-producer ring. A writer claims a slot with one atomic
+// increment and publishes it through the slot's sequence number, so
+// recording never blocks; once full, the oldest events are overwritten.
+class TraceBuffer {
+public:
+    explicit TraceBuffer (size_t capacity);
+
+    TraceBuffer (const TraceBuffer&) = delete;
+    TraceBuffer& operator= (const TraceBuffer&) = delete;
+
+    size_t capacity () const {
+        return capacity_;
+    }
+
+    void record (const TraceEvent& event);
+    // Oldest first; slots still being written are skipped
+    std::vector<TraceEvent> events () const;
+    // Events lost to wrap-around since the last clear
+    uint64_t overwritten () const;
+    void clear ();
+
+private:
+    struct Slot {
+        // 2 * index + 1 while being written, 2 * index + 2 once published
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char*> name;
+        std::atomic<char> phase;
+        std::atomic<uint64_t> timestamp;
+        std::atomic<uint64_t> duration;
+        std::atomic<uint64_t> id;
+        std::atomic<uint32_t> thread;
+        std::atomic<const char*> argName;
+        std::atomic<int64_t> argValue;
+    };
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_;
+};
+
+// Opt-in process-wide tracer. While stopped, every record call is one
+// relaxed load.
+class Tracer {
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 16;
+
+    bool enabled () const {
+        return enabled_.load (std::memory_order_relaxed);
+    }
+
+    // Starts recording into a cleared buffer of `capacity` events
+    void start (size_t capacity = DEFAULT_CAPACITY);
+    void stop ();
+
+    void record (const TraceEvent& event);
+    // Ids of monitor updates, so the stages of one update can be followed
+    uint64_t nextId () {
+        return nextId_.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    // Small sequential id of the calling thread
+    static uint32_t currentThread ();
+    // Label for the calling thread in the dump
+    void nameThread (const char* name);
+
+    // { traceEvents: [...] } for chrome://tracing or Perfetto
+    std::string json () const;
+
+private:
+    std::atomic<bool> enabled_{ false };
+    std::atomic<uint64_t> nextId_{ 1 };
+    // Buffers are never freed while the process runs, so a writer that
+    // raced with a restart still writes into valid memory
+    std::atomic<TraceBuffer*> buffer_{ nullptr };
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+    std::vector<std::pair<uint32_t, std::string>> threadNames_;
+};
+
+Tracer& tracer ();
+
+uint64_t traceNow ();
+
+void traceInstant (const char* name, uint64_t id = 0, const char* argName = nullptr, int64_t argValue = 0);
+// Async span of update `id`; Chrome draws it on its own track
+void traceAsync (const char* name, uint64_t id, uint64_t begin, uint64_t end);
+
+// Complete event covering the lifetime of the scope
+class TraceScope {
+public:
+    explicit TraceScope (const char* name, uint64_t id = 0)
+    : name_ (name), id_ (id), start_ (tracer ().enabled () ? traceNow () : 0) {}
+    ~TraceScope ();
+
+    TraceScope (const TraceScope&) = delete;
+    TraceScope& operator= (const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t id_;
+    uint64_t start_;
+};
+
+} // namespace wm
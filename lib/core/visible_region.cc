@@ -0,0 +1,226 @@
+#include "visible_region.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wm {
+
+namespace {
+
+typedef std::pair<int, int> Interval;
+
+// Horizontal slab [y0, y1) covered on the sorted, disjoint x-intervals
+struct Band {
+    int y0;
+    int y1;
+    std::vector<Interval> xs;
+};
+
+// y-x banded region, the representation X servers use for clip regions:
+// bands are sorted, disjoint and never empty, and two touching bands never
+// have the same intervals. Every operation is a single sweep over the bands.
+class BandRegion {
+public:
+    // Union of `rects`, by a sweep over their horizontal edges: between two
+    // consecutive edges the covered x-intervals stay the same.
+    static BandRegion fromRects (const std::vector<Rect>& rects) {
+        struct Edge {
+            int y;
+            bool opening;
+            uint32_t index;
+        };
+
+        std::vector<Edge> edges;
+        edges.reserve (rects.size () * 2);
+        for (uint32_t i = 0; i < rects.size (); ++i) {
+            if (rects[i].width <= 0 || rects[i].height <= 0) continue;
+            edges.push_back ({ rects[i].y, true, i });
+            edges.push_back ({ rects[i].y + rects[i].height, false, i });
+        }
+        std::sort (edges.begin (), edges.end (), [] (const Edge& a, const Edge& b) { return a.y < b.y; });
+
+        BandRegion region;
+        std::vector<uint32_t> active;
+        std::vector<Interval> xs;
+        for (size_t e = 0; e < edges.size ();) {
+            int y = edges[e].y;
+            for (; e < edges.size () && edges[e].y == y; ++e) {
+                if (edges[e].opening) {
+                    active.push_back (edges[e].index);
+                } else {
+                    active.erase (std::find (active.begin (), active.end (), edges[e].index));
+                }
+            }
+            if (e == edges.size ()) break;
+
+            xs.clear ();
+            for (uint32_t i : active) xs.emplace_back (rects[i].x, rects[i].x + rects[i].width);
+            std::sort (xs.begin (), xs.end ());
+            region.append ({ y, edges[e].y, mergeIntervals (xs) });
+        }
+        return region;
+    }
+
+    bool empty () const {
+        return bands_.empty ();
+    }
+
+    // Area of the region inside `rect`; the pieces are appended to `out`
+    int64_t intersect (const Rect& rect, std::vector<Rect>* out) const {
+        int64_t area = 0;
+        int rx1 = rect.x + rect.width;
+        int ry1 = rect.y + rect.height;
+        size_t first = out ? out->size () : 0;
+        // Pieces of the previous band, extended while the next band has the
+        // same clipped intervals and touches it
+        size_t runStart = first;
+        std::vector<Interval> clipped, previous;
+        int previousEnd = 0;
+
+        for (auto it = firstBandBelow (rect.y); it != bands_.end () && it->y0 < ry1; ++it) {
+            int y0 = std::max (it->y0, rect.y);
+            int y1 = std::min (it->y1, ry1);
+
+            clipped.clear ();
+            for (const Interval& x : it->xs) {
+                if (x.second <= rect.x) continue;
+                if (x.first >= rx1) break;
+                clipped.emplace_back (std::max (x.first, rect.x), std::min (x.second, rx1));
+                area += static_cast<int64_t> (clipped.back ().second - clipped.back ().first) * (y1 - y0);
+            }
+
+            if (out) {
+                if (!clipped.empty () && clipped == previous && previousEnd == y0) {
+                    for (size_t i = runStart; i < out->size (); ++i) (*out)[i].height += y1 - y0;
+                } else {
+                    runStart = out->size ();
+                    for (const Interval& x : clipped) out->push_back ({ x.first, y0, x.second - x.first, y1 - y0 });
+                }
+            }
+            previous.swap (clipped);
+            previousEnd = y1;
+        }
+        return area;
+    }
+
+    // Removes `rect`: bands crossing its top or bottom edge are split, the
+    // ones in between lose one x-interval
+    void subtract (const Rect& rect) {
+        if (rect.width <= 0 || rect.height <= 0) return;
+        int rx1 = rect.x + rect.width;
+        int ry1 = rect.y + rect.height;
+
+        auto begin = firstBandBelow (rect.y);
+        auto end = begin;
+        while (end != bands_.end () && end->y0 < ry1) ++end;
+        if (begin == end) return;
+
+        std::vector<Band> replaced;
+        replaced.reserve ((end - begin) + 2);
+        for (auto it = begin; it != end; ++it) {
+            if (it->y0 < rect.y) replaced.push_back ({ it->y0, rect.y, it->xs });
+
+            Band middle{ std::max (it->y0, rect.y), std::min (it->y1, ry1), {} };
+            for (const Interval& x : it->xs) {
+                if (x.second <= rect.x || x.first >= rx1) {
+                    middle.xs.push_back (x);
+                    continue;
+                }
+                if (x.first < rect.x) middle.xs.emplace_back (x.first, rect.x);
+                if (x.second > rx1) middle.xs.emplace_back (rx1, x.second);
+            }
+            replaced.push_back (std::move (middle));
+
+            if (it->y1 > ry1) replaced.push_back ({ ry1, it->y1, it->xs });
+        }
+
+        // Re-append the whole tail so touching equal bands get coalesced
+        std::vector<Band> tail (std::make_move_iterator (end), std::make_move_iterator (bands_.end ()));
+        bands_.erase (begin, bands_.end ());
+        for (auto& band : replaced) append (std::move (band));
+        for (auto& band : tail) append (std::move (band));
+    }
+
+private:
+    static std::vector<Interval> mergeIntervals (const std::vector<Interval>& sorted) {
+        std::vector<Interval> merged;
+        for (const Interval& x : sorted) {
+            if (!merged.empty () && x.first <= merged.back ().second) {
+                merged.back ().second = std::max (merged.back ().second, x.second);
+            } else {
+                merged.push_back (x);
+            }
+        }
+        return merged;
+    }
+
+    // Bands must come in increasing y; empty ones are dropped and a band
+    // equal to the touching previous one extends it
+    void append (Band band) {
+        if (band.xs.empty () || band.y1 <= band.y0) return;
+        if (!bands_.empty () && bands_.back ().y1 == band.y0 && bands_.back ().xs == band.xs) {
+            bands_.back ().y1 = band.y1;
+            return;
+        }
+        bands_.push_back (std::move (band));
+    }
+
+    std::vector<Band>::iterator firstBandBelow (int y) {
+        return std::upper_bound (bands_.begin (), bands_.end (), y,
+                                 [] (int value, const Band& band) { return value < band.y1; });
+    }
+
+    std::vector<Band>::const_iterator firstBandBelow (int y) const {
+        return std::upper_bound (bands_.begin (), bands_.end (), y,
+                                 [] (int value, const Band& band) { return value < band.y1; });
+    }
+
+    std::vector<Band> bands_;
+};
+
+} // namespace
+
+int64_t visibleRegion (const Rect& window,
+                       const std::vector<Rect>& occluders,
+                       const std::vector<Rect>& clip,
+                       std::vector<Rect>& visible) {
+    visible.clear ();
+    if (window.width <= 0 || window.height <= 0) return 0;
+
+    BandRegion region = BandRegion::fromRects (clip.empty () ? std::vector<Rect>{ window } : clip);
+    for (const Rect& r : occluders) region.subtract (r);
+    return region.intersect (window, &visible);
+}
+
+void computeVisibleRegions (std::vector<WindowRecord>& windows, const std::vector<Rect>& monitors) {
+    // Topmost first; zOrder -1 (not stacked) goes to the bottom
+    std::vector<uint32_t> order (windows.size ());
+    for (uint32_t i = 0; i < order.size (); ++i) order[i] = i;
+    std::stable_sort (order.begin (), order.end (), [&] (uint32_t a, uint32_t b) {
+        return static_cast<unsigned> (windows[a].zOrder) < static_cast<unsigned> (windows[b].zOrder);
+    });
+
+    // What is still uncovered: the monitors, or without them every window,
+    // minus the windows handled so far. Each window sees exactly that.
+    std::vector<Rect> area = monitors;
+    if (area.empty ()) {
+        for (const auto& window : windows) area.push_back (window.bounds);
+    }
+    BandRegion uncovered = BandRegion::fromRects (area);
+
+    for (uint32_t index : order) {
+        WindowRecord& window = windows[index];
+        window.visibleRects.clear ();
+        window.visibleFraction = 0;
+
+        const Rect& b = window.bounds;
+        if (!window.isVisible || b.width <= 0 || b.height <= 0 || uncovered.empty ()) continue;
+
+        int64_t visibleArea = uncovered.intersect (b, &window.visibleRects);
+        window.visibleFraction = static_cast<double> (visibleArea) / (static_cast<double> (b.width) * b.height);
+
+        if (visibleArea > 0) uncovered.subtract (b);
+    }
+}
+
+} // namespace wm
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// Part of `window` inside the union of `clip` (the monitors; empty means no
+// clipping) and outside the union of `occluders`, as disjoint rectangles.
+// Returns the visible area.
+//
+// Regions are y-x banded: a sweep over the horizontal edges of the clip
+// rectangles builds horizontal bands with sorted x-intervals, and every
+// occluder is subtracted with one more pass over the bands it crosses.
+// Pieces with the same x-extent in touching bands are merged vertically.
+int64_t visibleRegion (const Rect& window,
+                       const std::vector<Rect>& occluders,
+                       const std::vector<Rect>& clip,
+                       std::vector<Rect>& visible);
+
+// Fills visibleFraction and visibleRects of every window from its bounds,
+// zOrder and isVisible. Windows are only covered by visible windows of the
+// same snapshot above them; hidden windows are 0% visible. The uncovered
+// region is carried down the stack, so each window costs one intersection
+// and one subtraction rather than a pass over every window above it.
+void computeVisibleRegions (std::vector<WindowRecord>& windows, const std::vector<Rect>& monitors);
+
+} // namespace wm
@@ -0,0 +1,92 @@
+#include "window_cache.h"
+
+#include <iterator>
+
+namespace wm {
+
+void WindowCache::clear () {
+    entries_.clear ();
+    order_.clear ();
+    frames_.clear ();
+    stacking_ = ZOrderMap ();
+    listDirty_ = true;
+    stackingDirty_ = true;
+}
+
+bool WindowCache::markDirty (int64_t id, unsigned parts) {
+    auto it = entries_.find (id);
+    if (it == entries_.end ()) {
+        auto frame = frames_.find (id);
+        if (frame == frames_.end ()) return false;
+        it = entries_.find (frame->second);
+        if (it == entries_.end ()) return false;
+    }
+    it->second.dirty |= parts;
+    return true;
+}
+
+void WindowCache::markAllDirty (unsigned parts) {
+    for (auto& entry : entries_) entry.second.dirty |= parts;
+}
+
+void WindowCache::setWindows (const std::vector<int64_t>& ids) {
+    std::unordered_map<int64_t, CachedWindow> entries;
+    entries.reserve (ids.size ());
+    for (int64_t id : ids) {
+        auto it = entries_.find (id);
+        if (it != entries_.end ()) {
+            entries.emplace (id, std::move (it->second));
+            continue;
+        }
+        CachedWindow window{};
+        window.record.id = id;
+        window.record.zOrder = stacking_.find (id);
+        window.valid = true;
+        window.dirty = DIRTY_ALL;
+        entries.emplace (id, std::move (window));
+    }
+    entries_.swap (entries);
+    order_ = ids;
+
+    for (auto it = frames_.begin (); it != frames_.end ();) {
+        it = entries_.count (it->second) ? std::next (it) : frames_.erase (it);
+    }
+    listDirty_ = false;
+}
+
+void WindowCache::setStacking (const std::vector<int64_t>& bottomUp) {
+    stacking_ = ZOrderMap::fromBottomUp (bottomUp);
+    for (auto& entry : entries_) entry.second.record.zOrder = stacking_.find (entry.first);
+    stackingDirty_ = false;
+}
+
+std::vector<std::pair<int64_t, unsigned>> WindowCache::takeDirty () {
+    std::vector<std::pair<int64_t, unsigned>> dirty;
+    for (int64_t id : order_) {
+        CachedWindow& window = entries_[id];
+        if (!window.dirty || !window.valid) continue;
+        dirty.emplace_back (id, window.dirty);
+        window.dirty = 0;
+    }
+    return dirty;
+}
+
+CachedWindow* WindowCache::find (int64_t id) {
+    auto it = entries_.find (id);
+    return it != entries_.end () ? &it->second : nullptr;
+}
+
+const CachedWindow* WindowCache::get (int64_t id) const {
+    auto it = entries_.find (id);
+    return it != entries_.end () && it->second.valid ? &it->second : nullptr;
+}
+
+void WindowCache::setFrame (int64_t id, int64_t frame) {
+    CachedWindow* window = find (id);
+    if (!window) return;
+    if (window->frame && window->frame != id) frames_.erase (window->frame);
+    window->frame = frame;
+    if (frame && frame != id) frames_[frame] = id;
+}
+
+} // namespace wm
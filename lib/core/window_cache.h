@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "window_record.h"
+#include "z_order.h"
+
+namespace wm {
+
+// Parts of a cached window that an event can invalidate
+enum WindowDirty : unsigned {
+    DIRTY_GEOMETRY = 1 << 0,
+    DIRTY_TITLE = 1 << 1,
+    // Mapped / hidden state
+    DIRTY_STATE = 1 << 2,
+    DIRTY_PROCESS = 1 << 3,
+    // The top-level ancestor (window manager frame) events arrive for
+    DIRTY_FRAME = 1 << 4,
+    DIRTY_ALL = (1 << 5) - 1
+};
+
+struct CachedWindow {
+    // zOrder is kept current from the stacking list; the rest is fetched
+    WindowRecord record;
+    bool hasTitle;
+    // Mapped and not hidden; isVisible also requires a non-empty size
+    bool shown;
+    // False once a fetch found the window gone
+    bool valid;
+    // Top-level ancestor, the window itself when unparented; 0 if unknown
+    int64_t frame;
+    unsigned dirty;
+};
+
+// Window records keyed by native handle, for monitors that learn from their
+// event stream which windows changed. Events mark single windows dirty
+// (directly or through their frame), the window list or the stacking order;
+// a refresh re-fetches only what is dirty and builds the snapshot from the
+// cache. Not thread-safe; owned by one monitor thread.
+class WindowCache {
+public:
+    WindowCache () {
+        clear ();
+    }
+
+    // Forgets every window; the next refresh fetches everything
+    void clear ();
+
+    bool listDirty () const {
+        return listDirty_;
+    }
+    bool stackingDirty () const {
+        return stackingDirty_;
+    }
+    void markListDirty () {
+        listDirty_ = true;
+    }
+    void markStackingDirty () {
+        stackingDirty_ = true;
+    }
+
+    // Marks `parts` of the window `id`, or of the window whose frame `id`
+    // is. False if `id` is neither, e.g. an override-redirect popup.
+    bool markDirty (int64_t id, unsigned parts);
+    void markAllDirty (unsigned parts);
+
+    // The current window list in order. New windows start fully dirty,
+    // windows no longer listed are dropped.
+    void setWindows (const std::vector<int64_t>& ids);
+    // Stacking list from the bottom up, as _NET_CLIENT_LIST_STACKING
+    void setStacking (const std::vector<int64_t>& bottomUp);
+
+    // Windows with something dirty and what; the bits are cleared
+    std::vector<std::pair<int64_t, unsigned>> takeDirty ();
+
+    CachedWindow* find (int64_t id);
+    void setFrame (int64_t id, int64_t frame);
+
+    // The window list; get() skips the windows found gone
+    const std::vector<int64_t>& order () const {
+        return order_;
+    }
+    const CachedWindow* get (int64_t id) const;
+    size_t size () const {
+        return entries_.size ();
+    }
+
+private:
+    std::unordered_map<int64_t, CachedWindow> entries_;
+    std::vector<int64_t> order_;
+    // Frame -> window
+    std::unordered_map<int64_t, int64_t> frames_;
+    ZOrderMap stacking_;
+    bool listDirty_;
+    bool stackingDirty_;
+};
+
+} // namespace wm
@@ -0,0 +1,65 @@
+#include "window_columns.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace wm {
+
+std::vector<uint8_t> serializeWindowColumns (const std::vector<WindowRecord>& windows) {
+    const size_t count = windows.size ();
+
+    std::vector<int32_t> columns (COLUMN_COUNT * count);
+    std::unordered_map<std::string, int32_t> interned;
+    std::vector<int32_t> offsets{ 0 };
+    std::string blob;
+
+    auto intern = [&] (const std::string& value) {
+        auto it = interned.find (value);
+        if (it != interned.end ()) return it->second;
+
+        int32_t index = static_cast<int32_t> (offsets.size () - 1);
+        interned.emplace (value, index);
+        blob += value;
+        offsets.push_back (static_cast<int32_t> (blob.size ()));
+        return index;
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const WindowRecord& window = windows[i];
+        columns[COLUMN_ID * count + i] = static_cast<int32_t> (static_cast<uint32_t> (window.id));
+        columns[COLUMN_PROCESS_ID * count + i] = static_cast<int32_t> (window.processId);
+        columns[COLUMN_X * count + i] = window.bounds.x;
+        columns[COLUMN_Y * count + i] = window.bounds.y;
+        columns[COLUMN_WIDTH * count + i] = window.bounds.width;
+        columns[COLUMN_HEIGHT * count + i] = window.bounds.height;
+        columns[COLUMN_Z_ORDER * count + i] = window.zOrder;
+        columns[COLUMN_FLAGS * count + i] = window.isVisible ? WINDOW_FLAG_VISIBLE : 0;
+        columns[COLUMN_TITLE * count + i] = intern (window.title);
+        columns[COLUMN_PATH * count + i] = intern (window.path);
+    }
+
+    const int32_t header[WINDOW_COLUMNS_HEADER_WORDS] = {
+        WINDOW_COLUMNS_VERSION,
+        static_cast<int32_t> (count),
+        static_cast<int32_t> (offsets.size () - 1),
+        static_cast<int32_t> (blob.size ()),
+    };
+
+    std::vector<uint8_t> buffer (sizeof (header) + columns.size () * sizeof (int32_t) +
+                                 offsets.size () * sizeof (int32_t) + blob.size ());
+    uint8_t* out = buffer.data ();
+    std::memcpy (out, header, sizeof (header));
+    out += sizeof (header);
+    if (!columns.empty ()) {
+        std::memcpy (out, columns.data (), columns.size () * sizeof (int32_t));
+        out += columns.size () * sizeof (int32_t);
+    }
+    std::memcpy (out, offsets.data (), offsets.size () * sizeof (int32_t));
+    out += offsets.size () * sizeof (int32_t);
+    if (!blob.empty ()) std::memcpy (out, blob.data (), blob.size ());
+
+    return buffer;
+}
+
+} // namespace wm
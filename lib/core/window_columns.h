@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// Struct-of-arrays encoding of a snapshot, read from JS through typed array
+// views over a single ArrayBuffer. Every field is a native-endian 32-bit word
+// except the trailing UTF-8 bytes:
+//
+//   header       [version, count, stringCount, stringBytes]
+//   columns      COLUMN_COUNT × count words, in WindowColumn order
+//   offsets      stringCount + 1 words into the byte blob
+//   bytes        stringBytes of UTF-8 text, every distinct string once
+//
+// Window ids are stored as their low 32 bits (HWNDs, CGWindowIDs and X ids
+// all fit); title and path columns hold indices into the string table.
+enum WindowColumn {
+    COLUMN_ID,
+    COLUMN_PROCESS_ID,
+    COLUMN_X,
+    COLUMN_Y,
+    COLUMN_WIDTH,
+    COLUMN_HEIGHT,
+    COLUMN_Z_ORDER,
+    COLUMN_FLAGS,
+    COLUMN_TITLE,
+    COLUMN_PATH,
+    COLUMN_COUNT
+};
+
+enum WindowFlags : int32_t {
+    WINDOW_FLAG_VISIBLE = 1 << 0
+};
+
+const int32_t WINDOW_COLUMNS_VERSION = 1;
+const size_t WINDOW_COLUMNS_HEADER_WORDS = 4;
+
+// Builds the buffer in one pass; strings shared by several windows (mostly
+// executable paths) are stored once.
+std::vector<uint8_t> serializeWindowColumns (const std::vector<WindowRecord>& windows);
+
+} // namespace wm
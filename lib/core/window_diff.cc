@@ -0,0 +1,111 @@
+#include "window_diff.h"
+
+#include <utility>
+
+namespace wm {
+
+namespace {
+
+// Per-window changes between two states of the same window
+void appendChanges (const WindowRecord& previous, const WindowRecord& current, std::vector<WindowDelta>& deltas) {
+    if (previous.zOrder != current.zOrder) {
+        deltas.push_back ({ current.id, DeltaKind::Reordered, previous, current });
+    }
+    if (previous.bounds.x != current.bounds.x || previous.bounds.y != current.bounds.y) {
+        deltas.push_back ({ current.id, DeltaKind::Moved, previous, current });
+    }
+    if (previous.bounds.width != current.bounds.width || previous.bounds.height != current.bounds.height) {
+        deltas.push_back ({ current.id, DeltaKind::Resized, previous, current });
+    }
+    if (previous.isVisible != current.isVisible) {
+        deltas.push_back ({ current.id, DeltaKind::Visibility, previous, current });
+    }
+    if (previous.title != current.title) {
+        deltas.push_back ({ current.id, DeltaKind::Retitled, previous, current });
+    }
+}
+
+} // namespace
+
+std::vector<WindowDelta> WindowDiffer::update (std::vector<WindowRecord> snapshot) {
+    std::vector<WindowDelta> deltas;
+
+    std::unordered_map<int64_t, size_t> index;
+    index.reserve (snapshot.size ());
+    for (size_t i = 0; i < snapshot.size (); ++i) {
+        index.emplace (snapshot[i].id, i);
+    }
+
+    for (const auto& current : snapshot) {
+        if (!index_.count (current.id)) {
+            deltas.push_back ({ current.id, DeltaKind::Created, WindowRecord{}, current });
+        }
+    }
+
+    for (const auto& previous : previous_) {
+        if (!index.count (previous.id)) {
+            deltas.push_back ({ previous.id, DeltaKind::Destroyed, previous, WindowRecord{} });
+        }
+    }
+
+    for (const auto& current : snapshot) {
+        auto it = index_.find (current.id);
+        if (it == index_.end ()) continue;
+
+        appendChanges (previous_[it->second], current, deltas);
+    }
+
+    previous_ = std::move (snapshot);
+    index_ = std::move (index);
+
+    return deltas;
+}
+
+void mergeWindowDeltas (std::vector<WindowDelta>& older, std::vector<WindowDelta> newer) {
+    if (older.empty ()) {
+        older = std::move (newer);
+        return;
+    }
+    if (newer.empty ()) return;
+
+    // Every delta of one window in one update carries the same before and
+    // after records, so the first and the last delta of a window are enough
+    struct Span {
+        bool existed;
+        bool exists;
+        WindowRecord before;
+        WindowRecord after;
+    };
+    std::vector<int64_t> order;
+    std::unordered_map<int64_t, Span> spans;
+
+    for (std::vector<WindowDelta>* deltas : { &older, &newer }) {
+        for (WindowDelta& delta : *deltas) {
+            auto it = spans.find (delta.id);
+            if (it == spans.end ()) {
+                order.push_back (delta.id);
+                Span span{ delta.kind != DeltaKind::Created, false, std::move (delta.before), WindowRecord{} };
+                it = spans.emplace (delta.id, std::move (span)).first;
+            }
+            it->second.exists = delta.kind != DeltaKind::Destroyed;
+            it->second.after = std::move (delta.after);
+        }
+    }
+
+    std::vector<WindowDelta> merged;
+    for (int64_t id : order) {
+        Span& span = spans[id];
+        if (!span.existed && span.exists) merged.push_back ({ id, DeltaKind::Created, WindowRecord{}, span.after });
+    }
+    for (int64_t id : order) {
+        Span& span = spans[id];
+        if (span.existed && !span.exists) merged.push_back ({ id, DeltaKind::Destroyed, span.before, WindowRecord{} });
+    }
+    for (int64_t id : order) {
+        Span& span = spans[id];
+        if (span.existed && span.exists) appendChanges (span.before, span.after, merged);
+    }
+    older = std::move (merged);
+}
+
+} // namespace wm
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+enum class DeltaKind {
+    Created,
+    Destroyed,
+    Moved,
+    Resized,
+    Reordered,
+    Visibility,
+    Retitled
+};
+
+inline const char* deltaKindName (DeltaKind kind) {
+    switch (kind) {
+    case DeltaKind::Created: return "created";
+    case DeltaKind::Destroyed: return "destroyed";
+    case DeltaKind::Moved: return "moved";
+    case DeltaKind::Resized: return "resized";
+    case DeltaKind::Reordered: return "reordered";
+    case DeltaKind::Visibility: return "visibility";
+    case DeltaKind::Retitled: return "retitled";
+    }
+    return "";
+}
+
+// A single change between two snapshots. `before` is empty for Created and
+// `after` is empty for Destroyed; the kind tells which fields are relevant.
+struct WindowDelta {
+    int64_t id;
+    DeltaKind kind;
+    WindowRecord before;
+    WindowRecord after;
+};
+
+// Keeps the previous snapshot and turns each new one into typed deltas.
+// Not thread-safe; each monitor owns its own instance.
+class WindowDiffer {
+public:
+    // Compares `snapshot` with the previous one and makes it the new baseline.
+    // Deltas are ordered: created, destroyed, then per-window changes in
+    // snapshot order.
+    std::vector<WindowDelta> update (std::vector<WindowRecord> snapshot);
+
+    void reset () {
+        previous_.clear ();
+        index_.clear ();
+    }
+
+    const std::vector<WindowRecord>& snapshot () const {
+        return previous_;
+    }
+
+private:
+    std::vector<WindowRecord> previous_;
+    std::unordered_map<int64_t, size_t> index_;
+};
+
+// Appends `newer` to `older` as if both had been one update: each window
+// ends up with the deltas between its state before `older` and after
+// `newer`, so a window created and destroyed in between disappears and two
+// moves become one. Same order as WindowDiffer::update.
+void mergeWindowDeltas (std::vector<WindowDelta>& older, std::vector<WindowDelta> newer);
+
+} // namespace wm
@@ -0,0 +1,204 @@
+#include "window_filter.h"
+
+#include <algorithm>
+#include <regex>
+
+namespace wm {
+
+static unsigned ruleFields (const FilterRule& rule) {
+    unsigned fields = 0;
+    if (rule.processId != 0) fields |= FILTER_PID;
+    if (rule.minWidth || rule.minHeight || rule.maxWidth || rule.maxHeight) fields |= FILTER_BOUNDS;
+    if (!rule.titlePrefix.empty () || !rule.titleSuffix.empty () || !rule.titlePattern.empty ()) {
+        fields |= FILTER_TITLE;
+    }
+    if (!rule.executableName.empty ()) fields |= FILTER_PATH;
+    return fields;
+}
+
+struct WindowFilter::TitlePattern {
+    std::regex regex;
+};
+
+// Built with C++ exceptions enabled (see binding.gyp) so a bad pattern from
+// JS is reported instead of aborting the process.
+std::shared_ptr<const WindowFilter::TitlePattern> WindowFilter::compilePattern (const FilterRule& rule,
+                                                                                std::string& error) {
+    if (rule.titlePattern.empty ()) return nullptr;
+
+    auto flags = std::regex::ECMAScript | std::regex::optimize;
+    if (rule.titlePatternIgnoreCase) flags |= std::regex::icase;
+
+    try {
+        return std::make_shared<const TitlePattern> (TitlePattern{ std::regex (rule.titlePattern, flags) });
+    } catch (const std::regex_error& e) {
+        error = std::string ("invalid title pattern: ") + e.what ();
+        return nullptr;
+    }
+}
+
+WindowFilter::WindowFilter (const std::vector<FilterRule>& rules) {
+    for (const auto& rule : rules) {
+        std::string error;
+        auto pattern = compilePattern (rule, error);
+        if (error.empty ()) addRule (rule, std::move (pattern));
+    }
+}
+
+std::string WindowFilter::compile (const std::vector<FilterRule>& rules, WindowFilter& out, size_t& failedIndex) {
+    WindowFilter filter;
+    for (size_t i = 0; i < rules.size (); ++i) {
+        const FilterRule& rule = rules[i];
+
+        if (ruleFields (rule) == 0) {
+            failedIndex = i;
+            return "rule has no conditions and would hide every window";
+        }
+        if ((rule.maxWidth && rule.minWidth > rule.maxWidth) ||
+            (rule.maxHeight && rule.minHeight > rule.maxHeight)) {
+            failedIndex = i;
+            return "empty size range";
+        }
+
+        std::string error;
+        auto pattern = compilePattern (rule, error);
+        if (!error.empty ()) {
+            failedIndex = i;
+            return error;
+        }
+        filter.addRule (rule, std::move (pattern));
+    }
+
+    out = std::move (filter);
+    return "";
+}
+
+void WindowFilter::addRule (const FilterRule& rule, std::shared_ptr<const TitlePattern> pattern) {
+    uint32_t index = static_cast<uint32_t> (rules_.size ());
+    unsigned fields = ruleFields (rule);
+    rules_.push_back ({ rule, fields, std::move (pattern) });
+    fields_ |= fields;
+
+    if (rule.executableName.empty ()) {
+        anyExecutable_.push_back (index);
+    } else {
+        byExecutable_[rule.executableName].push_back (index);
+    }
+
+    if (!rule.titlePrefix.empty ()) {
+        if (trie_.empty ()) trie_.emplace_back ();
+        uint32_t node = 0;
+        for (char c : rule.titlePrefix) {
+            auto it = trie_[node].children.find (c);
+            if (it != trie_[node].children.end ()) {
+                node = it->second;
+                continue;
+            }
+            uint32_t child = static_cast<uint32_t> (trie_.size ());
+            trie_[node].children.emplace (c, child);
+            trie_.emplace_back ();
+            node = child;
+        }
+        trie_[node].rules.push_back (index);
+    }
+}
+
+// Rules whose title prefix the title starts with, found in one walk
+void WindowFilter::matchPrefixes (const std::string& title, std::vector<uint32_t>& matched) const {
+    if (trie_.empty ()) return;
+
+    uint32_t node = 0;
+    for (char c : title) {
+        auto it = trie_[node].children.find (c);
+        if (it == trie_[node].children.end ()) return;
+        node = it->second;
+        matched.insert (matched.end (), trie_[node].rules.begin (), trie_[node].rules.end ());
+    }
+}
+
+bool WindowFilter::matches (const CompiledRule& compiled,
+                            const WindowRecord& window,
+                            const std::vector<uint32_t>& prefixMatches,
+                            uint32_t index) const {
+    const FilterRule& rule = compiled.rule;
+
+    if (rule.processId != 0 && rule.processId != window.processId) return false;
+
+    if (compiled.fields & FILTER_BOUNDS) {
+        const Rect& b = window.bounds;
+        if (rule.minWidth && b.width < rule.minWidth) return false;
+        if (rule.minHeight && b.height < rule.minHeight) return false;
+        if (rule.maxWidth && b.width > rule.maxWidth) return false;
+        if (rule.maxHeight && b.height > rule.maxHeight) return false;
+    }
+
+    if (!rule.titlePrefix.empty () &&
+        std::find (prefixMatches.begin (), prefixMatches.end (), index) == prefixMatches.end ()) {
+        return false;
+    }
+
+    if (!rule.titleSuffix.empty ()) {
+        const std::string& title = window.title;
+        const std::string& suffix = rule.titleSuffix;
+        if (title.size () < suffix.size () ||
+            title.compare (title.size () - suffix.size (), suffix.size (), suffix) != 0) {
+            return false;
+        }
+    }
+
+    if (compiled.pattern) {
+        try {
+            if (!std::regex_search (window.title, compiled.pattern->regex)) return false;
+        } catch (const std::regex_error&) {
+            // Pathological pattern (e.g. error_complexity): treat as no match
+            return false;
+        }
+    }
+
+    // The executable name was matched by the bucket lookup
+    return true;
+}
+
+bool WindowFilter::excludes (const WindowRecord& window, unsigned available, unsigned checked) const {
+    if (rules_.empty ()) return false;
+
+    std::vector<uint32_t> prefixMatches;
+    bool prefixesWalked = false;
+
+    auto test = [&] (const std::vector<uint32_t>& candidates) {
+        for (uint32_t index : candidates) {
+            const CompiledRule& rule = rules_[index];
+            if ((rule.fields & available) != rule.fields) continue;
+            if ((rule.fields & checked) == rule.fields) continue;
+
+            if (!rule.rule.titlePrefix.empty () && !prefixesWalked) {
+                matchPrefixes (window.title, prefixMatches);
+                prefixesWalked = true;
+            }
+            if (matches (rule, window, prefixMatches, index)) return true;
+        }
+        return false;
+    };
+
+    if (test (anyExecutable_)) return true;
+
+    if ((available & FILTER_PATH) && !byExecutable_.empty () && !window.path.empty ()) {
+        const std::string& path = window.path;
+        size_t lastSep = path.find_last_of ("\\/");
+        std::string filename = (lastSep != std::string::npos) ? path.substr (lastSep + 1) : path;
+
+        auto it = byExecutable_.find (filename);
+        if (it != byExecutable_.end () && test (it->second)) return true;
+    }
+
+    return false;
+}
+
+bool WindowFilter::excludes (const std::string& path, const std::string& title) const {
+    WindowRecord window{};
+    window.path = path;
+    window.title = title;
+    return excludes (window, FILTER_PATH | FILTER_TITLE);
+}
+
+} // namespace wm
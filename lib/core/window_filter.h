@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+#include "window_record.h"
+
+namespace wm {
+
+// Hides the windows that satisfy every condition the rule sets; an empty
+// string or a zero means "any". A window is hidden if any rule matches.
+struct FilterRule {
+    // Executable file name, compared with the last component of the path
+    std::string executableName;
+    std::string titlePrefix;
+    std::string titleSuffix;
+    // ECMAScript regular expression searched in the title
+    std::string titlePattern;
+    bool titlePatternIgnoreCase;
+    int64_t processId;
+    // Inclusive size range; 0 leaves that side open
+    int minWidth;
+    int minHeight;
+    int maxWidth;
+    int maxHeight;
+
+    // Hides the windows of `executableName` whose title starts with
+    // `titlePrefix`; the form of the built-in ignore lists
+    static FilterRule exeWithTitlePrefix (std::string executableName, std::string titlePrefix) {
+        FilterRule rule{};
+        rule.executableName = std::move (executableName);
+        rule.titlePrefix = std::move (titlePrefix);
+        return rule;
+    }
+};
+
+// WindowRecord fields a rule needs, so backends can evaluate rules as soon as
+// the data is at hand and skip the expensive queries for hidden windows.
+enum FilterField : unsigned {
+    FILTER_PID = 1 << 0,
+    FILTER_BOUNDS = 1 << 1,
+    FILTER_TITLE = 1 << 2,
+    FILTER_PATH = 1 << 3,
+    FILTER_ALL = FILTER_PID | FILTER_BOUNDS | FILTER_TITLE | FILTER_PATH
+};
+
+// Compiled rule set. Rules naming an executable are bucketed in a hash map,
+// so windows of other executables never look at them; title prefixes of all
+// rules share one trie that a title is walked through once.
+class WindowFilter {
+public:
+    WindowFilter () = default;
+    explicit WindowFilter (const std::vector<FilterRule>& rules);
+
+    // Checks `rules`, compiling the title patterns. Returns an empty string
+    // on success, otherwise why the rule at `failedIndex` was rejected.
+    static std::string compile (const std::vector<FilterRule>& rules, WindowFilter& out, size_t& failedIndex);
+
+    // True if `window` is hidden by a rule whose fields are all in
+    // `available` and not all in `checked`. Passing the previous `available`
+    // as `checked` skips the rules an earlier stage already evaluated.
+    bool excludes (const WindowRecord& window, unsigned available = FILTER_ALL, unsigned checked = 0) const;
+
+    // Convenience for callers with just a path and a title
+    bool excludes (const std::string& path, const std::string& title) const;
+
+    bool empty () const {
+        return rules_.empty ();
+    }
+
+    // Union of the fields any rule needs; a backend can skip a stage whose
+    // fields no rule uses
+    unsigned fields () const {
+        return fields_;
+    }
+
+private:
+    // Compiled title pattern, defined in window_filter.cc so <regex> stays
+    // out of the addon sources, which are built without exceptions
+    struct TitlePattern;
+
+    struct CompiledRule {
+        FilterRule rule;
+        unsigned fields;
+        std::shared_ptr<const TitlePattern> pattern;
+    };
+
+    struct TrieNode {
+        std::unordered_map<char, uint32_t> children;
+        std::vector<uint32_t> rules;
+    };
+
+    static std::shared_ptr<const TitlePattern> compilePattern (const FilterRule& rule, std::string& error);
+    void addRule (const FilterRule& rule, std::shared_ptr<const TitlePattern> pattern);
+    void matchPrefixes (const std::string& title, std::vector<uint32_t>& matched) const;
+    bool matches (const CompiledRule& rule, const WindowRecord& window, const std::vector<uint32_t>& prefixMatches,
+                  uint32_t index) const;
+
+    std::vector<CompiledRule> rules_;
+    std::unordered_map<std::string, std::vector<uint32_t>> byExecutable_;
+    std::vector<uint32_t> anyExecutable_;
+    std::vector<TrieNode> trie_;
+    unsigned fields_ = 0;
+};
+
+// The active filter, replaced by setWindowFilters on the JS thread while
+// collections read it on the monitor thread or the thread pool.
+class SharedWindowFilter {
+public:
+    explicit SharedWindowFilter (const std::vector<FilterRule>& defaults)
+    : current_ (std::make_shared<WindowFilter> (defaults)) {}
+
+    std::shared_ptr<const WindowFilter> get () const {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return current_;
+    }
+
+    void set (std::shared_ptr<const WindowFilter> filter) {
+        std::lock_guard<std::mutex> lock (mutex_);
+        current_ = std::move (filter);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const WindowFilter> current_;
+};
+
+} // namespace wm
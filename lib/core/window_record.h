@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Platform-neutral data types shared by the native backends. Nothing in
+// lib/core depends on N-API or a window system, so it can be built and
+// tested on a headless machine.
+namespace wm {
+
+struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+inline bool operator== (const Rect& a, const Rect& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+inline bool operator!= (const Rect& a, const Rect& b) {
+    return !(a == b);
+}
+
+// One top-level window as reported by getWindowsSummary. `id` holds the
+// native handle (HWND, CGWindowID or X window id) widened to 64 bits.
+struct WindowRecord {
+    int64_t id;
+    std::string title;
+    std::string path;
+    int64_t processId;
+    Rect bounds;
+    int zOrder;
+    bool isVisible;
+    // Only filled when requested (see computeVisibleRegions)
+    double visibleFraction;
+    std::vector<Rect> visibleRects;
+    // Bounds in device-independent pixels; only filled when requested (see
+    // computeLogicalBounds)
+    Rect logicalBounds;
+};
+
+} // namespace wm
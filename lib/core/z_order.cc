@@ -0,0 +1,23 @@
+#include "z_order.h"
+
+namespace wm {
+
+ZOrderMap ZOrderMap::fromTopDown (const std::vector<int64_t>& stack) {
+    ZOrderMap map;
+    map.order_.reserve (stack.size ());
+    for (size_t i = 0; i < stack.size (); ++i) {
+        map.order_.emplace (stack[i], static_cast<int> (i));
+    }
+    return map;
+}
+
+ZOrderMap ZOrderMap::fromBottomUp (const std::vector<int64_t>& stack) {
+    ZOrderMap map;
+    map.order_.reserve (stack.size ());
+    for (size_t i = 0; i < stack.size (); ++i) {
+        map.order_.emplace (stack[i], static_cast<int> (stack.size () - 1 - i));
+    }
+    return map;
+}
+
+} // namespace wm
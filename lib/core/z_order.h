@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace wm {
+
+// Window id -> z-order position, 0 being the topmost window. Built once per
+// snapshot so every per-window lookup is O(1).
+class ZOrderMap {
+public:
+    // `stack` lists windows from the topmost down (EnumWindows, CGWindowList)
+    static ZOrderMap fromTopDown (const std::vector<int64_t>& stack);
+    // `stack` lists windows from the bottom up (_NET_CLIENT_LIST_STACKING)
+    static ZOrderMap fromBottomUp (const std::vector<int64_t>& stack);
+
+    // -1 for windows that are not in the stack
+    int find (int64_t id) const {
+        auto it = order_.find (id);
+        return it != order_.end () ? it->second : -1;
+    }
+
+    size_t size () const {
+        return order_.size ();
+    }
+
+private:
+    std::unordered_map<int64_t, int> order_;
+};
+
+} // namespace wm
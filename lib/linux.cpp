@@ -1,20 +1,468 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
 #include <napi.h>
+#include <poll.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <xcb/randr.h>
+#include <xcb/xcb.h>
+
+#include "core/monitors.h"
+#include "core/process_cache.h"
+#include "core/window_cache.h"
+#include "window_summary.h"
+
+#ifndef WM_BACKEND_XCB
 #include <X11/Xlib.h>
-#include <X11/Xutil.h>
+#include <X11/Xlib-xcb.h>
+#endif
+
+// Atoms used by the EWMH queries below, interned in one pipelined batch the
+// first time the shared connection is opened.
+enum AtomIndex {
+    NET_ACTIVE_WINDOW,
+    NET_CLIENT_LIST,
+    NET_CLIENT_LIST_STACKING,
+    NET_CURRENT_DESKTOP,
+    NET_WM_NAME,
+    NET_WM_PID,
+    NET_WM_STATE,
+    NET_WM_STATE_HIDDEN,
+    NET_WORKAREA,
+    UTF8_STRING,
+    ATOM_COUNT
+};
+
+static const char* ATOM_NAMES[ATOM_COUNT] = {
+    "_NET_ACTIVE_WINDOW",
+    "_NET_CLIENT_LIST",
+    "_NET_CLIENT_LIST_STACKING",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_WM_NAME",
+    "_NET_WM_PID",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WORKAREA",
+    "UTF8_STRING"
+};
+
+// Upper bound (in 32-bit units) for window list and title properties.
+static const uint32_t MAX_PROPERTY_LENGTH = 0x10000;
+
+// Every request is issued through XCB so that batches can be pipelined. The
+// build-time backend (binding.gyp `linux_backend`) only decides who owns the
+// connection: Xlib by default, or libxcb directly with WM_BACKEND_XCB, which
+// drops the libX11 dependency.
+struct XConnection {
+    xcb_connection_t* conn;
+    xcb_window_t root;
+};
+
+// Opening a display is a full socket handshake, so the addon keeps one
+// connection for its lifetime. Every access goes through g_displayMutex.
+static std::mutex g_displayMutex;
+#ifndef WM_BACKEND_XCB
+static Display* g_display = nullptr;
+#endif
+static XConnection g_connection{};
+static int g_displayUsers = 0;
+static xcb_atom_t g_atoms[ATOM_COUNT]{};
+
+// RandR monitors with their work areas, read on first use and kept until
+// the shared connection hears of a change: RRScreenChangeNotify, or a
+// PropertyNotify on the root window for the work area, the current desktop
+// or the resource database (Xft.dpi). Guarded by g_displayMutex.
+struct MonitorCache {
+    // First RandR event code; 0 without the extension
+    uint8_t randrEventBase;
+    bool stale;
+    std::vector<wm::MonitorRecord> monitors;
+};
+static MonitorCache g_monitorCache{ 0, true, {} };
+
+// Waits for a reply and drops any X error (typically BadWindow for a client
+// destroyed mid-batch); nullptr is returned in that case. Every reply counts
+// as a native call in getStats().
+template <typename Reply, typename Cookie>
+static Reply* awaitReply (Reply* (*fetch) (xcb_connection_t*, Cookie, xcb_generic_error_t**),
+                          xcb_connection_t* conn,
+                          Cookie cookie) {
+    wm::stats ().add (wm::STAT_NATIVE_CALLS);
+    xcb_generic_error_t* error = nullptr;
+    Reply* reply = fetch (conn, cookie, &error);
+    free (error);
+    return reply;
+}
+
+#ifndef WM_BACKEND_XCB
+// The default Xlib error handler exits the process, which is not acceptable
+// for a long-lived connection that gets queried with stale window ids.
+static int onXError (Display* display, XErrorEvent* event) {
+    return 0;
+}
+#endif
+
+static void internAtoms (xcb_connection_t* conn) {
+    xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+    for (int i = 0; i < ATOM_COUNT; ++i) {
+        cookies[i] = xcb_intern_atom (conn, 0, strlen (ATOM_NAMES[i]), ATOM_NAMES[i]);
+    }
+
+    for (int i = 0; i < ATOM_COUNT; ++i) {
+        auto reply = awaitReply (xcb_intern_atom_reply, conn, cookies[i]);
+        g_atoms[i] = reply ? reply->atom : static_cast<xcb_atom_t> (XCB_ATOM_NONE);
+        free (reply);
+    }
+}
+
+static xcb_window_t screenRoot (xcb_connection_t* conn, int screenNumber) {
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator (xcb_get_setup (conn));
+    for (int i = 0; i < screenNumber && screens.rem; ++i) {
+        xcb_screen_next (&screens);
+    }
+    return screens.data->root;
+}
+
+static void handleSharedEvent (const xcb_generic_event_t* event) {
+    uint8_t type = event->response_type & ~0x80;
+    if (g_monitorCache.randrEventBase && type == g_monitorCache.randrEventBase + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
+        g_monitorCache.stale = true;
+    } else if (type == XCB_PROPERTY_NOTIFY) {
+        auto notify = reinterpret_cast<const xcb_property_notify_event_t*> (event);
+        if (notify->atom == g_atoms[NET_WORKAREA] || notify->atom == g_atoms[NET_CURRENT_DESKTOP] ||
+            notify->atom == XCB_ATOM_RESOURCE_MANAGER) {
+            g_monitorCache.stale = true;
+        }
+    }
+}
+
+// Asks for the events that invalidate the monitor cache on the shared
+// connection: root property changes and RRScreenChangeNotify. The RandR
+// version has to be negotiated before RandR 1.5 requests (GetMonitors) are
+// accepted.
+static void selectMonitorEvents (xcb_connection_t* conn, xcb_window_t root) {
+    const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes (conn, root, XCB_CW_EVENT_MASK, &mask);
+    xcb_flush (conn);
+
+    const xcb_query_extension_reply_t* randr = xcb_get_extension_data (conn, &xcb_randr_id);
+    if (!randr || !randr->present) return;
+
+    auto reply = awaitReply (xcb_randr_query_version_reply, conn, xcb_randr_query_version (conn, 1, 5));
+    bool monitors = reply && (reply->major_version > 1 || reply->minor_version >= 5);
+    free (reply);
+    if (!monitors) return;
+
+    g_monitorCache.randrEventBase = randr->first_event;
+    xcb_randr_select_input (conn, root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE);
+    xcb_flush (conn);
+}
+
+// Returns the shared connection, opening it on first use. Callers must hold
+// g_displayMutex.
+static const XConnection* sharedConnection () {
+    if (g_connection.conn) {
+        // Errors of requests without replies end up in the event queue,
+        // which nothing else reads on this connection
+        while (xcb_generic_event_t* event = xcb_poll_for_queued_event (g_connection.conn)) {
+            handleSharedEvent (event);
+            free (event);
+        }
+        return &g_connection;
+    }
+
+#ifdef WM_BACKEND_XCB
+    int screenNumber = 0;
+    xcb_connection_t* conn = xcb_connect (NULL, &screenNumber);
+    if (xcb_connection_has_error (conn)) {
+        xcb_disconnect (conn);
+        return nullptr;
+    }
+
+    g_connection.root = screenRoot (conn, screenNumber);
+#else
+    g_display = XOpenDisplay (NULL);
+    if (!g_display) return nullptr;
+
+    XSetErrorHandler (onXError);
+    // Events (RandR notifications, errors) are read through XCB
+    XSetEventQueueOwner (g_display, XCBOwnsEventQueue);
+
+    xcb_connection_t* conn = XGetXCBConnection (g_display);
+    g_connection.root = DefaultRootWindow (g_display);
+#endif
+
+    g_connection.conn = conn;
+    internAtoms (conn);
+    selectMonitorEvents (conn, g_connection.root);
+
+    return &g_connection;
+}
+
+// Env cleanup hook. The connection is shared by every environment that loaded
+// the addon and is closed when the last one goes away.
+static void releaseDisplay () {
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+
+    if (--g_displayUsers > 0) return;
+    if (!g_connection.conn) return;
+
+#ifdef WM_BACKEND_XCB
+    xcb_disconnect (g_connection.conn);
+#else
+    XCloseDisplay (g_display);
+    g_display = nullptr;
+#endif
+    g_connection = XConnection{};
+    g_monitorCache = MonitorCache{ 0, true, {} };
+}
+
+// Xft.dpi from the RESOURCE_MANAGER property, which toolkits scale by; X
+// has no per-monitor scale setting. 0 if the desktop did not set one.
+static double xftScaleFactor (xcb_get_property_reply_t* reply) {
+    if (!reply || reply->format != 8) return 0;
+
+    std::string resources (static_cast<const char*> (xcb_get_property_value (reply)),
+                           xcb_get_property_value_length (reply));
+    static const char KEY[] = "Xft.dpi:";
+    for (size_t at = resources.find (KEY); at != std::string::npos; at = resources.find (KEY, at + 1)) {
+        if (at > 0 && resources[at - 1] != '\n') continue;
+        double dpi = strtod (resources.c_str () + at + sizeof (KEY) - 1, nullptr);
+        return dpi > 0 ? dpi / 96 : 0;
+    }
+    return 0;
+}
+
+// One round trip: RandR monitors, root geometry as a fallback, the work area
+// of the current desktop and the resource database.
+static void refreshMonitors (const XConnection& x) {
+    xcb_connection_t* conn = x.conn;
+    std::vector<wm::MonitorRecord>& monitors = g_monitorCache.monitors;
+    monitors.clear ();
 
-typedef Window HMONITOR;
-typedef int DEVICE_SCALE_FACTOR;
+    // Physical widths from RandR, for monitors without a configured scale
+    std::vector<int> widthsMm;
+
+    bool randr = g_monitorCache.randrEventBase != 0;
+    xcb_randr_get_monitors_cookie_t monitorsCookie{};
+    if (randr) monitorsCookie = xcb_randr_get_monitors (conn, x.root, 1);
+    auto rootCookie = xcb_get_geometry (conn, x.root);
+    auto desktopCookie =
+    xcb_get_property (conn, 0, x.root, g_atoms[NET_CURRENT_DESKTOP], XCB_ATOM_CARDINAL, 0, 1);
+    auto workAreaCookie =
+    xcb_get_property (conn, 0, x.root, g_atoms[NET_WORKAREA], XCB_ATOM_CARDINAL, 0, MAX_PROPERTY_LENGTH);
+    auto resourcesCookie =
+    xcb_get_property (conn, 0, x.root, XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, 0, MAX_PROPERTY_LENGTH);
+
+    if (randr) {
+        auto reply = awaitReply (xcb_randr_get_monitors_reply, conn, monitorsCookie);
+        if (reply) {
+            for (auto it = xcb_randr_get_monitors_monitors_iterator (reply); it.rem;
+                 xcb_randr_monitor_info_next (&it)) {
+                const xcb_randr_monitor_info_t* m = it.data;
+                wm::Rect bounds{ m->x, m->y, m->width, m->height };
+                monitors.push_back ({ static_cast<int64_t> (m->name), bounds, bounds, m->primary != 0, 1 });
+                widthsMm.push_back (static_cast<int> (m->width_in_millimeters));
+            }
+        }
+        free (reply);
+    }
+
+    // Without RandR 1.5 the whole screen is one monitor
+    auto rootReply = awaitReply (xcb_get_geometry_reply, conn, rootCookie);
+    if (monitors.empty () && rootReply) {
+        wm::Rect bounds{ 0, 0, rootReply->width, rootReply->height };
+        monitors.push_back ({ static_cast<int64_t> (x.root), bounds, bounds, true, 1 });
+    }
+    free (rootReply);
+
+    bool hasPrimary = false;
+    for (const auto& monitor : monitors) hasPrimary = hasPrimary || monitor.isPrimary;
+    if (!hasPrimary && !monitors.empty ()) monitors[0].isPrimary = true;
+
+    // _NET_WORKAREA holds one rectangle per desktop spanning every monitor,
+    // so each monitor gets its part of it
+    uint32_t desktop = 0;
+    auto desktopReply = awaitReply (xcb_get_property_reply, conn, desktopCookie);
+    if (desktopReply && desktopReply->format == 32 && xcb_get_property_value_length (desktopReply) >= 4) {
+        desktop = *static_cast<uint32_t*> (xcb_get_property_value (desktopReply));
+    }
+    free (desktopReply);
+
+    auto workAreaReply = awaitReply (xcb_get_property_reply, conn, workAreaCookie);
+    if (workAreaReply && workAreaReply->format == 32 &&
+        static_cast<uint32_t> (xcb_get_property_value_length (workAreaReply)) >= 16 * (desktop + 1)) {
+        auto values = static_cast<uint32_t*> (xcb_get_property_value (workAreaReply)) + 4 * desktop;
+        wm::Rect area{ static_cast<int> (values[0]), static_cast<int> (values[1]), static_cast<int> (values[2]),
+                       static_cast<int> (values[3]) };
+        for (auto& monitor : monitors) {
+            wm::Rect part = wm::intersectRects (monitor.bounds, area);
+            if (part.width > 0 && part.height > 0) monitor.workArea = part;
+        }
+    }
+    free (workAreaReply);
+
+    auto resourcesReply = awaitReply (xcb_get_property_reply, conn, resourcesCookie);
+    double scale = xftScaleFactor (resourcesReply);
+    free (resourcesReply);
+    for (size_t i = 0; i < monitors.size (); ++i) {
+        if (scale > 0) {
+            monitors[i].scaleFactor = scale;
+        } else if (i < widthsMm.size ()) {
+            monitors[i].scaleFactor = wm::scaleFromPhysicalSize (monitors[i].bounds.width, widthsMm[i]);
+        }
+    }
+}
+
+// Cached monitors, refreshed only after a change notification. Reading the
+// pending events is a non-blocking socket read, not a round trip. Callers
+// must hold g_displayMutex.
+static const std::vector<wm::MonitorRecord>& currentMonitors (const XConnection& x) {
+    while (xcb_generic_event_t* event = xcb_poll_for_event (x.conn)) {
+        handleSharedEvent (event);
+        free (event);
+    }
+
+    if (g_monitorCache.stale) {
+        refreshMonitors (x);
+        g_monitorCache.stale = false;
+    }
+    return g_monitorCache.monitors;
+}
+
+static const wm::MonitorRecord* findMonitor (const std::vector<wm::MonitorRecord>& monitors, int64_t id) {
+    for (const auto& monitor : monitors) {
+        if (monitor.id == id) return &monitor;
+    }
+    return nullptr;
+}
+
+static std::string readProcessPath (int64_t pid) {
+    char link[32];
+    snprintf (link, sizeof (link), "/proc/%lld/exe", static_cast<long long> (pid));
+
+    char path[PATH_MAX];
+    ssize_t length = readlink (link, path, sizeof (path) - 1);
+    if (length <= 0) return "";
+
+    return std::string (path, length);
+}
+
+// Field 22 of /proc/<pid>/stat, in clock ticks since boot.
+static bool readProcessStartTime (int64_t pid, uint64_t& startTime) {
+    char file[32];
+    snprintf (file, sizeof (file), "/proc/%lld/stat", static_cast<long long> (pid));
+
+    int fd = open (file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    char buffer[1024];
+    ssize_t length = read (fd, buffer, sizeof (buffer) - 1);
+    close (fd);
+    if (length <= 0) return false;
+    buffer[length] = '\0';
+
+    // The command name may contain spaces; numbered fields resume after the last ')'
+    const char* field = strrchr (buffer, ')');
+    for (int i = 2; i < 22 && field; ++i) field = strchr (field + 1, ' ');
+    if (!field) return false;
+
+    startTime = strtoull (field + 1, nullptr, 10);
+    return true;
+}
+
+static int openPidfd (int64_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int> (syscall (SYS_pidfd_open, static_cast<pid_t> (pid), 0));
+#else
+    return -1;
+#endif
+}
+
+static bool pidfdExited (int pidfd) {
+    pollfd fd{ pidfd, POLLIN, 0 };
+    return poll (&fd, 1, 0) != 0;
+}
+
+// Entries keep a pidfd when the kernel has pidfd_open (5.3+): it becomes
+// readable once the process exits, so a hit costs one poll(). Older kernels
+// compare the /proc start time instead.
+static bool loadProcess (int64_t pid, wm::ProcessInfo& info) {
+    int pidfd = openPidfd (pid);
+
+    if (!readProcessStartTime (pid, info.startTime)) {
+        if (pidfd >= 0) close (pidfd);
+        return false;
+    }
+    info.path = readProcessPath (pid);
+
+    // The process may have exited (and the pid been reused) while reading
+    if (pidfd >= 0 && pidfdExited (pidfd)) {
+        close (pidfd);
+        return false;
+    }
+
+    info.handle = pidfd;
+    return true;
+}
+
+static bool processAlive (const wm::ProcessInfo& info) {
+    if (info.handle >= 0) return !pidfdExited (static_cast<int> (info.handle));
+
+    uint64_t startTime = 0;
+    return readProcessStartTime (info.pid, startTime) && startTime == info.startTime;
+}
+
+static void releaseProcess (wm::ProcessInfo& info) {
+    if (info.handle >= 0) close (static_cast<int> (info.handle));
+}
+
+static wm::ProcessCache g_processCache{ { loadProcess, processAlive, releaseProcess } };
 
 struct Process {
     unsigned long pid;
     std::string path;
 };
 
-Process getWindowProcess (Window handle) {
-    throw "getWindowProcess is not implemented on Linux";
+// _NET_WM_PID of the window, resolved through the process cache.
+Process getWindowProcess (xcb_window_t handle) {
+    Process process{ 0, "" };
+
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        const XConnection* x = sharedConnection ();
+        if (!x) return process;
+
+        auto cookie = xcb_get_property (x->conn, 0, handle, g_atoms[NET_WM_PID], XCB_ATOM_CARDINAL, 0, 1);
+        auto reply = awaitReply (xcb_get_property_reply, x->conn, cookie);
+        if (reply && reply->format == 32 && xcb_get_property_value_length (reply) >= 4) {
+            process.pid = *static_cast<uint32_t*> (xcb_get_property_value (reply));
+        }
+        free (reply);
+    }
+
+    wm::ProcessInfo info;
+    if (process.pid != 0 && g_processCache.lookup (process.pid, info)) {
+        process.path = info.path;
+    }
+
+    return process;
 }
 
-Window find_top_window (unsigned long pid) {
+xcb_window_t find_top_window (unsigned long pid) {
     throw "find_top_window is not implemented on Linux";
 }
 
@@ -33,27 +481,28 @@ Napi::Number createProcess (const Napi::CallbackInfo& info) {
 }
 
 
-Napi::Number getActiveWindow (const Napi::CallbackInfo& info) {
-    Napi::Env env{ info.Env () };
-
-    Display* display = XOpenDisplay(NULL);
-    Window root = XDefaultRootWindow(display);
-    Atom active_window = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
-    Atom type;
-    int format;
-    unsigned long nItems, bytesAfter;
-    unsigned char *property = NULL;
-    Window active = 0;
+// _NET_ACTIVE_WINDOW of `root`, 0 if none
+static xcb_window_t readActiveWindow (xcb_connection_t* conn, xcb_window_t root) {
+    xcb_window_t active = 0;
 
-    if (XGetWindowProperty(display, root, active_window, 0, 1024, False, AnyPropertyType, 
-                           &type, &format, &nItems, &bytesAfter, &property) == Success) {
-        active = *(Window*)property;
-        XFree(property);
+    auto cookie = xcb_get_property (conn, 0, root, g_atoms[NET_ACTIVE_WINDOW], XCB_ATOM_WINDOW, 0, 1);
+    auto reply = awaitReply (xcb_get_property_reply, conn, cookie);
+    if (reply && reply->format == 32 && xcb_get_property_value_length (reply) >= 4) {
+        active = *static_cast<xcb_window_t*> (xcb_get_property_value (reply));
     }
+    free (reply);
 
-    XCloseDisplay(display);
+    return active;
+}
 
-    return Napi::Number::New (env, static_cast<int64_t> (active));
+Napi::Number getActiveWindow (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Number::New (env, 0);
+
+    return Napi::Number::New (env, static_cast<int64_t> (readActiveWindow (x->conn, x->root)));
 }
 
 template <typename T>
@@ -61,43 +510,249 @@ T getValueFromCallbackData (const Napi::CallbackInfo& info, unsigned handleIndex
     return static_cast<T> (info[handleIndex].As<Napi::Number> ().Int64Value ());
 }
 
+Napi::Object initWindow (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
+    auto process = getWindowProcess (handle);
+
+    Napi::Object obj{ Napi::Object::New (env) };
+
+    obj.Set ("processId", static_cast<double> (process.pid));
+    obj.Set ("path", process.path);
+
+    return obj;
+}
+
+// Class part of a WM_CLASS value, "instance\0class\0"
+static std::string classFromReply (xcb_get_property_reply_t* reply) {
+    if (!reply || reply->format != 8) return "";
+    const char* value = static_cast<const char*> (xcb_get_property_value (reply));
+    int length = xcb_get_property_value_length (reply);
+    const char* instanceEnd = static_cast<const char*> (memchr (value, '\0', length));
+    if (!instanceEnd) return "";
+    const char* name = instanceEnd + 1;
+    return std::string (name, strnlen (name, value + length - name));
+}
+
+// _NET_WM_PID and WM_CLASS of every window in one pipelined round trip; the
+// paths come from the process cache afterwards, outside g_displayMutex
+static std::vector<WindowInfo> loadWindowInfos (const std::vector<int64_t>& windows) {
+    std::vector<WindowInfo> infos (windows.size (), WindowInfo{});
+    for (size_t i = 0; i < windows.size (); ++i) infos[i].id = windows[i];
+
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        const XConnection* x = sharedConnection ();
+        if (!x) return infos;
+
+        struct InfoCookies {
+            xcb_get_property_cookie_t pid;
+            xcb_get_property_cookie_t wmClass;
+        };
+        std::vector<InfoCookies> cookies (windows.size ());
+        for (size_t i = 0; i < windows.size (); ++i) {
+            auto window = static_cast<xcb_window_t> (windows[i]);
+            cookies[i].pid = xcb_get_property (x->conn, 0, window, g_atoms[NET_WM_PID], XCB_ATOM_CARDINAL, 0, 1);
+            cookies[i].wmClass = xcb_get_property (x->conn, 0, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 256);
+        }
+        xcb_flush (x->conn);
+
+        for (size_t i = 0; i < windows.size (); ++i) {
+            auto pidReply = awaitReply (xcb_get_property_reply, x->conn, cookies[i].pid);
+            auto classReply = awaitReply (xcb_get_property_reply, x->conn, cookies[i].wmClass);
+            // A destroyed window answers with BadWindow instead of a reply
+            infos[i].valid = pidReply != nullptr;
+            if (pidReply && pidReply->format == 32 && xcb_get_property_value_length (pidReply) >= 4) {
+                infos[i].processId = *static_cast<uint32_t*> (xcb_get_property_value (pidReply));
+            }
+            infos[i].className = classFromReply (classReply);
+            free (pidReply);
+            free (classReply);
+        }
+    }
+
+    for (WindowInfo& info : infos) {
+        wm::ProcessInfo process;
+        if (info.processId != 0 && g_processCache.lookup (info.processId, process)) info.path = process.path;
+    }
+    return infos;
+}
+
+WindowInfo loadWindowInfo (int64_t id) {
+    return loadWindowInfos ({ id }).front ();
+}
+
+Napi::Object getProcessCacheStats (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    return processCacheStatsToObject (env, g_processCache.stats ());
+}
+
+Napi::Object getStats (const Napi::CallbackInfo& info) {
+    wm::ProcessCacheStats processCache = g_processCache.stats ();
+    return statsToObject (info.Env (), &processCache);
+}
+
+Napi::Value resetStats (const Napi::CallbackInfo& info) {
+    wm::stats ().reset ();
+    g_processCache.resetStats ();
+    return info.Env ().Undefined ();
+}
+
+Napi::Array getMonitors (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    std::vector<int64_t> ids;
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        const XConnection* x = sharedConnection ();
+        if (x) {
+            for (const auto& monitor : currentMonitors (*x)) ids.push_back (monitor.id);
+        }
+    }
+
+    return handlesToArray (env, ids);
+}
+
+// The window's root-relative rectangle is read in one round trip; the
+// monitor is then picked from the cache by largest overlap
+Napi::Number getMonitorFromWindow (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
+
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Number::New (env, 0);
+
+    auto geometryCookie = xcb_get_geometry (x->conn, handle);
+    auto originCookie = xcb_translate_coordinates (x->conn, handle, x->root, 0, 0);
+    auto geometry = awaitReply (xcb_get_geometry_reply, x->conn, geometryCookie);
+    auto origin = awaitReply (xcb_translate_coordinates_reply, x->conn, originCookie);
+
+    wm::Rect bounds{};
+    if (geometry && origin) bounds = { origin->dst_x, origin->dst_y, geometry->width, geometry->height };
+    free (geometry);
+    free (origin);
+
+    const auto& monitors = currentMonitors (*x);
+    int index = wm::monitorForRect (monitors, bounds);
+    return Napi::Number::New (env, index < 0 ? 0 : static_cast<double> (monitors[index].id));
+}
+
+Napi::Object getMonitorInfo (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    auto id = info[0].As<Napi::Number> ().Int64Value ();
+
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    const wm::MonitorRecord* monitor = x ? findMonitor (currentMonitors (*x), id) : nullptr;
+    if (!monitor) return Napi::Object::New (env);
+
+    return monitorRecordToObject (env, *monitor);
+}
+
+Napi::Number getMonitorScaleFactor (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    auto id = info[0].As<Napi::Number> ().Int64Value ();
+
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    const wm::MonitorRecord* monitor = x ? findMonitor (currentMonitors (*x), id) : nullptr;
+
+    return Napi::Number::New (env, monitor ? monitor->scaleFactor : 1);
+}
+
+
+// Scale factor of the cached monitor `bounds` (root coordinates) is mostly
+// on. Callers must hold g_displayMutex.
+static double scaleFactorAt (const XConnection& x, const wm::Rect& bounds) {
+    const auto& monitors = currentMonitors (x);
+    int index = wm::monitorForRect (monitors, bounds);
+    return index < 0 ? 1 : monitors[index].scaleFactor;
+}
 
 Napi::Object getWindowBounds (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
 
-    auto handle{ getValueFromCallbackData<Window> (info, 0) };
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
+    bool logical = readLogicalOption (info, 1);
+
+    wm::Rect bounds{};
+
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        const XConnection* connection = sharedConnection ();
+        if (connection) {
+            auto cookie = xcb_get_geometry (connection->conn, handle);
+            // The monitor is picked by the position on the root window
+            xcb_translate_coordinates_cookie_t originCookie{};
+            if (logical) originCookie = xcb_translate_coordinates (connection->conn, handle, connection->root, 0, 0);
+
+            auto reply = awaitReply (xcb_get_geometry_reply, connection->conn, cookie);
+            if (reply) bounds = { reply->x, reply->y, reply->width, reply->height };
+            free (reply);
+
+            if (logical) {
+                auto origin = awaitReply (xcb_translate_coordinates_reply, connection->conn, originCookie);
+                if (origin) {
+                    wm::Rect onRoot{ origin->dst_x, origin->dst_y, bounds.width, bounds.height };
+                    bounds = wm::logicalRect (bounds, scaleFactorAt (*connection, onRoot));
+                }
+                free (origin);
+            }
+        }
+    }
+
+    return rectToObject (env, bounds);
+}
 
-    Display* display = XOpenDisplay(NULL);
-    Window root;
-    int x, y;
-    unsigned int width, height, border_width, depth;
+Napi::Number getWindowScaleFactor (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
 
-    XGetGeometry(display, handle, &root, &x, &y, &width, &height, &border_width, &depth);
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
 
-    XCloseDisplay(display);
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Number::New (env, 1);
 
-    Napi::Object bounds{ Napi::Object::New (env) };
+    auto geometryCookie = xcb_get_geometry (x->conn, handle);
+    auto originCookie = xcb_translate_coordinates (x->conn, handle, x->root, 0, 0);
+    auto geometry = awaitReply (xcb_get_geometry_reply, x->conn, geometryCookie);
+    auto origin = awaitReply (xcb_translate_coordinates_reply, x->conn, originCookie);
 
-    bounds.Set ("x", x);
-    bounds.Set ("y", y);
-    bounds.Set ("width", width);
-    bounds.Set ("height", height);
+    wm::Rect bounds{};
+    if (geometry && origin) bounds = { origin->dst_x, origin->dst_y, geometry->width, geometry->height };
+    free (geometry);
+    free (origin);
 
-    return bounds;
+    return Napi::Number::New (env, scaleFactorAt (*x, bounds));
 }
 
 Napi::Boolean setWindowBounds (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
 
     Napi::Object bounds{ info[1].As<Napi::Object> () };
-    auto handle{ getValueFromCallbackData<Window> (info, 0) };
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
 
-    Display* display = XOpenDisplay(NULL);
+    const uint32_t values[] = {
+        static_cast<uint32_t> (bounds.Get ("x").ToNumber ().Int32Value ()),
+        static_cast<uint32_t> (bounds.Get ("y").ToNumber ().Int32Value ()),
+        bounds.Get ("width").ToNumber ().Uint32Value (),
+        bounds.Get ("height").ToNumber ().Uint32Value ()
+    };
 
-    XMoveResizeWindow(display, handle, bounds.Get ("x").ToNumber (), bounds.Get ("y").ToNumber (),
-                      bounds.Get ("width").ToNumber (), bounds.Get ("height").ToNumber ());
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Boolean::New (env, false);
 
-    XCloseDisplay(display);
+    xcb_configure_window (x->conn, handle,
+                          XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+                          XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+                          values);
+    xcb_flush (x->conn);
 
     return Napi::Boolean::New (env, true);
 }
@@ -105,33 +760,145 @@ Napi::Boolean setWindowBounds (const Napi::CallbackInfo& info) {
 Napi::Boolean showWindow (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
 
-    auto handle{ getValueFromCallbackData<Window> (info, 0) };
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
     std::string type{ info[1].As<Napi::String> () };
 
-    Display* display = XOpenDisplay(NULL);
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Boolean::New (env, false);
 
     if (type == "hide")
-        XUnmapWindow(display, handle);
+        xcb_unmap_window (x->conn, handle);
     else
-        XMapWindow(display, handle);
+        xcb_map_window (x->conn, handle);
 
-    XCloseDisplay(display);
+    xcb_flush (x->conn);
 
     return Napi::Boolean::New (env, true);
 }
 
+static std::string layoutError (const xcb_generic_error_t* error) {
+    if (error->error_code == XCB_WINDOW) return "Window not found";
+    return "X error " + std::to_string (error->error_code);
+}
+
+// Queues the whole layout on the shared connection and flushes it once. The
+// requests are checked, so one sync round trip after the flush reports the
+// X errors of every window. Unmaps go first and maps last, so windows are
+// shown at their new position; the last raised window is also activated
+// through the window manager.
+static std::vector<wm::LayoutResult> applyLayoutBatch (const std::vector<wm::LayoutChange>& changes) {
+    std::vector<wm::LayoutResult> results (changes.size ());
+    for (size_t i = 0; i < changes.size (); ++i) results[i] = { changes[i].id, true, "" };
+
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) {
+        for (auto& result : results) result = { result.id, false, "Cannot open display" };
+        return results;
+    }
+
+    struct Pending {
+        size_t index;
+        xcb_void_cookie_t cookie;
+    };
+    std::vector<Pending> pending;
+    pending.reserve (changes.size () * 2);
+    xcb_window_t activate = XCB_WINDOW_NONE;
+
+    for (size_t i = 0; i < changes.size (); ++i) {
+        const wm::LayoutChange& change = changes[i];
+        auto handle = static_cast<xcb_window_t> (change.id);
+
+        if (change.visibility == wm::LAYOUT_HIDE) {
+            pending.push_back ({ i, xcb_unmap_window_checked (x->conn, handle) });
+        }
+
+        // Values go in the order of the mask bits
+        uint16_t mask = 0;
+        uint32_t values[5];
+        int count = 0;
+        if (change.boundsFields & wm::LAYOUT_X) {
+            mask |= XCB_CONFIG_WINDOW_X;
+            values[count++] = static_cast<uint32_t> (change.bounds.x);
+        }
+        if (change.boundsFields & wm::LAYOUT_Y) {
+            mask |= XCB_CONFIG_WINDOW_Y;
+            values[count++] = static_cast<uint32_t> (change.bounds.y);
+        }
+        if (change.boundsFields & wm::LAYOUT_WIDTH) {
+            mask |= XCB_CONFIG_WINDOW_WIDTH;
+            values[count++] = static_cast<uint32_t> (std::max (change.bounds.width, 1));
+        }
+        if (change.boundsFields & wm::LAYOUT_HEIGHT) {
+            mask |= XCB_CONFIG_WINDOW_HEIGHT;
+            values[count++] = static_cast<uint32_t> (std::max (change.bounds.height, 1));
+        }
+        if (change.raise) {
+            mask |= XCB_CONFIG_WINDOW_STACK_MODE;
+            values[count++] = XCB_STACK_MODE_ABOVE;
+            activate = handle;
+        }
+        if (mask) {
+            pending.push_back ({ i, xcb_configure_window_checked (x->conn, handle, mask, values) });
+        }
+
+        if (change.visibility == wm::LAYOUT_SHOW) {
+            pending.push_back ({ i, xcb_map_window_checked (x->conn, handle) });
+        }
+    }
+
+    if (activate != XCB_WINDOW_NONE && g_atoms[NET_ACTIVE_WINDOW] != XCB_ATOM_NONE) {
+        // Source indication 2: a pager-like tool acting for the user
+        xcb_client_message_event_t event{};
+        event.response_type = XCB_CLIENT_MESSAGE;
+        event.format = 32;
+        event.window = activate;
+        event.type = g_atoms[NET_ACTIVE_WINDOW];
+        event.data.data32[0] = 2;
+        event.data.data32[1] = XCB_CURRENT_TIME;
+        xcb_send_event (x->conn, 0, x->root,
+                        XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                        reinterpret_cast<const char*> (&event));
+    }
+
+    xcb_flush (x->conn);
+
+    wm::stats ().add (wm::STAT_NATIVE_CALLS, pending.size ());
+    for (const Pending& request : pending) {
+        xcb_generic_error_t* error = xcb_request_check (x->conn, request.cookie);
+        if (!error) continue;
+        wm::LayoutResult& result = results[request.index];
+        if (result.ok) result = { result.id, false, layoutError (error) };
+        free (error);
+    }
+
+    return results;
+}
+
+Napi::Value applyLayout (const Napi::CallbackInfo& info) {
+    return applyLayoutChanges (info, applyLayoutBatch);
+}
+
+Napi::Value tileWindows (const Napi::CallbackInfo& info) {
+    return applyTiling (info, applyLayoutBatch);
+}
+
 Napi::Boolean isWindow (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
 
-    auto handle{ getValueFromCallbackData<Window> (info, 0) };
+    auto handle{ getValueFromCallbackData<xcb_window_t> (info, 0) };
 
-    Display* display = XOpenDisplay(NULL);
-    XWindowAttributes attr;
-    Status s = XGetWindowAttributes(display, handle, &attr);
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Boolean::New (env, false);
 
-    XCloseDisplay(display);
+    auto cookie = xcb_get_window_attributes (x->conn, handle);
+    auto reply = awaitReply (xcb_get_window_attributes_reply, x->conn, cookie);
+    bool exists = reply != nullptr;
+    free (reply);
 
-    return Napi::Boolean::New (env, s != 0);
+    return Napi::Boolean::New (env, exists);
 }
 
 Napi::Number getWindowZOrder (const Napi::CallbackInfo& info) {
@@ -139,54 +906,1061 @@ Napi::Number getWindowZOrder (const Napi::CallbackInfo& info) {
 
     // Best-effort: EWMH doesn't provide a portable, direct z-order across all WMs.
     // We approximate using the _NET_CLIENT_LIST_STACKING if available.
-    Display* display = XOpenDisplay(NULL);
-    if (!display) return Napi::Number::New(env, -1);
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return Napi::Number::New(env, -1);
 
-    Window root = XDefaultRootWindow(display);
-    Atom stackingAtom = XInternAtom(display, "_NET_CLIENT_LIST_STACKING", True);
-    if (stackingAtom == None) {
-        XCloseDisplay(display);
+    auto cookie = xcb_get_property (x->conn, 0, x->root, g_atoms[NET_CLIENT_LIST_STACKING],
+                                    XCB_ATOM_WINDOW, 0, MAX_PROPERTY_LENGTH);
+    auto reply = awaitReply (xcb_get_property_reply, x->conn, cookie);
+    if (!reply || reply->format != 32) {
+        free (reply);
         return Napi::Number::New(env, -1);
     }
 
-    Atom type;
-    int format;
-    unsigned long nItems, bytesAfter;
-    unsigned char* data = NULL;
-    if (XGetWindowProperty(display, root, stackingAtom, 0, 1024, False, XA_WINDOW,
-                           &type, &format, &nItems, &bytesAfter, &data) != Success || !data) {
-        XCloseDisplay(display);
-        return Napi::Number::New(env, -1);
-    }
-
-    Window* list = reinterpret_cast<Window*>(data);
-    Window target = getValueFromCallbackData<Window>(info, 0);
+    auto list = static_cast<xcb_window_t*> (xcb_get_property_value (reply));
+    int nItems = xcb_get_property_value_length (reply) / 4;
+    xcb_window_t target = getValueFromCallbackData<xcb_window_t>(info, 0);
 
     // _NET_CLIENT_LIST_STACKING is bottom->top per EWMH spec; z-index is count of windows above
     int index = -1;
-    for (unsigned long i = 0; i < nItems; ++i) {
-        if (list[i] == target) { index = (int)i; break; }
+    for (int i = 0; i < nItems; ++i) {
+        if (list[i] == target) { index = i; break; }
     }
 
     int zIndex = -1;
     if (index >= 0) {
-        zIndex = (int)(nItems - 1 - index);
+        zIndex = nItems - 1 - index;
     }
 
-    XFree(data);
-    XCloseDisplay(display);
+    free (reply);
     return Napi::Number::New(env, zIndex);
 }
 
+static std::vector<xcb_window_t> windowListFromReply (xcb_get_property_reply_t* reply) {
+    std::vector<xcb_window_t> list;
+    if (!reply || reply->format != 32) return list;
+
+    auto ids = static_cast<xcb_window_t*> (xcb_get_property_value (reply));
+    int count = xcb_get_property_value_length (reply) / 4;
+    list.assign (ids, ids + count);
+    return list;
+}
+
+// WM_NAME is ISO-8859-1 when typed STRING, _NET_WM_NAME is already UTF-8.
+static std::string titleFromReply (xcb_get_property_reply_t* reply) {
+    if (!reply || reply->format != 8) return "";
+
+    auto data = static_cast<const unsigned char*> (xcb_get_property_value (reply));
+    int length = xcb_get_property_value_length (reply);
+
+    if (reply->type != XCB_ATOM_STRING) {
+        return std::string (reinterpret_cast<const char*> (data), length);
+    }
+
+    std::string title;
+    title.reserve (length);
+    for (int i = 0; i < length; ++i) {
+        if (data[i] < 0x80) {
+            title += static_cast<char> (data[i]);
+        } else {
+            title += static_cast<char> (0xC0 | (data[i] >> 6));
+            title += static_cast<char> (0x80 | (data[i] & 0x3F));
+        }
+    }
+    return title;
+}
+
+// Per-environment state; see EnvState. The monitor thread owns a second
+// connection that only receives events, so it can block in poll() without
+// holding g_displayMutex and costs nothing while the desktop is idle.
+struct AddonState : EnvState {
+    // No built-in filter rules on Linux; setWindowFilters installs them
+    AddonState () : EnvState ({}) {}
+    ~AddonState () {
+        stopMonitor ();
+    }
+
+    void stopMonitor ();
+
+    std::thread monitorThread;
+    int wakePipe[2] = { -1, -1 };
+    // Incremental collection for the monitor. The monitor thread marks what
+    // its events invalidate here, and a refresh re-fetches only that: one
+    // moved window costs a geometry and a translate request instead of a
+    // round of requests for every client.
+    wm::WindowCache windowCache; // monitor thread only
+};
+
+static AddonState& addonState (Napi::Env env) {
+    return *env.GetInstanceData<AddonState> ();
+}
+
+Napi::Value setWindowFilters (const Napi::CallbackInfo& info) {
+    return applyWindowFilters (info, addonState (info.Env ()).windowFilter);
+}
+
+// True if a text property is set and non-empty. Also works on replies
+// requested with a zero length, which carry the size but no data; `type`
+// is the type the property was requested as, or XCB_GET_PROPERTY_TYPE_ANY.
+static bool hasTextProperty (xcb_get_property_reply_t* reply, xcb_atom_t type) {
+    if (!reply || reply->format != 8) return false;
+    if (type != XCB_GET_PROPERTY_TYPE_ANY && reply->type != type) return false;
+    return xcb_get_property_value_length (reply) > 0 || reply->bytes_after > 0;
+}
+
+// Windows gathered under the display lock, before their paths are known.
+struct PendingSummary {
+    std::vector<wm::WindowRecord> windows;
+    // Copied for the visible regions and logical bounds
+    std::vector<wm::MonitorRecord> monitors;
+    // What was collected, from wm::summaryFieldsToCollect
+    unsigned fields = 0;
+};
+
+// Collects every managed client window. Requests for all clients are queued
+// before any reply is read, so a refresh costs a few round trips in total
+// instead of several per window. Only the requests behind `requested`
+// (wm::SummaryField bits) and the active filter rules are sent; the title
+// is then only probed for its length, so untitled windows are still
+// skipped. Callers must hold g_displayMutex; paths are filled in by
+// finishWindowsSummary once it is released.
+static PendingSummary collectWindowsSummary (const XConnection& x,
+                                             const wm::WindowFilter& filter,
+                                             unsigned requested) {
+    std::vector<wm::WindowRecord> results;
+    PendingSummary pending;
+
+    xcb_connection_t* conn = x.conn;
+    xcb_window_t root = x.root;
+
+    const unsigned fields = wm::summaryFieldsToCollect (requested, filter.fields ());
+    pending.fields = fields;
+    const bool wantTitle = fields & wm::SUMMARY_TITLE;
+    const bool wantPid = fields & wm::SUMMARY_PROCESS_ID;
+    const bool wantOrigin = fields & wm::SUMMARY_BOUNDS;
+    const bool wantVisibility = fields & wm::SUMMARY_IS_VISIBLE;
+    // Visibility also looks at the size
+    const bool wantGeometry = wantOrigin || wantVisibility;
+    const uint32_t titleLength = wantTitle ? MAX_PROPERTY_LENGTH : 0;
+
+    auto clientsCookie = xcb_get_property (conn, 0, root, g_atoms[NET_CLIENT_LIST],
+                                           XCB_ATOM_WINDOW, 0, MAX_PROPERTY_LENGTH);
+    xcb_get_property_cookie_t stackingCookie{};
+    if (fields & wm::SUMMARY_Z_ORDER) {
+        stackingCookie = xcb_get_property (conn, 0, root, g_atoms[NET_CLIENT_LIST_STACKING],
+                                           XCB_ATOM_WINDOW, 0, MAX_PROPERTY_LENGTH);
+    }
+
+    auto clientsReply = awaitReply (xcb_get_property_reply, conn, clientsCookie);
+    std::vector<xcb_window_t> clients = windowListFromReply (clientsReply);
+    free (clientsReply);
+
+    if (fields & (wm::SUMMARY_VISIBLE_REGION | wm::SUMMARY_LOGICAL_BOUNDS)) pending.monitors = currentMonitors (x);
+
+    std::vector<xcb_window_t> stacking;
+    if (fields & wm::SUMMARY_Z_ORDER) {
+        auto stackingReply = awaitReply (xcb_get_property_reply, conn, stackingCookie);
+        stacking = windowListFromReply (stackingReply);
+        free (stackingReply);
+    }
+
+    // _NET_CLIENT_LIST_STACKING is bottom->top; zOrder 0 is the topmost window
+    wm::ZOrderMap zOrderMap =
+    wm::ZOrderMap::fromBottomUp (std::vector<int64_t> (stacking.begin (), stacking.end ()));
+
+    struct ClientCookies {
+        xcb_get_property_cookie_t name;
+        xcb_get_property_cookie_t pid;
+        xcb_get_property_cookie_t state;
+        xcb_get_geometry_cookie_t geometry;
+        xcb_translate_coordinates_cookie_t origin;
+        xcb_get_window_attributes_cookie_t attributes;
+    };
+
+    std::vector<ClientCookies> cookies (clients.size ());
+    for (size_t i = 0; i < clients.size (); ++i) {
+        xcb_window_t window = clients[i];
+        cookies[i].name = xcb_get_property (conn, 0, window, g_atoms[NET_WM_NAME],
+                                            g_atoms[UTF8_STRING], 0, titleLength);
+        if (wantPid) {
+            cookies[i].pid = xcb_get_property (conn, 0, window, g_atoms[NET_WM_PID],
+                                               XCB_ATOM_CARDINAL, 0, 1);
+        }
+        if (wantVisibility) {
+            cookies[i].state = xcb_get_property (conn, 0, window, g_atoms[NET_WM_STATE],
+                                                 XCB_ATOM_ATOM, 0, 64);
+            cookies[i].attributes = xcb_get_window_attributes (conn, window);
+        }
+        if (wantGeometry) cookies[i].geometry = xcb_get_geometry (conn, window);
+        if (wantOrigin) cookies[i].origin = xcb_translate_coordinates (conn, window, root, 0, 0);
+    }
+    xcb_flush (conn);
+
+    std::vector<size_t> untitled;
+    // Parallel to results: false drops the window at the end
+    std::vector<char> titled;
+    results.reserve (clients.size ());
+    titled.reserve (clients.size ());
+
+    for (size_t i = 0; i < clients.size (); ++i) {
+        xcb_get_property_reply_t* nameReply = awaitReply (xcb_get_property_reply, conn, cookies[i].name);
+        xcb_get_property_reply_t* pidReply = nullptr;
+        xcb_get_property_reply_t* stateReply = nullptr;
+        xcb_get_geometry_reply_t* geometryReply = nullptr;
+        xcb_translate_coordinates_reply_t* originReply = nullptr;
+        xcb_get_window_attributes_reply_t* attributesReply = nullptr;
+        if (wantPid) pidReply = awaitReply (xcb_get_property_reply, conn, cookies[i].pid);
+        if (wantVisibility) {
+            stateReply = awaitReply (xcb_get_property_reply, conn, cookies[i].state);
+            attributesReply = awaitReply (xcb_get_window_attributes_reply, conn, cookies[i].attributes);
+        }
+        if (wantGeometry) geometryReply = awaitReply (xcb_get_geometry_reply, conn, cookies[i].geometry);
+        if (wantOrigin) originReply = awaitReply (xcb_translate_coordinates_reply, conn, cookies[i].origin);
+
+        // Window vanished between listing and querying
+        if (!nameReply || (wantGeometry && !geometryReply) || (wantVisibility && !attributesReply)) {
+            free (nameReply);
+            free (pidReply);
+            free (stateReply);
+            free (geometryReply);
+            free (originReply);
+            free (attributesReply);
+            continue;
+        }
+
+        wm::WindowRecord summary{};
+        summary.id = clients[i];
+        summary.title = titleFromReply (nameReply);
+        bool hasTitle = hasTextProperty (nameReply, g_atoms[UTF8_STRING]);
+
+        if (pidReply && pidReply->format == 32 && xcb_get_property_value_length (pidReply) >= 4) {
+            summary.processId = *static_cast<uint32_t*> (xcb_get_property_value (pidReply));
+        }
+
+        if (geometryReply) {
+            summary.bounds.x = originReply ? originReply->dst_x : geometryReply->x;
+            summary.bounds.y = originReply ? originReply->dst_y : geometryReply->y;
+            summary.bounds.width = geometryReply->width;
+            summary.bounds.height = geometryReply->height;
+        }
+
+        summary.zOrder = zOrderMap.find (summary.id);
+
+        if (wantVisibility) {
+            summary.isVisible = attributesReply->map_state == XCB_MAP_STATE_VIEWABLE;
+            if (stateReply && stateReply->format == 32) {
+                auto states = static_cast<xcb_atom_t*> (xcb_get_property_value (stateReply));
+                int count = xcb_get_property_value_length (stateReply) / 4;
+                for (int s = 0; s < count; ++s) {
+                    if (states[s] == g_atoms[NET_WM_STATE_HIDDEN]) summary.isVisible = false;
+                }
+            }
+
+            // Filter out zero or very small windows (likely invisible UI elements)
+            if (summary.bounds.width < 1 || summary.bounds.height < 1) {
+                summary.isVisible = false;
+            }
+        }
+
+        free (nameReply);
+        free (pidReply);
+        free (stateReply);
+        free (geometryReply);
+        free (originReply);
+        free (attributesReply);
+
+        // Window-property rules first, so hidden windows never cost a /proc lookup
+        unsigned available = wm::FILTER_PID | wm::FILTER_BOUNDS;
+        if (!summary.title.empty ()) available |= wm::FILTER_TITLE;
+        if (filter.excludes (summary, available)) continue;
+
+        if (!hasTitle) untitled.push_back (results.size ());
+        results.push_back (std::move (summary));
+        titled.push_back (hasTitle);
+    }
+
+    // Legacy clients only set WM_NAME; fetch those in a second pipelined batch
+    if (!untitled.empty ()) {
+        std::vector<xcb_get_property_cookie_t> nameCookies;
+        nameCookies.reserve (untitled.size ());
+        for (size_t index : untitled) {
+            nameCookies.push_back (xcb_get_property (conn, 0, results[index].id, XCB_ATOM_WM_NAME,
+                                                     XCB_GET_PROPERTY_TYPE_ANY, 0, titleLength));
+        }
+        xcb_flush (conn);
+
+        for (size_t i = 0; i < untitled.size (); ++i) {
+            auto nameReply = awaitReply (xcb_get_property_reply, conn, nameCookies[i]);
+            wm::WindowRecord& summary = results[untitled[i]];
+            summary.title = titleFromReply (nameReply);
+            titled[untitled[i]] = hasTextProperty (nameReply, XCB_GET_PROPERTY_TYPE_ANY);
+            free (nameReply);
+
+            // Title rules could not run before; path rules run once the path is known
+            const unsigned available = wm::FILTER_ALL & ~wm::FILTER_PATH;
+            const unsigned checked = wm::FILTER_PID | wm::FILTER_BOUNDS;
+            if (!summary.title.empty () && filter.excludes (summary, available, checked)) {
+                titled[untitled[i]] = false;
+            }
+        }
+    }
+
+    // Same rule as the other platforms: windows without a title are skipped
+    pending.windows.reserve (results.size ());
+    for (size_t i = 0; i < results.size (); ++i) {
+        if (titled[i]) pending.windows.push_back (std::move (results[i]));
+    }
+    return pending;
+}
+
+// Second half of collectWindowsSummary, run without g_displayMutex so the
+// /proc reads behind the paths never hold up other X calls.
+static std::vector<wm::WindowRecord> finishWindowsSummary (PendingSummary pending,
+                                                           const wm::WindowFilter& filter,
+                                                           unsigned requested) {
+    const unsigned fields = pending.fields;
+    std::vector<wm::WindowRecord> kept;
+    kept.reserve (pending.windows.size ());
+
+    if (fields & wm::SUMMARY_PATH) {
+        std::unordered_set<int64_t> livePids;
+        for (wm::WindowRecord& summary : pending.windows) {
+            wm::ProcessInfo process;
+            if (summary.processId != 0 && g_processCache.lookup (summary.processId, process)) {
+                summary.path = process.path;
+                livePids.insert (summary.processId);
+            }
+
+            unsigned available = wm::FILTER_PID | wm::FILTER_BOUNDS | wm::FILTER_PATH;
+            if (!summary.title.empty ()) available |= wm::FILTER_TITLE;
+            if (filter.excludes (summary, available, available & ~wm::FILTER_PATH)) continue;
+            kept.push_back (std::move (summary));
+        }
+
+        // Processes that no longer own a client window leave the cache; a
+        // collection without paths says nothing about them
+        g_processCache.retain (livePids);
+    } else {
+        kept = std::move (pending.windows);
+    }
+
+    // Visible regions are clipped to the RandR monitors, so the dead areas of
+    // a screen with differently sized monitors count as hidden
+    if (fields & wm::SUMMARY_VISIBLE_REGION) {
+        std::vector<wm::Rect> screenRects;
+        for (const auto& monitor : pending.monitors) screenRects.push_back (monitor.bounds);
+        wm::computeVisibleRegions (kept, screenRects);
+    }
+    if (fields & wm::SUMMARY_LOGICAL_BOUNDS) wm::computeLogicalBounds (kept, pending.monitors);
+
+    wm::projectWindowRecords (kept, requested);
+    return kept;
+}
+
+// Takes the display lock only for the X round trips.
+static std::vector<wm::WindowRecord> collectSharedWindowsSummary (const wm::WindowFilter& filter,
+                                                                  unsigned fields = wm::SUMMARY_ALL) {
+    wm::ScopedTimer timer (wm::TIMER_COLLECT);
+    PendingSummary pending;
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        const XConnection* x = sharedConnection ();
+        if (!x) return {};
+        pending = collectWindowsSummary (*x, filter, fields);
+    }
+    return finishWindowsSummary (std::move (pending), filter, fields);
+}
+
+// Resolves the frame of each window in `pending` by walking query_tree up to
+// the root, one pipelined round per level.
+static void resolveFrames (wm::WindowCache& cache,
+                           xcb_connection_t* conn,
+                           xcb_window_t root,
+                           std::vector<xcb_window_t> pending) {
+    // Window being resolved -> ancestor reached so far
+    std::vector<std::pair<xcb_window_t, xcb_window_t>> walks;
+    for (xcb_window_t window : pending) walks.emplace_back (window, window);
+
+    for (int depth = 0; depth < 8 && !walks.empty (); ++depth) {
+        std::vector<xcb_query_tree_cookie_t> cookies;
+        cookies.reserve (walks.size ());
+        for (const auto& walk : walks) cookies.push_back (xcb_query_tree (conn, walk.second));
+        xcb_flush (conn);
+
+        std::vector<std::pair<xcb_window_t, xcb_window_t>> next;
+        for (size_t i = 0; i < walks.size (); ++i) {
+            auto reply = awaitReply (xcb_query_tree_reply, conn, cookies[i]);
+            if (!reply) continue;
+            xcb_window_t parent = reply->parent;
+            free (reply);
+
+            if (parent == root || parent == XCB_NONE) {
+                cache.setFrame (walks[i].first, walks[i].second);
+            } else {
+                next.emplace_back (walks[i].first, parent);
+            }
+        }
+        walks.swap (next);
+    }
+}
+
+// Brings `cache` up to date, except for the paths of windows whose pid
+// changed: those are listed in `unresolved` for resolveProcessPaths. Callers
+// must hold g_displayMutex.
+static void refreshWindowCache (wm::WindowCache& cache, const XConnection& x, std::vector<int64_t>& unresolved) {
+    xcb_connection_t* conn = x.conn;
+
+    xcb_get_property_cookie_t clientsCookie{}, stackingCookie{};
+    bool listDirty = cache.listDirty ();
+    bool stackingDirty = cache.stackingDirty ();
+    if (listDirty) {
+        clientsCookie = xcb_get_property (conn, 0, x.root, g_atoms[NET_CLIENT_LIST], XCB_ATOM_WINDOW, 0,
+                                          MAX_PROPERTY_LENGTH);
+    }
+    if (stackingDirty) {
+        stackingCookie = xcb_get_property (conn, 0, x.root, g_atoms[NET_CLIENT_LIST_STACKING],
+                                           XCB_ATOM_WINDOW, 0, MAX_PROPERTY_LENGTH);
+    }
+    if (listDirty) {
+        auto reply = awaitReply (xcb_get_property_reply, conn, clientsCookie);
+        std::vector<xcb_window_t> clients = windowListFromReply (reply);
+        free (reply);
+        cache.setWindows (std::vector<int64_t> (clients.begin (), clients.end ()));
+    }
+    if (stackingDirty) {
+        auto reply = awaitReply (xcb_get_property_reply, conn, stackingCookie);
+        std::vector<xcb_window_t> stacking = windowListFromReply (reply);
+        free (reply);
+        cache.setStacking (std::vector<int64_t> (stacking.begin (), stacking.end ()));
+    }
+
+    std::vector<std::pair<int64_t, unsigned>> dirty = cache.takeDirty ();
+    wm::traceInstant ("dirty", 0, "windows", static_cast<int64_t> (dirty.size ()));
+    if (dirty.empty ()) return;
+
+    struct Requests {
+        xcb_get_property_cookie_t name;
+        xcb_get_property_cookie_t pid;
+        xcb_get_property_cookie_t state;
+        xcb_get_geometry_cookie_t geometry;
+        xcb_translate_coordinates_cookie_t origin;
+        xcb_get_window_attributes_cookie_t attributes;
+    };
+
+    std::vector<Requests> requests (dirty.size ());
+    for (size_t i = 0; i < dirty.size (); ++i) {
+        xcb_window_t window = static_cast<xcb_window_t> (dirty[i].first);
+        unsigned parts = dirty[i].second;
+        if (parts & wm::DIRTY_TITLE) {
+            requests[i].name = xcb_get_property (conn, 0, window, g_atoms[NET_WM_NAME], g_atoms[UTF8_STRING],
+                                                 0, MAX_PROPERTY_LENGTH);
+        }
+        if (parts & wm::DIRTY_PROCESS) {
+            requests[i].pid = xcb_get_property (conn, 0, window, g_atoms[NET_WM_PID], XCB_ATOM_CARDINAL, 0, 1);
+        }
+        if (parts & wm::DIRTY_STATE) {
+            requests[i].state = xcb_get_property (conn, 0, window, g_atoms[NET_WM_STATE], XCB_ATOM_ATOM, 0, 64);
+            requests[i].attributes = xcb_get_window_attributes (conn, window);
+        }
+        if (parts & wm::DIRTY_GEOMETRY) {
+            requests[i].geometry = xcb_get_geometry (conn, window);
+            requests[i].origin = xcb_translate_coordinates (conn, window, x.root, 0, 0);
+        }
+    }
+    xcb_flush (conn);
+
+    std::vector<xcb_window_t> untitled, unframed;
+    for (size_t i = 0; i < dirty.size (); ++i) {
+        wm::CachedWindow* window = cache.find (dirty[i].first);
+        unsigned parts = dirty[i].second;
+
+        xcb_get_property_reply_t* nameReply = nullptr;
+        xcb_get_property_reply_t* pidReply = nullptr;
+        xcb_get_property_reply_t* stateReply = nullptr;
+        xcb_get_window_attributes_reply_t* attributesReply = nullptr;
+        xcb_get_geometry_reply_t* geometryReply = nullptr;
+        xcb_translate_coordinates_reply_t* originReply = nullptr;
+        if (parts & wm::DIRTY_TITLE) nameReply = awaitReply (xcb_get_property_reply, conn, requests[i].name);
+        if (parts & wm::DIRTY_PROCESS) pidReply = awaitReply (xcb_get_property_reply, conn, requests[i].pid);
+        if (parts & wm::DIRTY_STATE) {
+            stateReply = awaitReply (xcb_get_property_reply, conn, requests[i].state);
+            attributesReply = awaitReply (xcb_get_window_attributes_reply, conn, requests[i].attributes);
+        }
+        if (parts & wm::DIRTY_GEOMETRY) {
+            geometryReply = awaitReply (xcb_get_geometry_reply, conn, requests[i].geometry);
+            originReply = awaitReply (xcb_translate_coordinates_reply, conn, requests[i].origin);
+        }
+
+        // Window vanished since it was listed
+        if (((parts & wm::DIRTY_TITLE) && !nameReply) || ((parts & wm::DIRTY_STATE) && !attributesReply) ||
+            ((parts & wm::DIRTY_GEOMETRY) && !geometryReply)) {
+            window->valid = false;
+        } else {
+            wm::WindowRecord& record = window->record;
+            if (parts & wm::DIRTY_TITLE) {
+                record.title = titleFromReply (nameReply);
+                window->hasTitle = hasTextProperty (nameReply, g_atoms[UTF8_STRING]);
+                if (!window->hasTitle) untitled.push_back (static_cast<xcb_window_t> (record.id));
+            }
+            if (parts & wm::DIRTY_PROCESS) {
+                record.processId = 0;
+                record.path.clear ();
+                if (pidReply && pidReply->format == 32 && xcb_get_property_value_length (pidReply) >= 4) {
+                    record.processId = *static_cast<uint32_t*> (xcb_get_property_value (pidReply));
+                }
+                if (record.processId != 0) unresolved.push_back (record.id);
+            }
+            if (parts & wm::DIRTY_STATE) {
+                window->shown = attributesReply->map_state == XCB_MAP_STATE_VIEWABLE;
+                if (stateReply && stateReply->format == 32) {
+                    auto states = static_cast<xcb_atom_t*> (xcb_get_property_value (stateReply));
+                    int count = xcb_get_property_value_length (stateReply) / 4;
+                    for (int s = 0; s < count; ++s) {
+                        if (states[s] == g_atoms[NET_WM_STATE_HIDDEN]) window->shown = false;
+                    }
+                }
+            }
+            if (parts & wm::DIRTY_GEOMETRY) {
+                record.bounds.x = originReply ? originReply->dst_x : geometryReply->x;
+                record.bounds.y = originReply ? originReply->dst_y : geometryReply->y;
+                record.bounds.width = geometryReply->width;
+                record.bounds.height = geometryReply->height;
+            }
+            if (parts & wm::DIRTY_FRAME) unframed.push_back (static_cast<xcb_window_t> (record.id));
+        }
+
+        free (nameReply);
+        free (pidReply);
+        free (stateReply);
+        free (attributesReply);
+        free (geometryReply);
+        free (originReply);
+    }
+
+    // Legacy clients only set WM_NAME
+    if (!untitled.empty ()) {
+        std::vector<xcb_get_property_cookie_t> cookies;
+        cookies.reserve (untitled.size ());
+        for (xcb_window_t window : untitled) {
+            cookies.push_back (xcb_get_property (conn, 0, window, XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0,
+                                                 MAX_PROPERTY_LENGTH));
+        }
+        xcb_flush (conn);
+
+        for (size_t i = 0; i < untitled.size (); ++i) {
+            auto reply = awaitReply (xcb_get_property_reply, conn, cookies[i]);
+            wm::CachedWindow* window = cache.find (untitled[i]);
+            window->record.title = titleFromReply (reply);
+            window->hasTitle = hasTextProperty (reply, XCB_GET_PROPERTY_TYPE_ANY);
+            free (reply);
+        }
+    }
+
+    if (!unframed.empty ()) resolveFrames (cache, conn, x.root, std::move (unframed));
+}
+
+// Fills the paths refreshWindowCache left out. Runs without g_displayMutex;
+// the cache itself belongs to the monitor thread.
+static void resolveProcessPaths (wm::WindowCache& cache, const std::vector<int64_t>& unresolved) {
+    for (int64_t id : unresolved) {
+        wm::CachedWindow* window = cache.find (id);
+        if (!window) continue;
+        wm::ProcessInfo process;
+        if (g_processCache.lookup (window->record.processId, process)) window->record.path = process.path;
+    }
+}
+
+// Same records and filtering as collectWindowsSummary (x, SUMMARY_ALL),
+// built from the cache after re-fetching what changed.
+static std::vector<wm::WindowRecord> collectCachedWindowsSummary (AddonState& state) {
+    wm::ScopedTimer timer (wm::TIMER_COLLECT);
+    wm::WindowCache& cache = state.windowCache;
+    std::vector<int64_t> unresolved;
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        const XConnection* x = sharedConnection ();
+        if (!x) return {};
+        refreshWindowCache (cache, *x, unresolved);
+    }
+    resolveProcessPaths (cache, unresolved);
+
+    std::shared_ptr<const wm::WindowFilter> filter = state.windowFilter.get ();
+    std::unordered_set<int64_t> livePids;
+    std::vector<wm::WindowRecord> results;
+    results.reserve (cache.order ().size ());
+
+    for (int64_t id : cache.order ()) {
+        const wm::CachedWindow* window = cache.get (id);
+        if (!window || !window->hasTitle) continue;
+
+        wm::WindowRecord summary = window->record;
+        summary.isVisible = window->shown && summary.bounds.width >= 1 && summary.bounds.height >= 1;
+        if (!summary.path.empty ()) livePids.insert (summary.processId);
+        if (filter->excludes (summary, wm::FILTER_ALL)) continue;
+        results.push_back (std::move (summary));
+    }
+
+    g_processCache.retain (livePids);
+    return results;
+}
+
+// Helper function to build windows summary
+Napi::Array buildWindowsSummary (Napi::Env env, unsigned fields) {
+    auto filter = addonState (env).windowFilter.get ();
+    return windowRecordsToArray (env, collectSharedWindowsSummary (*filter, fields), fields);
+}
+
+Napi::Value getWindowsSummary (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return env.Undefined ();
+    return buildWindowsSummary (env, fields);
+}
+
+Napi::Value getWindowsSummaryBinary (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return env.Undefined ();
+    auto filter = addonState (env).windowFilter.get ();
+    return windowRecordsToArrayBuffer (env, collectSharedWindowsSummary (*filter, fields));
+}
+
+// Managed client windows, the Linux counterpart of EnumWindows
+static std::vector<int64_t> collectWindows () {
+    std::lock_guard<std::mutex> lock (g_displayMutex);
+    const XConnection* x = sharedConnection ();
+    if (!x) return {};
+
+    auto cookie = xcb_get_property (x->conn, 0, x->root, g_atoms[NET_CLIENT_LIST],
+                                    XCB_ATOM_WINDOW, 0, MAX_PROPERTY_LENGTH);
+    auto reply = awaitReply (xcb_get_property_reply, x->conn, cookie);
+    std::vector<xcb_window_t> clients = windowListFromReply (reply);
+    free (reply);
+
+    return std::vector<int64_t> (clients.begin (), clients.end ());
+}
+
+std::vector<WindowInfo> collectWindowInfos () {
+    std::vector<WindowInfo> windows;
+    for (WindowInfo& info : loadWindowInfos (collectWindows ())) {
+        if (info.valid && !info.path.empty ()) windows.push_back (std::move (info));
+    }
+    return windows;
+}
+
+Napi::Array getWindows (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    return NativeWindow::fromInfos (env, addonState (env), collectWindowInfos ());
+}
+
+// Async variants: the X round trips run on the thread pool under
+// g_displayMutex, only the marshalling runs on the JS thread
+Napi::Promise getWindowsAsync (const Napi::CallbackInfo& info) {
+    return queueCollect<std::vector<WindowInfo>> (info.Env (), collectWindowInfos,
+                                                  [] (Napi::Env env, const std::vector<WindowInfo>& windows) {
+                                                      return NativeWindow::fromInfos (env, addonState (env), windows);
+                                                  });
+}
+
+Napi::Value getWindowsSummaryAsync (const Napi::CallbackInfo& info) {
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return info.Env ().Undefined ();
+    // The rules in force now, even if they are replaced before the worker runs
+    auto filter = addonState (info.Env ()).windowFilter.get ();
+    return queueCollect<std::vector<wm::WindowRecord>> (
+    info.Env (), [filter, fields] { return collectSharedWindowsSummary (*filter, fields); },
+    [fields] (Napi::Env env, const std::vector<wm::WindowRecord>& windows) {
+        return windowRecordsToArray (env, windows, fields);
+    });
+}
+
+Napi::Value getWindowsSummaryBinaryAsync (const Napi::CallbackInfo& info) {
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return info.Env ().Undefined ();
+    auto filter = addonState (info.Env ()).windowFilter.get ();
+    return queueCollect<std::vector<uint8_t>> (
+    info.Env (), [filter, fields] { return wm::serializeWindowColumns (collectSharedWindowsSummary (*filter, fields)); },
+    marshalBytes);
+}
+
+// Window monitoring
+static const std::chrono::milliseconds THROTTLE_MS (64); // ~30fps throttle interval
+
+static const uint32_t ROOT_EVENT_MASK =
+XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+static const uint32_t CLIENT_EVENT_MASK =
+XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+
+// Subscribes to ConfigureNotify/PropertyNotify on clients that appeared since
+// the last call. Destroyed windows drop their selection server-side.
+static void selectClientEvents (xcb_connection_t* conn,
+                                xcb_window_t root,
+                                std::unordered_set<xcb_window_t>& selected) {
+    auto cookie = xcb_get_property (conn, 0, root, g_atoms[NET_CLIENT_LIST], XCB_ATOM_WINDOW, 0,
+                                    MAX_PROPERTY_LENGTH);
+    auto reply = awaitReply (xcb_get_property_reply, conn, cookie);
+    std::vector<xcb_window_t> clients = windowListFromReply (reply);
+    free (reply);
+
+    std::unordered_set<xcb_window_t> current (clients.begin (), clients.end ());
+    for (xcb_window_t client : clients) {
+        if (selected.count (client)) continue;
+        xcb_change_window_attributes (conn, client, XCB_CW_EVENT_MASK, &CLIENT_EVENT_MASK);
+    }
+    selected.swap (current);
+    xcb_flush (conn);
+}
+
+// Marks what the event invalidates in `cache` and returns true if
+// that can change a window summary; a new _NET_ACTIVE_WINDOW only sets
+// `activeChanged`. Busy clients update properties like
+// _NET_WM_USER_TIME on every keystroke, and menus and tooltips are
+// override-redirect windows nobody lists; both are dropped here instead of
+// triggering a refresh. Structure events for a managed client usually
+// arrive for its frame, which the cache maps back to the client.
+static bool markDirty (wm::WindowCache& cache,
+                       xcb_generic_event_t* event,
+                       bool& clientListChanged,
+                       bool& activeChanged) {
+    switch (event->response_type & ~0x80) {
+    case XCB_PROPERTY_NOTIFY: {
+        auto notify = reinterpret_cast<xcb_property_notify_event_t*> (event);
+        // Monitor geometry; the shared connection invalidates its cache itself
+        if (notify->atom == g_atoms[NET_WORKAREA] || notify->atom == g_atoms[NET_CURRENT_DESKTOP] ||
+            notify->atom == XCB_ATOM_RESOURCE_MANAGER) {
+            return false;
+        }
+        if (notify->atom == g_atoms[NET_ACTIVE_WINDOW]) {
+            activeChanged = true;
+            return false;
+        }
+        if (notify->atom == g_atoms[NET_CLIENT_LIST]) {
+            clientListChanged = true;
+            cache.markListDirty ();
+            return true;
+        }
+        if (notify->atom == g_atoms[NET_CLIENT_LIST_STACKING]) {
+            cache.markStackingDirty ();
+            return true;
+        }
+        if (notify->atom == g_atoms[NET_WM_NAME] || notify->atom == XCB_ATOM_WM_NAME) {
+            return cache.markDirty (notify->window, wm::DIRTY_TITLE);
+        }
+        if (notify->atom == g_atoms[NET_WM_STATE]) return cache.markDirty (notify->window, wm::DIRTY_STATE);
+        if (notify->atom == g_atoms[NET_WM_PID]) return cache.markDirty (notify->window, wm::DIRTY_PROCESS);
+        return false;
+    }
+    case XCB_CONFIGURE_NOTIFY:
+        return cache.markDirty (reinterpret_cast<xcb_configure_notify_event_t*> (event)->window,
+                                wm::DIRTY_GEOMETRY);
+    case XCB_MAP_NOTIFY:
+        return cache.markDirty (reinterpret_cast<xcb_map_notify_event_t*> (event)->window, wm::DIRTY_STATE);
+    case XCB_UNMAP_NOTIFY:
+        return cache.markDirty (reinterpret_cast<xcb_unmap_notify_event_t*> (event)->window, wm::DIRTY_STATE);
+    case XCB_REPARENT_NOTIFY:
+        return cache.markDirty (reinterpret_cast<xcb_reparent_notify_event_t*> (event)->window,
+                                wm::DIRTY_FRAME | wm::DIRTY_GEOMETRY | wm::DIRTY_STATE);
+    case XCB_DESTROY_NOTIFY:
+        // The fetch fails and drops it until the client list catches up
+        return cache.markDirty (reinterpret_cast<xcb_destroy_notify_event_t*> (event)->window, wm::DIRTY_ALL);
+    default:
+        return false;
+    }
+}
+
+// Helper function to invoke JS callback with window summary. Collection and
+// diffing run on the monitor thread; only the marshalling happens on the JS
+// thread. `triggeredAt` is the trace time of the first event answered.
+static void invokeWindowsSummaryCallback (AddonState& state, uint64_t triggeredAt = 0) {
+    if (!state.monitoring || !state.tsfn || !state.collectsWindows ()) {
+        return;
+    }
+
+    MonitorTrace trace = MonitorTrace::begin (triggeredAt);
+    std::vector<wm::WindowRecord> snapshot;
+    {
+        wm::TraceScope scope ("collect", trace.id);
+        // zOrder comes from _NET_CLIENT_LIST_STACKING, whose changes trigger
+        // a refresh, so the index follows restacking as well as moves
+        snapshot = collectCachedWindowsSummary (state);
+        state.spatialIndex.set (std::make_shared<wm::SpatialIndex> (snapshot));
+    }
+
+    MonitorUpdate* update =
+    makeMonitorUpdate (state.differ, state.initialSummarySent, std::move (snapshot), state.monitorOptions, trace);
+    if (!update) return;
+
+    state.mailbox.post (state.tsfn, update, state.monitorOptions);
+}
+
+// Owns `conn`, which startWindowsMonitoring opened so that a failure to
+// connect is thrown to the caller.
+void MonitorThreadProc (AddonState* state, xcb_connection_t* conn, int screenNumber) {
+    xcb_window_t root = screenRoot (conn, screenNumber);
+    xcb_change_window_attributes (conn, root, XCB_CW_EVENT_MASK, &ROOT_EVENT_MASK);
+
+    std::unordered_set<xcb_window_t> selected;
+    selectClientEvents (conn, root, selected);
+
+    wm::tracer ().nameThread ("X monitor");
+    state->windowCache.clear ();
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point lastProcessed;
+    bool pendingTrailingUpdate = false;
+    // Trace time of the first event the pending refresh answers
+    uint64_t firstPendingEvent = 0;
+
+    // Initial snapshot so listeners don't wait for the first change
+    lastProcessed = Clock::now ();
+    invokeWindowsSummaryCallback (*state);
+
+    while (state->monitoring) {
+        int timeout = -1;
+        if (pendingTrailingUpdate) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds> (
+            lastProcessed + THROTTLE_MS - Clock::now ());
+            timeout = remaining.count () > 0 ? static_cast<int> (remaining.count ()) : 0;
+        }
+
+        bool dirty = false;
+        bool clientListChanged = false;
+        bool activeChanged = false;
+        pollfd fds[2] = { { xcb_get_file_descriptor (conn), POLLIN, 0 }, { state->wakePipe[0], POLLIN, 0 } };
+
+        // Events may already be buffered by a previous reply read
+        xcb_generic_event_t* event = xcb_poll_for_queued_event (conn);
+        if (!event && poll (fds, 2, timeout) > 0 && (fds[1].revents & POLLIN)) {
+            char wake[16];
+            if (read (state->wakePipe[0], wake, sizeof wake) <= 0 || !state->monitoring) break;
+            // New options: refresh, so a listener that was just added gets
+            // its first summary
+            dirty = true;
+        }
+
+        // Coalesce everything that is currently readable into one update
+        while (event || (event = xcb_poll_for_event (conn))) {
+            wm::stats ().add (wm::STAT_MONITOR_EVENTS);
+            if (markDirty (state->windowCache, event, clientListChanged, activeChanged)) {
+                wm::stats ().add (wm::STAT_MONITOR_RELEVANT_EVENTS);
+                wm::traceInstant ("x-event", 0, "type", event->response_type & ~0x80);
+                if (!firstPendingEvent && wm::tracer ().enabled ()) firstPendingEvent = wm::traceNow ();
+                dirty = true;
+            }
+            free (event);
+            event = nullptr;
+        }
+
+        if (xcb_connection_has_error (conn)) {
+            std::cerr << "X connection for window monitoring was closed" << std::endl;
+            break;
+        }
+
+        // Not throttled: listeners hear about a new foreground window at once
+        if (activeChanged) state->postActivation (readActiveWindow (conn, root));
+        if (clientListChanged) selectClientEvents (conn, root, selected);
+        if (dirty) pendingTrailingUpdate = true;
+        if (!pendingTrailingUpdate) continue;
+
+        // Throttle: leading edge immediately, trailing edge once the interval passed
+        if (Clock::now () - lastProcessed >= THROTTLE_MS) {
+            lastProcessed = Clock::now ();
+            pendingTrailingUpdate = false;
+            invokeWindowsSummaryCallback (*state, firstPendingEvent);
+            firstPendingEvent = 0;
+        } else if (dirty) {
+            wm::traceInstant ("throttled");
+        }
+    }
+
+    bool lost = xcb_connection_has_error (conn);
+    xcb_disconnect (conn);
+
+    // Lost the server: stop for good instead of leaving `monitoring` set with
+    // nothing behind it. Releasing the function finalizes it on the JS thread,
+    // which joins this thread; the next start connects again.
+    if (lost && state->monitoring.exchange (false)) state->tsfn.Release ();
+}
+
+Napi::Value startWindowsMonitoring (const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env ();
+    AddonState& state = addonState (env);
+
+    if (info.Length () < 1 || !info[0].IsFunction ()) {
+        Napi::TypeError::New (env, "Function callback expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    // Calling again while running only updates what gets delivered
+    if (!readMonitorOptions (info, state.monitorOptions)) {
+        return env.Undefined ();
+    }
+    if (state.monitoring) {
+        char wake = 1;
+        if (write (state.wakePipe[1], &wake, 1) < 0) {
+            std::cerr << "Failed to wake window monitoring thread" << std::endl;
+        }
+        return env.Undefined ();
+    }
+
+    // A monitor that lost its connection stopped on its own; reap its thread
+    if (state.monitorThread.joinable ()) state.stopMonitor ();
+
+    // Atoms are interned on the shared connection and reused by the monitor
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        if (!sharedConnection ()) {
+            Napi::Error::New (env, "Cannot open X display").ThrowAsJavaScriptException ();
+            return env.Undefined ();
+        }
+    }
+
+    // The monitor listens on a connection of its own
+    int screenNumber = 0;
+    xcb_connection_t* conn = xcb_connect (NULL, &screenNumber);
+    if (xcb_connection_has_error (conn)) {
+        xcb_disconnect (conn);
+        Napi::Error::New (env, "Cannot open X connection for window monitoring").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    if (pipe2 (state.wakePipe, O_CLOEXEC) != 0) {
+        xcb_disconnect (conn);
+        Napi::Error::New (env, "Cannot create monitor wake pipe").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    Napi::Function callback = info[0].As<Napi::Function> ();
+
+    // The finalizer also runs when the environment shuts down, e.g. a worker
+    // exiting while it monitors; the thread has to be gone before the function
+    AddonState* owner = &state;
+    uint64_t generation = ++state.generation;
+    state.tsfn = Napi::ThreadSafeFunction::New (env, callback, "WindowsMonitoringCallback", 0, 1,
+                                                [owner, generation] (Napi::Env) {
+                                                    if (owner->generation == generation) owner->stopMonitor ();
+                                                });
+
+    state.differ.reset ();
+    state.initialSummarySent = false;
+    state.lastActiveWindow = 0;
+    state.mailbox.open ();
+    state.monitoring = true;
+
+    // Start the monitor thread
+    state.monitorThread = std::thread (MonitorThreadProc, owner, conn, screenNumber);
+
+    return env.Undefined ();
+}
+
+// Stops and joins the monitor thread; the caller releases the function.
+// Does nothing if no monitor runs.
+void AddonState::stopMonitor () {
+    if (!monitoring.exchange (false) && !monitorThread.joinable ()) {
+        return;
+    }
+
+    // Signal thread to exit
+    char wake = 1;
+    if (wakePipe[1] >= 0 && write (wakePipe[1], &wake, 1) < 0) {
+        std::cerr << "Failed to wake window monitoring thread" << std::endl;
+    }
+    // Releases the thread if it is blocked on a full queue
+    mailbox.close ();
+
+    if (monitorThread.joinable ()) {
+        monitorThread.join ();
+    }
+
+    if (wakePipe[0] >= 0) {
+        close (wakePipe[0]);
+        close (wakePipe[1]);
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+
+    // Nothing keeps the index current any more
+    spatialIndex.set (nullptr);
+}
+
+Napi::Value stopWindowsMonitoring (const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env ();
+    AddonState& state = addonState (env);
+
+    if (!state.monitoring) {
+        return env.Undefined ();
+    }
+
+    state.stopMonitor ();
+    if (state.tsfn) {
+        state.tsfn.Release ();
+    }
+
+    return env.Undefined ();
+}
+
+Napi::Value windowAt (const Napi::CallbackInfo& info) {
+    AddonState& state = addonState (info.Env ());
+    return queryWindowAt (info, state.spatialIndex,
+                          [&state] { return collectSharedWindowsSummary (*state.windowFilter.get ()); });
+}
+
+Napi::Value windowsIntersecting (const Napi::CallbackInfo& info) {
+    AddonState& state = addonState (info.Env ());
+    return queryWindowsIntersecting (info, state.spatialIndex,
+                                     [&state] { return collectSharedWindowsSummary (*state.windowFilter.get ()); });
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    exports.Set("getProcessMainWindow", Napi::Function::New(env, getProcessMainWindow));
-    exports.Set("createProcess", Napi::Function::New(env, createProcess));
-    exports.Set("getActiveWindow", Napi::Function::New(env, getActiveWindow));
-    exports.Set("getWindowBounds", Napi::Function::New(env, getWindowBounds));
-    exports.Set("setWindowBounds", Napi::Function::New(env, setWindowBounds));
-    exports.Set("showWindow", Napi::Function::New(env, showWindow));
-    exports.Set("isWindow", Napi::Function::New(env, isWindow));
-    exports.Set("getWindowZOrder", Napi::Function::New(env, getWindowZOrder));
+#ifndef WM_BACKEND_XCB
+    // The shared display may be used from the monitoring thread as well.
+    static std::once_flag threadsInitialised;
+    std::call_once (threadsInitialised, [] () { XInitThreads (); });
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock (g_displayMutex);
+        ++g_displayUsers;
+    }
+    env.AddCleanupHook (releaseDisplay);
+    // Deleted with the environment, after the monitor's finalizer stopped it
+    AddonState* state = new AddonState ();
+    env.SetInstanceData (state);
+    NativeWindow::Init (env, exports, *state);
+
+    exportFunction (exports, "getProcessMainWindow", getProcessMainWindow);
+    exportFunction (exports, "createProcess", createProcess);
+    exportFunction (exports, "getActiveWindow", getActiveWindow);
+    exportFunction (exports, "initWindow", initWindow);
+    exportFunction (exports, "getProcessCacheStats", getProcessCacheStats);
+    exportFunction (exports, "getStats", getStats);
+    exportFunction (exports, "resetStats", resetStats);
+    exportFunction (exports, "startTracing", startTracing);
+    exportFunction (exports, "stopTracing", stopTracing);
+    exportFunction (exports, "dumpTrace", dumpTrace);
+    exportFunction (exports, "getMonitors", getMonitors);
+    exportFunction (exports, "getMonitorFromWindow", getMonitorFromWindow);
+    exportFunction (exports, "getMonitorInfo", getMonitorInfo);
+    exportFunction (exports, "getMonitorScaleFactor", getMonitorScaleFactor);
+    exportFunction (exports, "getWindowScaleFactor", getWindowScaleFactor);
+    exportFunction (exports, "getWindowBounds", getWindowBounds);
+    exportFunction (exports, "setWindowBounds", setWindowBounds);
+    exportFunction (exports, "showWindow", showWindow);
+    exportFunction (exports, "applyLayout", applyLayout);
+    exportFunction (exports, "tileWindows", tileWindows);
+    exportFunction (exports, "isWindow", isWindow);
+    exportFunction (exports, "getWindowZOrder", getWindowZOrder);
+    exportFunction (exports, "getWindowsSummary", getWindowsSummary);
+    exportFunction (exports, "getWindowsSummaryBinary", getWindowsSummaryBinary);
+    exportFunction (exports, "setWindowFilters", setWindowFilters);
+    exportFunction (exports, "getWindows", getWindows);
+    exportFunction (exports, "getWindowsAsync", getWindowsAsync);
+    exportFunction (exports, "getWindowsSummaryAsync", getWindowsSummaryAsync);
+    exportFunction (exports, "getWindowsSummaryBinaryAsync", getWindowsSummaryBinaryAsync);
+    exportFunction (exports, "windowAt", windowAt);
+    exportFunction (exports, "windowsIntersecting", windowsIntersecting);
+    exportFunction (exports, "startWindowsMonitoring", startWindowsMonitoring);
+    exportFunction (exports, "stopWindowsMonitoring", stopWindowsMonitoring);
     return exports;
 }
 
@@ -4,22 +4,22 @@
 #include <napi.h>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <thread>
 #include <fstream>
 #include <iostream>
 #include <atomic>
+#include <mutex>
 
-extern "C" AXError _AXUIElementGetWindow(AXUIElementRef, CGWindowID* out);
+#include "window_summary.h"
 
-// CGWindowID to AXUIElementRef windows map
-std::map<int, AXUIElementRef> windowsMap;
+extern "C" AXError _AXUIElementGetWindow(AXUIElementRef, CGWindowID* out);
 
-// Global variables for window monitoring
-static std::thread g_monitoringThread;
-static std::atomic<bool> g_monitoring(false);
-static Napi::ThreadSafeFunction g_tsfn;
-static std::vector<Napi::Object> g_lastWindowState;
+// CGWindowID to AXUIElementRef windows map. Shared by every environment,
+// so it is only touched under the lock.
+static std::map<int, AXUIElementRef> windowsMap;
+static std::mutex windowsMapMutex;
 
 bool _requestAccessibility(bool showDialog) {
   NSDictionary* opts = @{static_cast<id> (kAXTrustedCheckOptionPrompt): showDialog ? @YES : @NO};
@@ -91,10 +91,24 @@ AXUIElementRef getAXWindow(int pid, int handle) {
   return NULL;
 }
 
+static AXUIElementRef cachedAXWindow(int handle) {
+  std::lock_guard<std::mutex> lock(windowsMapMutex);
+  auto it = windowsMap.find(handle);
+  return it != windowsMap.end() ? it->second : NULL;
+}
+
 void cacheWindow(int handle, int pid) {
   if (_requestAccessibility(false)) {
-    if (windowsMap.find(handle) == windowsMap.end()) {
-      windowsMap[handle] = getAXWindow(pid, handle);
+    if (cachedAXWindow(handle)) return;
+
+    // Looked up without the lock; another thread may have won meanwhile
+    AXUIElementRef window = getAXWindow(pid, handle);
+    std::lock_guard<std::mutex> lock(windowsMapMutex);
+    AXUIElementRef& entry = windowsMap[handle];
+    if (!entry) {
+      entry = window;
+    } else if (window) {
+      CFRelease(window);
     }
   }
 }
@@ -114,47 +128,58 @@ void findAndCacheWindow(int handle) {
 }
 
 AXUIElementRef getAXWindowById(int handle) {
-  auto win = windowsMap[handle];
+  auto win = cachedAXWindow(handle);
 
   if (!win) {
     findAndCacheWindow(handle);
-    win = windowsMap[handle];
+    win = cachedAXWindow(handle);
   }
 
   return win;
 }
 
-Napi::Array getWindows(const Napi::CallbackInfo &info) {
-  Napi::Env env{info.Env()};
+// Fills processId, path and className from the window list entry `wInfo`
+static void fillWindowInfo(WindowInfo &window, NSDictionary *wInfo) {
+  NSNumber *ownerPid = wInfo[(id)kCGWindowOwnerPID];
+  window.valid = true;
+  window.processId = [ownerPid intValue];
 
-  CGWindowListOption listOptions = kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements;
-  CFArrayRef windowList = CGWindowListCopyWindowInfo(listOptions, kCGNullWindowID);
-
-  std::vector<Napi::Number> vec;
-
-  for (NSDictionary *info in (NSArray *)windowList) {
-    NSNumber *ownerPid = info[(id)kCGWindowOwnerPID];
-    NSNumber *windowNumber = info[(id)kCGWindowNumber];
+  auto app = [NSRunningApplication runningApplicationWithProcessIdentifier: [ownerPid intValue]];
+  if (app && app.bundleURL && app.bundleURL.path) window.path = [app.bundleURL.path UTF8String];
+  if (app && app.bundleIdentifier) window.className = [app.bundleIdentifier UTF8String];
+}
 
-    auto app = [NSRunningApplication runningApplicationWithProcessIdentifier: [ownerPid intValue]];
-    auto path = (app && app.bundleURL && app.bundleURL.path) ? [app.bundleURL.path UTF8String] : "";
+WindowInfo loadWindowInfo(int64_t id) {
+  WindowInfo window{};
+  window.id = id;
 
-     if (app && strcmp(path, "") != 0)  {
-      vec.push_back(Napi::Number::New(env, [windowNumber intValue]));
-    }
+  auto wInfo = getWindowInfo(static_cast<int>(id));
+  if (wInfo) {
+    fillWindowInfo(window, wInfo);
+    CFRelease((CFPropertyListRef)wInfo);
   }
+  return window;
+}
+
+// One pass over the window list, instead of a list copy per window
+std::vector<WindowInfo> collectWindowInfos() {
+  CGWindowListOption listOptions = kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements;
+  CFArrayRef windowList = CGWindowListCopyWindowInfo(listOptions, kCGNullWindowID);
 
-  auto arr = Napi::Array::New(env, vec.size());
+  std::vector<WindowInfo> windows;
 
-  for (size_t i = 0; i < vec.size(); i++) {
-    arr[i] = vec[i];
+  for (NSDictionary *info in (NSArray *)windowList) {
+    WindowInfo window{};
+    window.id = [info[(id)kCGWindowNumber] intValue];
+    fillWindowInfo(window, info);
+    if (!window.path.empty()) windows.push_back(std::move(window));
   }
 
   if (windowList) {
     CFRelease(windowList);
   }
-  
-  return arr;
+
+  return windows;
 }
 
 Napi::Number getActiveWindow(const Napi::CallbackInfo &info) {
@@ -185,6 +210,20 @@ Napi::Number getActiveWindow(const Napi::CallbackInfo &info) {
   return Napi::Number::New(env, 0);
 }
 
+// Whether the window is still on screen; NativeWindow.valid is only a
+// snapshot
+Napi::Boolean isWindow(const Napi::CallbackInfo &info) {
+  Napi::Env env{info.Env()};
+
+  int handle = info[0].As<Napi::Number>().Int32Value();
+
+  auto wInfo = getWindowInfo(handle);
+  bool exists = wInfo != NULL;
+  if (exists) CFRelease((CFPropertyListRef)wInfo);
+
+  return Napi::Boolean::New(env, exists);
+}
+
 Napi::Object initWindow(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
 
@@ -312,6 +351,125 @@ Napi::Boolean bringWindowToTop(const Napi::CallbackInfo &info) {
   return Napi::Boolean::New(env, true);
 }
 
+// Reads a kAXValueCGPointType or kAXValueCGSizeType attribute of `win`
+static bool copyAXValue(AXUIElementRef win, CFStringRef attribute, AXValueType type, void *out) {
+  CFTypeRef value = NULL;
+  if (AXUIElementCopyAttributeValue(win, attribute, &value) != kAXErrorSuccess || !value) return false;
+  bool ok = AXValueGetValue((AXValueRef)value, type, out);
+  CFRelease(value);
+  return ok;
+}
+
+// The accessibility API has no batch form, so the layout is applied window
+// by window in one native call. Hiding a window minimizes it, the closest
+// per-window equivalent; the last raised window's application is activated.
+static std::vector<wm::LayoutResult> applyLayoutBatch(const std::vector<wm::LayoutChange> &changes) {
+  std::vector<wm::LayoutResult> results(changes.size());
+  AXUIElementRef activate = NULL;
+
+  for (size_t i = 0; i < changes.size(); ++i) {
+    const wm::LayoutChange &change = changes[i];
+    results[i] = {change.id, true, ""};
+
+    auto win = getAXWindowById(static_cast<int>(change.id));
+    if (!win) {
+      results[i] = {change.id, false, "Window not found or accessibility not granted"};
+      continue;
+    }
+
+    AXError error = kAXErrorSuccess;
+    auto check = [&](AXError status) {
+      if (error == kAXErrorSuccess) error = status;
+    };
+
+    if (change.visibility == wm::LAYOUT_HIDE) {
+      check(AXUIElementSetAttributeValue(win, kAXMinimizedAttribute, kCFBooleanTrue));
+    }
+
+    if (change.boundsFields & wm::LAYOUT_POSITION) {
+      CGPoint point = CGPointZero;
+      if ((change.boundsFields & wm::LAYOUT_POSITION) != wm::LAYOUT_POSITION) {
+        copyAXValue(win, kAXPositionAttribute, (AXValueType)kAXValueCGPointType, &point);
+      }
+      if (change.boundsFields & wm::LAYOUT_X) point.x = change.bounds.x;
+      if (change.boundsFields & wm::LAYOUT_Y) point.y = change.bounds.y;
+
+      AXValueRef position = AXValueCreate((AXValueType)kAXValueCGPointType, &point);
+      check(AXUIElementSetAttributeValue(win, kAXPositionAttribute, position));
+      CFRelease(position);
+    }
+
+    if (change.boundsFields & wm::LAYOUT_SIZE) {
+      CGSize size = CGSizeZero;
+      if ((change.boundsFields & wm::LAYOUT_SIZE) != wm::LAYOUT_SIZE) {
+        copyAXValue(win, kAXSizeAttribute, (AXValueType)kAXValueCGSizeType, &size);
+      }
+      if (change.boundsFields & wm::LAYOUT_WIDTH) size.width = change.bounds.width;
+      if (change.boundsFields & wm::LAYOUT_HEIGHT) size.height = change.bounds.height;
+
+      AXValueRef sizeValue = AXValueCreate((AXValueType)kAXValueCGSizeType, &size);
+      check(AXUIElementSetAttributeValue(win, kAXSizeAttribute, sizeValue));
+      CFRelease(sizeValue);
+    }
+
+    if (change.visibility == wm::LAYOUT_SHOW) {
+      check(AXUIElementSetAttributeValue(win, kAXMinimizedAttribute, kCFBooleanFalse));
+    }
+
+    if (change.raise) {
+      check(AXUIElementPerformAction(win, kAXRaiseAction));
+      activate = win;
+    }
+
+    if (error != kAXErrorSuccess) {
+      results[i] = {change.id, false, "Accessibility error " + std::to_string(error)};
+    }
+  }
+
+  pid_t pid = 0;
+  if (activate && AXUIElementGetPid(activate, &pid) == kAXErrorSuccess) {
+    auto app = AXUIElementCreateApplication(pid);
+    AXUIElementSetAttributeValue(app, kAXFrontmostAttribute, kCFBooleanTrue);
+    AXUIElementSetAttributeValue(activate, kAXMainAttribute, kCFBooleanTrue);
+    CFRelease(app);
+  }
+
+  return results;
+}
+
+Napi::Value applyLayout(const Napi::CallbackInfo &info) {
+  return applyLayoutChanges(info, applyLayoutBatch);
+}
+
+Napi::Value tileWindows(const Napi::CallbackInfo &info) {
+  return applyTiling(info, applyLayoutBatch);
+}
+
+// Visible frame (without the menu bar and Dock) of every screen, in the
+// top-left based coordinates of the window bounds. macOS exports no
+// monitors, so these are tileWindows' default work areas.
+Napi::Array getScreenWorkAreas(const Napi::CallbackInfo &info) {
+  Napi::Env env{info.Env()};
+  Napi::Array areas = Napi::Array::New(env);
+
+  @autoreleasepool {
+    NSArray<NSScreen *> *screens = [NSScreen screens];
+    if (screens.count == 0) return areas;
+
+    // Cocoa measures y upwards from the bottom of the primary screen
+    CGFloat primaryHeight = [screens[0] frame].size.height;
+    uint32_t index = 0;
+    for (NSScreen *screen in screens) {
+      NSRect frame = [screen visibleFrame];
+      wm::Rect area{(int)frame.origin.x, (int)(primaryHeight - frame.origin.y - frame.size.height),
+                    (int)frame.size.width, (int)frame.size.height};
+      areas.Set(index++, rectToObject(env, area));
+    }
+  }
+
+  return areas;
+}
+
 Napi::Boolean setWindowMinimized(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
 
@@ -373,64 +531,102 @@ Napi::Number getWindowZOrder(const Napi::CallbackInfo &info) {
   return Napi::Number::New(env, (int)count);
 }
 
-struct WindowFilter {
-    std::string executableName;
-    std::string titlePrefix;
+// Display bounds in the global coordinates of kCGWindowBounds (origin at
+// the top-left of the main display). Safe off the main thread, unlike NSScreen.
+static std::vector<wm::Rect> collectDisplayRects() {
+  CGDirectDisplayID displays[32];
+  uint32_t count = 0;
+  if (CGGetActiveDisplayList(32, displays, &count) != kCGErrorSuccess) {
+    return {};
+  }
+
+  std::vector<wm::Rect> rects;
+  for (uint32_t i = 0; i < count; i++) {
+    CGRect bounds = CGDisplayBounds(displays[i]);
+    rects.push_back({(int)bounds.origin.x, (int)bounds.origin.y, (int)bounds.size.width,
+                     (int)bounds.size.height});
+  }
+  return rects;
+}
+
+// Applications ignored in the window summary until setWindowFilters
+// replaces the rules
+static const std::vector<wm::FilterRule> IGNORE_LIST = {
+    wm::FilterRule::exeWithTitlePrefix("xeester.app", "XEESTER:"),
+    wm::FilterRule::exeWithTitlePrefix("PokerTracker4.app", "MVS "),
+    wm::FilterRule::exeWithTitlePrefix("PokerTrackerHud4.app", "PokerTrackerHud4")
 };
 
-// List of applications to ignore in the window summary
-static const std::vector<WindowFilter> IGNORE_LIST = {
-    { "xeester.app", "XEESTER:" },
-    { "PokerTracker4.app", "MVS " },
-    { "PokerTrackerHud4.app", "PokerTrackerHud4" }
+// Per-environment state; see EnvState
+struct AddonState : EnvState {
+  AddonState() : EnvState(IGNORE_LIST) {}
+  ~AddonState() {
+    stopMonitor();
+    stopDragMonitor();
+  }
+
+  void stopMonitor();
+  void stopDragMonitor();
+
+  std::thread monitoringThread;
+
+  // Drag-crossed-monitor detection; the event handler runs on the main
+  // run loop
+  id dragMonitor = nil;
+  Napi::ThreadSafeFunction dragCrossedMonitorTsfn;
+  NSInteger lastScreenHash = 0;
+  NSInteger dragStartScreenHash = 0;
+  BOOL isDragging = NO;
+  BOOL didCrossMonitor = NO;
 };
 
-bool shouldIgnoreWindow(const char* pathStr, const char* titleStr) {
-    if (!pathStr || !titleStr) return false;
-    
-    std::string path(pathStr);
-    std::string title(titleStr);
-    
-    // Extract filename from path
-    size_t lastSep = path.find_last_of("/");
-    std::string filename = (lastSep != std::string::npos) ? path.substr(lastSep + 1) : path;
-    
-    for (const auto& filter : IGNORE_LIST) {
-        // Exact match for macOS app names usually preferred
-        if (filename == filter.executableName) {
-            // Check title prefix
-             if (title.length() >= filter.titlePrefix.length() &&
-                title.compare(0, filter.titlePrefix.length(), filter.titlePrefix) == 0) {
-                return true;
-            }
-        }
-    }
-    return false;
+static AddonState &addonState(Napi::Env env) {
+  return *env.GetInstanceData<AddonState>();
 }
 
-// Helper function to build windows summary
-Napi::Array buildWindowsSummary(Napi::Env env) {
+Napi::Value setWindowFilters(const Napi::CallbackInfo &info) {
+  return applyWindowFilters(info, addonState(info.Env()).windowFilter);
+}
+
+// Collects the summary into plain records; no JS values are created here so
+// it can run on the monitoring thread. Fields outside `requested` that no
+// filter rule needs are not converted; the app path is always resolved, as
+// it decides which windows are listed whatever the fields.
+std::vector<wm::WindowRecord> collectWindowsSummary(const wm::WindowFilter &filter,
+                                                    unsigned requested = wm::SUMMARY_ALL) {
+  wm::ScopedTimer timer(wm::TIMER_COLLECT);
+  const unsigned fields = wm::summaryFieldsToCollect(requested, filter.fields());
+
   CGWindowListOption listOptions = kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements;
   CFArrayRef windowList = CGWindowListCopyWindowInfo(listOptions, kCGNullWindowID);
+  wm::stats().add(wm::STAT_NATIVE_CALLS);
 
   if (!windowList) {
-    return Napi::Array::New(env, 0);
+    return {};
   }
 
   // Build Z-order map (front to back, so index 0 = Z-order 0)
-  std::map<int, int> zOrderMap;
   CFIndex totalWindows = CFArrayGetCount(windowList);
-  for (CFIndex i = 0; i < totalWindows; i++) {
-    NSDictionary *info = (NSDictionary *)CFArrayGetValueAtIndex(windowList, i);
-    NSNumber *windowNumber = info[(id)kCGWindowNumber];
-    if (windowNumber) {
-      zOrderMap[[windowNumber intValue]] = (int)i;
+  std::vector<int64_t> stack;
+  if (fields & wm::SUMMARY_Z_ORDER) {
+    stack.reserve(totalWindows);
+    for (CFIndex i = 0; i < totalWindows; i++) {
+      NSDictionary *info = (NSDictionary *)CFArrayGetValueAtIndex(windowList, i);
+      NSNumber *windowNumber = info[(id)kCGWindowNumber];
+      if (windowNumber) {
+        stack.push_back([windowNumber intValue]);
+      }
     }
   }
+  wm::ZOrderMap zOrderMap = wm::ZOrderMap::fromTopDown(stack);
 
-  std::vector<Napi::Object> results;
+  std::vector<wm::WindowRecord> results;
   results.reserve(totalWindows);
 
+  // Bundle path per pid, empty for processes without one; one
+  // NSRunningApplication lookup per app instead of per window
+  std::unordered_map<int, std::string> appPaths;
+
   for (NSDictionary *info in (NSArray *)windowList) {
     NSNumber *ownerPid = info[(id)kCGWindowOwnerPID];
     NSNumber *windowNumber = info[(id)kCGWindowNumber];
@@ -440,12 +636,11 @@ Napi::Array buildWindowsSummary(Napi::Env env) {
     int handle = [windowNumber intValue];
     int pid = [ownerPid intValue];
 
-    // Get app info
-    NSRunningApplication *app = [NSRunningApplication runningApplicationWithProcessIdentifier:pid];
-    if (!app || !app.bundleURL || !app.bundleURL.path) continue;
-
-    const char* path = [app.bundleURL.path UTF8String];
-    if (!path || strcmp(path, "") == 0) continue;
+    // Get bounds
+    CGRect bounds;
+    if (!CGRectMakeWithDictionaryRepresentation((CFDictionaryRef)info[(id)kCGWindowBounds], &bounds)) {
+      continue;
+    }
 
     // Get title (try kCGWindowName first, fallback to kCGWindowOwnerName)
     NSString *windowName = info[(id)kCGWindowName];
@@ -454,17 +649,38 @@ Napi::Array buildWindowsSummary(Napi::Env env) {
     }
     if (!windowName || [windowName length] == 0) continue;
 
-    const char* title = [windowName UTF8String];
-    if (!title || strcmp(title, "") == 0) continue;
-
-    // Apply filters
-    if (shouldIgnoreWindow(path, title)) continue;
+    wm::WindowRecord summary{};
+    if (fields & wm::SUMMARY_TITLE) {
+      const char* title = [windowName UTF8String];
+      if (!title || strcmp(title, "") == 0) continue;
+      summary.title = title;
+    }
 
-    // Get bounds
-    CGRect bounds;
-    if (!CGRectMakeWithDictionaryRepresentation((CFDictionaryRef)info[(id)kCGWindowBounds], &bounds)) {
-      continue;
+    summary.id = handle;
+    summary.processId = pid;
+    summary.bounds.x = (int)bounds.origin.x;
+    summary.bounds.y = (int)bounds.origin.y;
+    summary.bounds.width = (int)bounds.size.width;
+    summary.bounds.height = (int)bounds.size.height;
+
+    // Everything but the app path comes with the window list, so only
+    // executable rules have to wait for NSRunningApplication
+    unsigned available = wm::FILTER_PID | wm::FILTER_BOUNDS | wm::FILTER_TITLE;
+    if (filter.excludes(summary, available)) continue;
+
+    // Get app info; windows of processes without a bundle path are skipped
+    // even when the path was not requested
+    auto appPath = appPaths.find(pid);
+    if (appPath == appPaths.end()) {
+      NSRunningApplication *app = [NSRunningApplication runningApplicationWithProcessIdentifier:pid];
+      wm::stats().add(wm::STAT_NATIVE_CALLS);
+      const char* path = (app && app.bundleURL && app.bundleURL.path) ? [app.bundleURL.path UTF8String] : NULL;
+      appPath = appPaths.emplace(pid, path ? path : "").first;
     }
+    if (appPath->second.empty()) continue;
+    summary.path = appPath->second;
+
+    if (filter.excludes(summary, wm::FILTER_ALL, available)) continue;
 
     // Check visibility based on window properties
     bool isVisible = true;
@@ -496,72 +712,122 @@ Napi::Array buildWindowsSummary(Napi::Env env) {
     }
 
     // Get Z-order from map
-    int zOrder = -1;
-    auto zIt = zOrderMap.find(handle);
-    if (zIt != zOrderMap.end()) {
-      zOrder = zIt->second;
-    }
-
-    // Create summary object
-    Napi::Object summary = Napi::Object::New(env);
-    summary.Set("id", Napi::Number::New(env, handle));
-    summary.Set("title", Napi::String::New(env, title));
-    summary.Set("path", Napi::String::New(env, path));
-    summary.Set("processId", Napi::Number::New(env, pid));
-
-    // Bounds
-    Napi::Object boundsObj = Napi::Object::New(env);
-    boundsObj.Set("x", Napi::Number::New(env, bounds.origin.x));
-    boundsObj.Set("y", Napi::Number::New(env, bounds.origin.y));
-    boundsObj.Set("width", Napi::Number::New(env, bounds.size.width));
-    boundsObj.Set("height", Napi::Number::New(env, bounds.size.height));
-    summary.Set("bounds", boundsObj);
+    int zOrder = zOrderMap.find(handle);
 
-    summary.Set("zOrder", Napi::Number::New(env, zOrder));
-    summary.Set("isVisible", Napi::Boolean::New(env, isVisible));
+    summary.zOrder = zOrder;
+    summary.isVisible = isVisible;
 
-    results.push_back(summary);
+    results.push_back(std::move(summary));
   }
 
   CFRelease(windowList);
 
-  // Convert vector to Napi::Array
-  auto arr = Napi::Array::New(env, results.size());
-  for (size_t i = 0; i < results.size(); i++) {
-    arr[i] = results[i];
+  if (fields & wm::SUMMARY_VISIBLE_REGION) {
+    wm::computeVisibleRegions(results, collectDisplayRects());
+  }
+  // Core Graphics bounds are in points, which are logical already
+  if (fields & wm::SUMMARY_LOGICAL_BOUNDS) {
+    wm::computeLogicalBounds(results, {});
   }
 
-  return arr;
+  wm::projectWindowRecords(results, requested);
+  return results;
 }
 
-Napi::Array getWindowsSummary(const Napi::CallbackInfo &info) {
+// Helper function to build windows summary
+Napi::Array buildWindowsSummary(Napi::Env env, unsigned fields) {
+  auto filter = addonState(env).windowFilter.get();
+  return windowRecordsToArray(env, collectWindowsSummary(*filter, fields), fields);
+}
+
+Napi::Value getWindowsSummary(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
-  return buildWindowsSummary(env);
+  unsigned fields;
+  if (!readSummaryFields(info, 0, fields)) return env.Undefined();
+  return buildWindowsSummary(env, fields);
 }
 
-// Helper to compare window states
-bool windowStateChanged(const Napi::Array& current, const std::vector<Napi::Object>& previous) {
-  if (current.Length() != previous.size()) {
-    return true;
+Napi::Value getWindowsSummaryBinary(const Napi::CallbackInfo &info) {
+  Napi::Env env{info.Env()};
+  unsigned fields;
+  if (!readSummaryFields(info, 0, fields)) return env.Undefined();
+  auto filter = addonState(env).windowFilter.get();
+  return windowRecordsToArrayBuffer(env, collectWindowsSummary(*filter, fields));
+}
+
+// Thread-pool entry points for the async variants; Cocoa objects created off
+// the main thread need their own autorelease pool
+static std::vector<WindowInfo> collectWindowInfosInPool() {
+  @autoreleasepool {
+    return collectWindowInfos();
   }
-  
-  // Simple comparison - could be more sophisticated
-  // For now, just check if the number of windows changed
-  // In practice, the event system will fire on any change
-  return true;
+}
+
+static std::vector<wm::WindowRecord> collectWindowsSummaryInPool(const wm::WindowFilter &filter, unsigned fields) {
+  @autoreleasepool {
+    return collectWindowsSummary(filter, fields);
+  }
+}
+
+Napi::Array getWindows(const Napi::CallbackInfo &info) {
+  Napi::Env env{info.Env()};
+  return NativeWindow::fromInfos(env, addonState(env), collectWindowInfos());
+}
+
+Napi::Promise getWindowsAsync(const Napi::CallbackInfo &info) {
+  return queueCollect<std::vector<WindowInfo>>(info.Env(), collectWindowInfosInPool,
+                                               [](Napi::Env env, const std::vector<WindowInfo> &windows) {
+                                                 return NativeWindow::fromInfos(env, addonState(env), windows);
+                                               });
+}
+
+Napi::Value getWindowsSummaryAsync(const Napi::CallbackInfo &info) {
+  unsigned fields;
+  if (!readSummaryFields(info, 0, fields)) return info.Env().Undefined();
+  // The rules in force now, even if they are replaced before the worker runs
+  auto filter = addonState(info.Env()).windowFilter.get();
+  return queueCollect<std::vector<wm::WindowRecord>>(
+      info.Env(), [filter, fields] { return collectWindowsSummaryInPool(*filter, fields); },
+      [fields](Napi::Env env, const std::vector<wm::WindowRecord> &windows) {
+        return windowRecordsToArray(env, windows, fields);
+      });
+}
+
+Napi::Value getWindowsSummaryBinaryAsync(const Napi::CallbackInfo &info) {
+  unsigned fields;
+  if (!readSummaryFields(info, 0, fields)) return info.Env().Undefined();
+  auto filter = addonState(info.Env()).windowFilter.get();
+  return queueCollect<std::vector<uint8_t>>(
+      info.Env(), [filter, fields] { return wm::serializeWindowColumns(collectWindowsSummaryInPool(*filter, fields)); },
+      marshalBytes);
 }
 
 // Monitoring thread function
-void monitoringThreadFunc() {
-  while (g_monitoring) {
-    if (g_tsfn) {
-      auto callback = [](Napi::Env env, Napi::Function jsCallback) {
-        Napi::Array summaries = buildWindowsSummary(env);
-        jsCallback.Call({ summaries });
-      };
-      
-      napi_status status = g_tsfn.NonBlockingCall(callback);
-      if (status != napi_ok) {
+void monitoringThreadFunc(AddonState *state) {
+  wm::tracer().nameThread("poll monitor");
+  while (state->monitoring) {
+    if (state->tsfn) {
+      // Every poll is an event that calls for a snapshot
+      wm::stats().add(wm::STAT_MONITOR_EVENTS);
+      wm::stats().add(wm::STAT_MONITOR_RELEVANT_EVENTS);
+      MonitorTrace trace = MonitorTrace::begin();
+
+      // Collect and diff here; only the marshalling runs on the JS thread
+      MonitorUpdate* update = nullptr;
+      @autoreleasepool {
+        std::vector<wm::WindowRecord> snapshot;
+        {
+          wm::TraceScope scope("collect", trace.id);
+          snapshot = collectWindowsSummary(*state->windowFilter.get());
+          state->spatialIndex.set(std::make_shared<wm::SpatialIndex>(snapshot));
+        }
+        update = makeMonitorUpdate(state->differ, state->initialSummarySent, std::move(snapshot),
+                                   state->monitorOptions, trace);
+      }
+
+      // Refused only once stopping has closed the mailbox, or if the
+      // function is gone
+      if (update && !state->mailbox.post(state->tsfn, update, state->monitorOptions) && state->monitoring) {
         std::cerr << "Failed to call JS callback from monitoring thread" << std::endl;
       }
     }
@@ -571,14 +837,6 @@ void monitoringThreadFunc() {
   }
 }
 
-// Drag-crossed-monitor detection
-static id g_dragMonitor = nil;
-static Napi::ThreadSafeFunction g_dragCrossedMonitorTsfn;
-static NSInteger g_lastScreenHash = 0;
-static NSInteger g_dragStartScreenHash = 0;
-static BOOL g_isDragging = NO;
-static BOOL g_didCrossMonitor = NO;
-
 // Helper to compute screen hash
 NSInteger computeScreenHash(NSPoint mouseLocation) {
   @autoreleasepool {
@@ -595,8 +853,9 @@ NSInteger computeScreenHash(NSPoint mouseLocation) {
 
 Napi::Value startDragCrossedMonitorMonitoring(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
+  AddonState *state = &addonState(env);
   
-  if (g_dragMonitor != nil) {
+  if (state->dragMonitor != nil) {
     return env.Undefined();
   }
   
@@ -608,7 +867,7 @@ Napi::Value startDragCrossedMonitorMonitoring(const Napi::CallbackInfo &info) {
   Napi::Function callback = info[0].As<Napi::Function>();
   
   // Create thread-safe function
-  g_dragCrossedMonitorTsfn = Napi::ThreadSafeFunction::New(
+  state->dragCrossedMonitorTsfn = Napi::ThreadSafeFunction::New(
     env,
     callback,
     "DragCrossedMonitorCallback",
@@ -620,37 +879,37 @@ Napi::Value startDragCrossedMonitorMonitoring(const Napi::CallbackInfo &info) {
   );
   
   // Install global event monitor
-  g_dragMonitor = [NSEvent addGlobalMonitorForEventsMatchingMask:(NSEventMaskLeftMouseDragged | NSEventMaskLeftMouseUp)
+  state->dragMonitor = [NSEvent addGlobalMonitorForEventsMatchingMask:(NSEventMaskLeftMouseDragged | NSEventMaskLeftMouseUp)
     handler:^(NSEvent *event) {
       @autoreleasepool {
         NSPoint mouseLocation = [NSEvent mouseLocation];
         NSInteger currentScreenHash = computeScreenHash(mouseLocation);
         
         if (event.type == NSEventTypeLeftMouseDragged) {
-          if (!g_isDragging) {
+          if (!state->isDragging) {
             // Start of drag - record starting screen
-            g_isDragging = YES;
-            g_dragStartScreenHash = currentScreenHash;
-            g_lastScreenHash = currentScreenHash;
-            g_didCrossMonitor = NO;
-          } else if (currentScreenHash != g_lastScreenHash && currentScreenHash != 0) {
+            state->isDragging = YES;
+            state->dragStartScreenHash = currentScreenHash;
+            state->lastScreenHash = currentScreenHash;
+            state->didCrossMonitor = NO;
+          } else if (currentScreenHash != state->lastScreenHash && currentScreenHash != 0) {
             // Screen changed during drag - mark that we crossed monitors
-            g_lastScreenHash = currentScreenHash;
-            g_didCrossMonitor = YES;
+            state->lastScreenHash = currentScreenHash;
+            state->didCrossMonitor = YES;
           }
         } else if (event.type == NSEventTypeLeftMouseUp) {
           // End of drag - fire callback only if we crossed monitors during drag
-          if (g_isDragging && g_didCrossMonitor) {
-            if (g_dragCrossedMonitorTsfn) {
+          if (state->isDragging && state->didCrossMonitor) {
+            if (state->dragCrossedMonitorTsfn) {
               auto callback = [](Napi::Env env, Napi::Function jsCallback) {
                 jsCallback.Call({});
               };
-              g_dragCrossedMonitorTsfn.NonBlockingCall(callback);
+              state->dragCrossedMonitorTsfn.NonBlockingCall(callback);
             }
           }
           // Reset state
-          g_isDragging = NO;
-          g_didCrossMonitor = NO;
+          state->isDragging = NO;
+          state->didCrossMonitor = NO;
         }
       }
     }];
@@ -658,19 +917,25 @@ Napi::Value startDragCrossedMonitorMonitoring(const Napi::CallbackInfo &info) {
   return env.Undefined();
 }
 
+// Removes the event monitor; the caller releases the function
+void AddonState::stopDragMonitor() {
+  if (dragMonitor != nil) {
+    [NSEvent removeMonitor:dragMonitor];
+    dragMonitor = nil;
+  }
+  
+  isDragging = NO;
+  lastScreenHash = 0;
+}
+
 Napi::Value stopDragCrossedMonitorMonitoring(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
+  AddonState &state = addonState(env);
   
-  if (g_dragMonitor != nil) {
-    [NSEvent removeMonitor:g_dragMonitor];
-    g_dragMonitor = nil;
-  }
-  
-  g_isDragging = NO;
-  g_lastScreenHash = 0;
+  state.stopDragMonitor();
   
-  if (g_dragCrossedMonitorTsfn) {
-    g_dragCrossedMonitorTsfn.Release();
+  if (state.dragCrossedMonitorTsfn) {
+    state.dragCrossedMonitorTsfn.Release();
   }
   
   return env.Undefined();
@@ -678,93 +943,142 @@ Napi::Value stopDragCrossedMonitorMonitoring(const Napi::CallbackInfo &info) {
 
 Napi::Value startWindowsMonitoring(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
+  AddonState &state = addonState(env);
   
-  if (g_monitoring) {
+  if (info.Length() < 1 || !info[0].IsFunction()) {
+    Napi::TypeError::New(env, "Function callback expected").ThrowAsJavaScriptException();
     return env.Undefined();
   }
   
-  if (info.Length() < 1 || !info[0].IsFunction()) {
-    Napi::TypeError::New(env, "Function callback expected").ThrowAsJavaScriptException();
+  // Calling again while running only updates what gets delivered
+  if (!readMonitorOptions(info, state.monitorOptions)) {
+    return env.Undefined();
+  }
+  if (state.monitoring) {
     return env.Undefined();
   }
   
   Napi::Function callback = info[0].As<Napi::Function>();
   
-  // Create thread-safe function
-  g_tsfn = Napi::ThreadSafeFunction::New(
+  // The finalizer also runs when the environment shuts down, e.g. a worker
+  // exiting while it monitors; the thread has to be gone before the function
+  AddonState *owner = &state;
+  uint64_t generation = ++state.generation;
+  state.tsfn = Napi::ThreadSafeFunction::New(
     env,
     callback,
     "WindowsMonitoringCallback",
     0,
     1,
-    [](Napi::Env) {
-      g_monitoring = false;
+    [owner, generation](Napi::Env) {
+      if (owner->generation == generation) owner->stopMonitor();
     }
   );
   
-  g_monitoring = true;
+  state.differ.reset();
+  state.initialSummarySent = false;
+  state.mailbox.open();
+  state.monitoring = true;
   
   // Start monitoring thread
-  g_monitoringThread = std::thread(monitoringThreadFunc);
+  state.monitoringThread = std::thread(monitoringThreadFunc, owner);
   
   return env.Undefined();
 }
 
+// Stops and joins the monitoring thread; the caller releases the function.
+// Does nothing if no monitor runs.
+void AddonState::stopMonitor() {
+  monitoring = false;
+  // Releases the thread if it is blocked on a full queue
+  mailbox.close();
+  
+  if (monitoringThread.joinable()) {
+    monitoringThread.join();
+  }
+
+  // Nothing keeps the index current any more
+  spatialIndex.set(nullptr);
+}
+
 Napi::Value stopWindowsMonitoring(const Napi::CallbackInfo &info) {
   Napi::Env env{info.Env()};
+  AddonState &state = addonState(env);
   
-  if (!g_monitoring) {
+  if (!state.monitoring) {
     return env.Undefined();
   }
   
-  g_monitoring = false;
+  state.stopMonitor();
   
-  if (g_monitoringThread.joinable()) {
-    g_monitoringThread.join();
-  }
-  
-  if (g_tsfn) {
-    g_tsfn.Release();
+  if (state.tsfn) {
+    state.tsfn.Release();
   }
   
   return env.Undefined();
 }
 
+// No process cache here: paths come from NSRunningApplication
+Napi::Object getStats(const Napi::CallbackInfo &info) {
+  return statsToObject(info.Env(), nullptr);
+}
+
+Napi::Value resetStats(const Napi::CallbackInfo &info) {
+  wm::stats().reset();
+  return info.Env().Undefined();
+}
+
+Napi::Value windowAt(const Napi::CallbackInfo &info) {
+  AddonState &state = addonState(info.Env());
+  return queryWindowAt(info, state.spatialIndex,
+                       [&state] { return collectWindowsSummary(*state.windowFilter.get()); });
+}
+
+Napi::Value windowsIntersecting(const Napi::CallbackInfo &info) {
+  AddonState &state = addonState(info.Env());
+  return queryWindowsIntersecting(info, state.spatialIndex,
+                                  [&state] { return collectWindowsSummary(*state.windowFilter.get()); });
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    exports.Set(Napi::String::New(env, "getWindows"),
-                Napi::Function::New(env, getWindows));
-    exports.Set(Napi::String::New(env, "getActiveWindow"),
-                Napi::Function::New(env, getActiveWindow));
-    exports.Set(Napi::String::New(env, "setWindowBounds"),
-                Napi::Function::New(env, setWindowBounds));
-    exports.Set(Napi::String::New(env, "getWindowBounds"),
-                Napi::Function::New(env, getWindowBounds));
-    exports.Set(Napi::String::New(env, "getWindowTitle"),
-                Napi::Function::New(env, getWindowTitle));
-    exports.Set(Napi::String::New(env, "getWindowName"),
-                Napi::Function::New(env, getWindowName));
-    exports.Set(Napi::String::New(env, "initWindow"),
-                Napi::Function::New(env, initWindow));
-    exports.Set(Napi::String::New(env, "bringWindowToTop"),
-                Napi::Function::New(env, bringWindowToTop));
-    exports.Set(Napi::String::New(env, "setWindowMinimized"),
-                Napi::Function::New(env, setWindowMinimized));
-    exports.Set(Napi::String::New(env, "setWindowMaximized"),
-                Napi::Function::New(env, setWindowMaximized));
-    exports.Set(Napi::String::New(env, "requestAccessibility"),
-                Napi::Function::New(env, requestAccessibility));
-    exports.Set(Napi::String::New(env, "getWindowZOrder"),
-                Napi::Function::New(env, getWindowZOrder));
-    exports.Set(Napi::String::New(env, "getWindowsSummary"),
-                Napi::Function::New(env, getWindowsSummary));
-    exports.Set(Napi::String::New(env, "startWindowsMonitoring"),
-                Napi::Function::New(env, startWindowsMonitoring));
-    exports.Set(Napi::String::New(env, "stopWindowsMonitoring"),
-                Napi::Function::New(env, stopWindowsMonitoring));
-    exports.Set(Napi::String::New(env, "startDragCrossedMonitorMonitoring"),
-                Napi::Function::New(env, startDragCrossedMonitorMonitoring));
-    exports.Set(Napi::String::New(env, "stopDragCrossedMonitorMonitoring"),
-                Napi::Function::New(env, stopDragCrossedMonitorMonitoring));
+    // Deleted with the environment, after the monitor's finalizer stopped it
+    AddonState *state = new AddonState();
+    env.SetInstanceData(state);
+    NativeWindow::Init(env, exports, *state);
+
+    exportFunction(exports, "getWindows", getWindows);
+    exportFunction(exports, "getActiveWindow", getActiveWindow);
+    exportFunction(exports, "setWindowBounds", setWindowBounds);
+    exportFunction(exports, "applyLayout", applyLayout);
+    exportFunction(exports, "tileWindows", tileWindows);
+    exportFunction(exports, "getScreenWorkAreas", getScreenWorkAreas);
+    exportFunction(exports, "getWindowBounds", getWindowBounds);
+    exportFunction(exports, "getWindowTitle", getWindowTitle);
+    exportFunction(exports, "getWindowName", getWindowName);
+    exportFunction(exports, "initWindow", initWindow);
+    exportFunction(exports, "isWindow", isWindow);
+    exportFunction(exports, "bringWindowToTop", bringWindowToTop);
+    exportFunction(exports, "setWindowMinimized", setWindowMinimized);
+    exportFunction(exports, "setWindowMaximized", setWindowMaximized);
+    exportFunction(exports, "requestAccessibility", requestAccessibility);
+    exportFunction(exports, "getWindowZOrder", getWindowZOrder);
+    exportFunction(exports, "getWindowsSummary", getWindowsSummary);
+    exportFunction(exports, "getWindowsSummaryBinary", getWindowsSummaryBinary);
+    exportFunction(exports, "setWindowFilters", setWindowFilters);
+    exportFunction(exports, "getStats", getStats);
+    exportFunction(exports, "resetStats", resetStats);
+    exportFunction(exports, "startTracing", startTracing);
+    exportFunction(exports, "stopTracing", stopTracing);
+    exportFunction(exports, "dumpTrace", dumpTrace);
+    exportFunction(exports, "getWindowsAsync", getWindowsAsync);
+    exportFunction(exports, "getWindowsSummaryAsync", getWindowsSummaryAsync);
+    exportFunction(exports, "getWindowsSummaryBinaryAsync", getWindowsSummaryBinaryAsync);
+    exportFunction(exports, "windowAt", windowAt);
+    exportFunction(exports, "windowsIntersecting", windowsIntersecting);
+    exportFunction(exports, "startWindowsMonitoring", startWindowsMonitoring);
+    exportFunction(exports, "stopWindowsMonitoring", stopWindowsMonitoring);
+    exportFunction(exports, "startDragCrossedMonitorMonitoring", startDragCrossedMonitorMonitoring);
+    exportFunction(exports, "stopDragCrossedMonitorMonitoring", stopDragCrossedMonitorMonitoring);
 
     return exports;
 }
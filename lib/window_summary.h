@@ -0,0 +1,1096 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <napi.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/layout.h"
+#include "core/monitors.h"
+#include "core/process_cache.h"
+#include "core/spatial_index.h"
+#include "core/stats.h"
+#include "core/summary_fields.h"
+#include "core/tiling.h"
+#include "core/trace.h"
+#include "core/visible_region.h"
+#include "core/window_columns.h"
+#include "core/window_diff.h"
+#include "core/window_filter.h"
+#include "core/z_order.h"
+
+// N-API marshalling of lib/core types, shared by every platform backend.
+
+inline Napi::Object rectToObject (Napi::Env env, const wm::Rect& rect) {
+    Napi::Object bounds = Napi::Object::New (env);
+    bounds.Set ("x", Napi::Number::New (env, rect.x));
+    bounds.Set ("y", Napi::Number::New (env, rect.y));
+    bounds.Set ("width", Napi::Number::New (env, rect.width));
+    bounds.Set ("height", Napi::Number::New (env, rect.height));
+    return bounds;
+}
+
+// { x, y, width, height }; false if `value` is not an object
+inline bool readRect (Napi::Value value, wm::Rect& rect) {
+    if (!value.IsObject ()) return false;
+    Napi::Object obj = value.As<Napi::Object> ();
+    rect.x = obj.Get ("x").ToNumber ().Int32Value ();
+    rect.y = obj.Get ("y").ToNumber ().Int32Value ();
+    rect.width = obj.Get ("width").ToNumber ().Int32Value ();
+    rect.height = obj.Get ("height").ToNumber ().Int32Value ();
+    return true;
+}
+
+// Optional { logical } argument of getWindowBounds: true asks for the
+// bounds in device-independent pixels, scaled by the window's monitor
+inline bool readLogicalOption (const Napi::CallbackInfo& info, size_t index) {
+    return info.Length () > index && info[index].IsObject () &&
+           info[index].As<Napi::Object> ().Get ("logical").ToBoolean ();
+}
+
+// Same shape as getMonitorInfo on Windows: { bounds, workArea, isPrimary }
+inline Napi::Object monitorRecordToObject (Napi::Env env, const wm::MonitorRecord& monitor) {
+    Napi::Object obj = Napi::Object::New (env);
+    obj.Set ("bounds", rectToObject (env, monitor.bounds));
+    obj.Set ("workArea", rectToObject (env, monitor.workArea));
+    obj.Set ("isPrimary", monitor.isPrimary);
+    return obj;
+}
+
+// Only the properties in `fields` (wm::SummaryField bits) are set
+inline Napi::Object windowRecordToObject (Napi::Env env,
+                                          const wm::WindowRecord& window,
+                                          unsigned fields = wm::SUMMARY_ALL) {
+    Napi::Object summary = Napi::Object::New (env);
+    if (fields & wm::SUMMARY_ID) summary.Set ("id", Napi::Number::New (env, static_cast<double> (window.id)));
+    if (fields & wm::SUMMARY_TITLE) summary.Set ("title", Napi::String::New (env, window.title));
+    if (fields & wm::SUMMARY_PATH) summary.Set ("path", Napi::String::New (env, window.path));
+    if (fields & wm::SUMMARY_PROCESS_ID) {
+        summary.Set ("processId", Napi::Number::New (env, static_cast<double> (window.processId)));
+    }
+    if (fields & wm::SUMMARY_BOUNDS) summary.Set ("bounds", rectToObject (env, window.bounds));
+    if (fields & wm::SUMMARY_Z_ORDER) summary.Set ("zOrder", Napi::Number::New (env, window.zOrder));
+    if (fields & wm::SUMMARY_IS_VISIBLE) summary.Set ("isVisible", Napi::Boolean::New (env, window.isVisible));
+    if (fields & wm::SUMMARY_VISIBLE_FRACTION) {
+        summary.Set ("visibleFraction", Napi::Number::New (env, window.visibleFraction));
+    }
+    if (fields & wm::SUMMARY_VISIBLE_RECTS) {
+        auto rects = Napi::Array::New (env, window.visibleRects.size ());
+        for (size_t i = 0; i < window.visibleRects.size (); ++i) {
+            rects.Set (i, rectToObject (env, window.visibleRects[i]));
+        }
+        summary.Set ("visibleRects", rects);
+    }
+    if (fields & wm::SUMMARY_LOGICAL_BOUNDS) summary.Set ("logicalBounds", rectToObject (env, window.logicalBounds));
+    return summary;
+}
+
+inline Napi::Array windowRecordsToArray (Napi::Env env,
+                                         const std::vector<wm::WindowRecord>& windows,
+                                         unsigned fields = wm::SUMMARY_ALL) {
+    wm::ScopedTimer timer (wm::TIMER_MARSHAL);
+    auto arr = Napi::Array::New (env, windows.size ());
+    for (size_t i = 0; i < windows.size (); ++i) {
+        arr.Set (i, windowRecordToObject (env, windows[i], fields));
+    }
+    return arr;
+}
+
+// Optional { fields: string[] } argument of the summary exports. Without it
+// every field is collected; `id` is always included. Throws and returns
+// false on an unknown field name.
+inline bool readSummaryFields (const Napi::CallbackInfo& info, size_t index, unsigned& fields) {
+    fields = wm::SUMMARY_ALL;
+    if (info.Length () <= index || !info[index].IsObject ()) return true;
+
+    Napi::Value value = info[index].As<Napi::Object> ().Get ("fields");
+    if (value.IsUndefined ()) return true;
+    if (!value.IsArray ()) {
+        Napi::TypeError::New (info.Env (), "fields must be an array of strings").ThrowAsJavaScriptException ();
+        return false;
+    }
+
+    Napi::Array names = value.As<Napi::Array> ();
+    fields = wm::SUMMARY_ID;
+    for (uint32_t i = 0; i < names.Length (); ++i) {
+        Napi::Value name = names.Get (i);
+        unsigned field = name.IsString () ? wm::summaryFieldFromName (name.As<Napi::String> ().Utf8Value ()) : 0;
+        if (field == 0) {
+            Napi::TypeError::New (info.Env (), "Unknown summary field at index " + std::to_string (i))
+            .ThrowAsJavaScriptException ();
+            return false;
+        }
+        fields |= field;
+    }
+    return true;
+}
+
+inline Napi::Array handlesToArray (Napi::Env env, const std::vector<int64_t>& handles) {
+    auto arr = Napi::Array::New (env, handles.size ());
+    for (size_t i = 0; i < handles.size (); ++i) {
+        arr.Set (i, Napi::Number::New (env, static_cast<double> (handles[i])));
+    }
+    return arr;
+}
+
+inline Napi::ArrayBuffer bytesToArrayBuffer (Napi::Env env, const std::vector<uint8_t>& bytes) {
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New (env, bytes.size ());
+    if (!bytes.empty ()) std::memcpy (buffer.Data (), bytes.data (), bytes.size ());
+    return buffer;
+}
+
+// getWindowsSummaryBinary: the columnar encoding from core/window_columns.h,
+// copied once into a fresh ArrayBuffer.
+inline Napi::ArrayBuffer windowRecordsToArrayBuffer (Napi::Env env,
+                                                     const std::vector<wm::WindowRecord>& windows) {
+    wm::ScopedTimer timer (wm::TIMER_MARSHAL);
+    return bytesToArrayBuffer (env, wm::serializeWindowColumns (windows));
+}
+
+// Promise-returning variants of the enumeration exports. `collect` runs on
+// the libuv thread pool and must not touch JS values; `marshal` converts its
+// result on the JS thread and resolves the promise. Both are the same
+// functions the synchronous exports use, or lambdas binding their arguments.
+template <typename Result>
+class CollectWorker : public Napi::AsyncWorker {
+public:
+    typedef std::function<Result ()> Collect;
+    typedef std::function<Napi::Value (Napi::Env, const Result&)> Marshal;
+
+    CollectWorker (Napi::Env env, Collect collect, Marshal marshal)
+    : Napi::AsyncWorker (env), deferred_ (Napi::Promise::Deferred::New (env)),
+      collect_ (std::move (collect)), marshal_ (std::move (marshal)) {}
+
+    Napi::Promise promise () const {
+        return deferred_.Promise ();
+    }
+
+    void Execute () override {
+        result_ = collect_ ();
+    }
+
+    void OnOK () override {
+        deferred_.Resolve (marshal_ (Env (), result_));
+    }
+
+    void OnError (const Napi::Error& error) override {
+        deferred_.Reject (error.Value ());
+    }
+
+private:
+    Napi::Promise::Deferred deferred_;
+    Collect collect_;
+    Marshal marshal_;
+    Result result_;
+};
+
+template <typename Result>
+Napi::Promise queueCollect (Napi::Env env,
+                            typename CollectWorker<Result>::Collect collect,
+                            typename CollectWorker<Result>::Marshal marshal) {
+    auto worker = new CollectWorker<Result> (env, std::move (collect), std::move (marshal));
+    Napi::Promise promise = worker->promise ();
+    worker->Queue ();
+    return promise;
+}
+
+inline Napi::Value marshalHandles (Napi::Env env, const std::vector<int64_t>& handles) {
+    return handlesToArray (env, handles);
+}
+
+inline Napi::Value marshalWindowRecords (Napi::Env env, const std::vector<wm::WindowRecord>& windows) {
+    return windowRecordsToArray (env, windows);
+}
+
+inline Napi::Value marshalBytes (Napi::Env env, const std::vector<uint8_t>& bytes) {
+    wm::ScopedTimer timer (wm::TIMER_MARSHAL);
+    return bytesToArrayBuffer (env, bytes);
+}
+
+inline Napi::Object processCacheStatsToObject (Napi::Env env, const wm::ProcessCacheStats& stats) {
+    Napi::Object obj = Napi::Object::New (env);
+    obj.Set ("hits", Napi::Number::New (env, static_cast<double> (stats.hits)));
+    obj.Set ("misses", Napi::Number::New (env, static_cast<double> (stats.misses)));
+    obj.Set ("expired", Napi::Number::New (env, static_cast<double> (stats.expired)));
+    obj.Set ("size", Napi::Number::New (env, static_cast<double> (stats.size)));
+    return obj;
+}
+
+inline Napi::Object latencyToObject (Napi::Env env, const wm::LatencySnapshot& latency) {
+    Napi::Object obj = Napi::Object::New (env);
+    obj.Set ("count", Napi::Number::New (env, static_cast<double> (latency.count)));
+    obj.Set ("meanUs", Napi::Number::New (env, latency.meanUs));
+    obj.Set ("p50Us", Napi::Number::New (env, latency.p50Us));
+    obj.Set ("p95Us", Napi::Number::New (env, latency.p95Us));
+    obj.Set ("p99Us", Napi::Number::New (env, latency.p99Us));
+    obj.Set ("maxUs", Napi::Number::New (env, latency.maxUs));
+    return obj;
+}
+
+// getStats(): { exports, nativeCalls, processCache, monitor, timings }. The
+// process cache is left out on backends without one.
+inline Napi::Object statsToObject (Napi::Env env, const wm::ProcessCacheStats* processCache) {
+    const wm::Stats& stats = wm::stats ();
+    auto count = [&] (wm::StatCounter counter) {
+        return Napi::Number::New (env, static_cast<double> (stats.counter (counter)));
+    };
+
+    Napi::Object exports = Napi::Object::New (env);
+    for (const wm::ExportStats* entry : stats.exports ()) {
+        uint64_t calls = entry->calls.load (std::memory_order_relaxed);
+        if (calls == 0) continue;
+        Napi::Object obj = Napi::Object::New (env);
+        obj.Set ("calls", Napi::Number::New (env, static_cast<double> (calls)));
+        obj.Set ("latency", latencyToObject (env, entry->latency.snapshot ()));
+        exports.Set (entry->name, obj);
+    }
+
+    // Relevant events that did not get a snapshot of their own
+    uint64_t relevant = stats.counter (wm::STAT_MONITOR_RELEVANT_EVENTS);
+    uint64_t refreshes = stats.counter (wm::STAT_MONITOR_REFRESHES);
+    Napi::Object monitor = Napi::Object::New (env);
+    monitor.Set ("eventsReceived", count (wm::STAT_MONITOR_EVENTS));
+    monitor.Set ("eventsRelevant", count (wm::STAT_MONITOR_RELEVANT_EVENTS));
+    monitor.Set ("eventsCoalesced",
+                 Napi::Number::New (env, static_cast<double> (relevant > refreshes ? relevant - refreshes : 0)));
+    monitor.Set ("refreshes", count (wm::STAT_MONITOR_REFRESHES));
+    monitor.Set ("refreshesUnchanged", count (wm::STAT_MONITOR_UNCHANGED));
+    monitor.Set ("updatesDispatched", count (wm::STAT_MONITOR_DISPATCHED));
+    monitor.Set ("updatesMerged", count (wm::STAT_MONITOR_MERGED));
+    monitor.Set ("updatesDropped", count (wm::STAT_MONITOR_DROPPED));
+
+    Napi::Object timings = Napi::Object::New (env);
+    timings.Set ("collect", latencyToObject (env, stats.timer (wm::TIMER_COLLECT).snapshot ()));
+    timings.Set ("marshal", latencyToObject (env, stats.timer (wm::TIMER_MARSHAL).snapshot ()));
+    timings.Set ("callback", latencyToObject (env, stats.timer (wm::TIMER_CALLBACK).snapshot ()));
+
+    Napi::Object obj = Napi::Object::New (env);
+    obj.Set ("exports", exports);
+    obj.Set ("nativeCalls", count (wm::STAT_NATIVE_CALLS));
+    if (processCache) obj.Set ("processCache", processCacheStatsToObject (env, *processCache));
+    obj.Set ("monitor", monitor);
+    obj.Set ("timings", timings);
+    return obj;
+}
+
+// Sets exports[name] to `fn`, counting its calls and timing them under
+// that name in getStats(). For the async exports this is the time to queue
+// the work; the collection shows up in timings.collect.
+template <typename Result>
+inline void exportFunction (Napi::Object exports, const char* name, Result (*fn) (const Napi::CallbackInfo&)) {
+    wm::ExportStats* stats = wm::stats ().exportStats (name);
+    exports.Set (name, Napi::Function::New (exports.Env (),
+                                            [stats, fn] (const Napi::CallbackInfo& info) -> Napi::Value {
+                                                stats->calls.fetch_add (1, std::memory_order_relaxed);
+                                                wm::ScopedTimer timer (stats->latency);
+                                                return fn (info);
+                                            },
+                                            name));
+}
+
+// { id, kind, oldValue, newValue }. The values depend on the kind: whole
+// summaries for created/destroyed, bounds for moved/resized, zOrder for
+// reordered, isVisible for visibility and title for retitled.
+inline Napi::Object windowDeltaToObject (Napi::Env env, const wm::WindowDelta& delta) {
+    Napi::Object obj = Napi::Object::New (env);
+    obj.Set ("id", Napi::Number::New (env, static_cast<double> (delta.id)));
+    obj.Set ("kind", Napi::String::New (env, wm::deltaKindName (delta.kind)));
+
+    switch (delta.kind) {
+    case wm::DeltaKind::Created:
+        obj.Set ("newValue", windowRecordToObject (env, delta.after));
+        break;
+    case wm::DeltaKind::Destroyed:
+        obj.Set ("oldValue", windowRecordToObject (env, delta.before));
+        break;
+    case wm::DeltaKind::Moved:
+    case wm::DeltaKind::Resized:
+        obj.Set ("oldValue", rectToObject (env, delta.before.bounds));
+        obj.Set ("newValue", rectToObject (env, delta.after.bounds));
+        break;
+    case wm::DeltaKind::Reordered:
+        obj.Set ("oldValue", Napi::Number::New (env, delta.before.zOrder));
+        obj.Set ("newValue", Napi::Number::New (env, delta.after.zOrder));
+        break;
+    case wm::DeltaKind::Visibility:
+        obj.Set ("oldValue", Napi::Boolean::New (env, delta.before.isVisible));
+        obj.Set ("newValue", Napi::Boolean::New (env, delta.after.isVisible));
+        break;
+    case wm::DeltaKind::Retitled:
+        obj.Set ("oldValue", Napi::String::New (env, delta.before.title));
+        obj.Set ("newValue", Napi::String::New (env, delta.after.title));
+        break;
+    }
+
+    return obj;
+}
+
+inline Napi::Array windowDeltasToArray (Napi::Env env, const std::vector<wm::WindowDelta>& deltas) {
+    wm::ScopedTimer timer (wm::TIMER_MARSHAL);
+    auto arr = Napi::Array::New (env, deltas.size ());
+    for (size_t i = 0; i < deltas.size (); ++i) {
+        arr.Set (i, windowDeltaToObject (env, deltas[i]));
+    }
+    return arr;
+}
+
+// windowAt(x, y) and windowsIntersecting(rect) answer from the spatial index
+// the monitor thread publishes after every refresh, so they never touch the
+// window system while monitoring runs. Without a monitor there is no index
+// to trust, and one is built from a fresh collection per call.
+typedef std::function<std::vector<wm::WindowRecord> ()> CollectSummary;
+
+inline std::shared_ptr<const wm::SpatialIndex> currentSpatialIndex (const wm::SharedSpatialIndex& shared,
+                                                                    const CollectSummary& collect) {
+    std::shared_ptr<const wm::SpatialIndex> index = shared.get ();
+    if (!index) index = std::make_shared<wm::SpatialIndex> (collect ());
+    return index;
+}
+
+inline Napi::Value queryWindowAt (const Napi::CallbackInfo& info,
+                                  const wm::SharedSpatialIndex& shared,
+                                  const CollectSummary& collect) {
+    Napi::Env env{ info.Env () };
+
+    if (info.Length () < 2 || !info[0].IsNumber () || !info[1].IsNumber ()) {
+        Napi::TypeError::New (env, "Point coordinates expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    auto index = currentSpatialIndex (shared, collect);
+    const wm::WindowRecord* window =
+    index->at (info[0].As<Napi::Number> ().Int32Value (), info[1].As<Napi::Number> ().Int32Value ());
+    return window ? Napi::Value (windowRecordToObject (env, *window)) : env.Null ();
+}
+
+inline Napi::Value queryWindowsIntersecting (const Napi::CallbackInfo& info,
+                                             const wm::SharedSpatialIndex& shared,
+                                             const CollectSummary& collect) {
+    Napi::Env env{ info.Env () };
+
+    wm::Rect rect{};
+    if (info.Length () < 1 || !readRect (info[0], rect)) {
+        Napi::TypeError::New (env, "Rectangle expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    auto index = currentSpatialIndex (shared, collect);
+    std::vector<const wm::WindowRecord*> windows = index->intersecting (rect);
+
+    auto arr = Napi::Array::New (env, windows.size ());
+    for (size_t i = 0; i < windows.size (); ++i) {
+        arr.Set (i, windowRecordToObject (env, *windows[i]));
+    }
+    return arr;
+}
+
+// setWindowFilters(rules): each rule is { exe, titlePrefix, titleSuffix,
+// titleRegex, ignoreCase, pid, minWidth, minHeight, maxWidth, maxHeight }
+// with every property optional. The whole set is compiled before it replaces
+// the active one, so an invalid rule leaves the previous filters in place.
+inline Napi::Value applyWindowFilters (const Napi::CallbackInfo& info, wm::SharedWindowFilter& target) {
+    Napi::Env env{ info.Env () };
+
+    if (info.Length () < 1 || !info[0].IsArray ()) {
+        Napi::TypeError::New (env, "Array of filter rules expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    Napi::Array array = info[0].As<Napi::Array> ();
+    std::vector<wm::FilterRule> rules (array.Length ());
+
+    for (uint32_t i = 0; i < array.Length (); ++i) {
+        Napi::Value value = array.Get (i);
+        if (!value.IsObject ()) {
+            Napi::TypeError::New (env, "Filter rule " + std::to_string (i) + " is not an object")
+            .ThrowAsJavaScriptException ();
+            return env.Undefined ();
+        }
+
+        Napi::Object obj = value.As<Napi::Object> ();
+        wm::FilterRule& rule = rules[i];
+
+        auto readString = [&] (const char* key, std::string& out) {
+            Napi::Value v = obj.Get (key);
+            if (v.IsString ()) out = v.As<Napi::String> ().Utf8Value ();
+        };
+        auto readNumber = [&] (const char* key, int64_t& out) {
+            Napi::Value v = obj.Get (key);
+            if (v.IsNumber ()) out = v.As<Napi::Number> ().Int64Value ();
+        };
+
+        int64_t minWidth = 0, minHeight = 0, maxWidth = 0, maxHeight = 0;
+        readString ("exe", rule.executableName);
+        readString ("titlePrefix", rule.titlePrefix);
+        readString ("titleSuffix", rule.titleSuffix);
+        readString ("titleRegex", rule.titlePattern);
+        readNumber ("pid", rule.processId);
+        readNumber ("minWidth", minWidth);
+        readNumber ("minHeight", minHeight);
+        readNumber ("maxWidth", maxWidth);
+        readNumber ("maxHeight", maxHeight);
+        rule.titlePatternIgnoreCase = obj.Get ("ignoreCase").ToBoolean ();
+        rule.minWidth = static_cast<int> (minWidth);
+        rule.minHeight = static_cast<int> (minHeight);
+        rule.maxWidth = static_cast<int> (maxWidth);
+        rule.maxHeight = static_cast<int> (maxHeight);
+    }
+
+    auto filter = std::make_shared<wm::WindowFilter> ();
+    size_t failedIndex = 0;
+    std::string error = wm::WindowFilter::compile (rules, *filter, failedIndex);
+    if (!error.empty ()) {
+        Napi::TypeError::New (env, "Filter rule " + std::to_string (failedIndex) + ": " + error)
+        .ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    target.set (filter);
+    return env.Undefined ();
+}
+
+// Applies a deduplicated batch and returns one result per entry, in order
+typedef std::function<std::vector<wm::LayoutResult> (const std::vector<wm::LayoutChange>&)> ApplyLayoutBatch;
+
+// Applies `changes` as one batch and returns [{ id, ok, error? }] in their
+// order
+inline Napi::Array runLayout (Napi::Env env,
+                              const std::vector<wm::LayoutChange>& changes,
+                              const ApplyLayoutBatch& apply) {
+    std::vector<uint32_t> slots;
+    std::vector<wm::LayoutResult> results = apply (wm::coalesceLayoutChanges (changes, slots));
+
+    auto arr = Napi::Array::New (env, changes.size ());
+    for (size_t i = 0; i < changes.size (); ++i) {
+        const wm::LayoutResult& result = results[slots[i]];
+        Napi::Object obj = Napi::Object::New (env);
+        obj.Set ("id", static_cast<double> (changes[i].id));
+        obj.Set ("ok", result.ok);
+        if (!result.ok) obj.Set ("error", result.error);
+        arr.Set (i, obj);
+    }
+    return arr;
+}
+
+// applyLayout([{ id, bounds?, show?, raise? }]): `bounds` may set any of x,
+// y, width and height. The entries are validated before anything is applied
+// and a TypeError leaves every window untouched. Returns [{ id, ok, error? }]
+// in the order of the entries.
+inline Napi::Value applyLayoutChanges (const Napi::CallbackInfo& info, const ApplyLayoutBatch& apply) {
+    Napi::Env env{ info.Env () };
+
+    if (info.Length () < 1 || !info[0].IsArray ()) {
+        Napi::TypeError::New (env, "Array of layout entries expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    Napi::Array array = info[0].As<Napi::Array> ();
+    std::vector<wm::LayoutChange> changes (array.Length ());
+
+    for (uint32_t i = 0; i < array.Length (); ++i) {
+        Napi::Value value = array.Get (i);
+        Napi::Value id = value.IsObject () ? value.As<Napi::Object> ().Get ("id") : env.Undefined ();
+        if (!id.IsNumber ()) {
+            Napi::TypeError::New (env, "Layout entry " + std::to_string (i) + " has no numeric id")
+            .ThrowAsJavaScriptException ();
+            return env.Undefined ();
+        }
+
+        Napi::Object obj = value.As<Napi::Object> ();
+        wm::LayoutChange& change = changes[i];
+        change = { id.As<Napi::Number> ().Int64Value (), wm::Rect{}, 0, wm::LAYOUT_KEEP, false };
+
+        Napi::Value bounds = obj.Get ("bounds");
+        if (bounds.IsObject ()) {
+            Napi::Object b = bounds.As<Napi::Object> ();
+            auto readBound = [&] (const char* key, wm::LayoutBoundsField field, int& out) {
+                Napi::Value v = b.Get (key);
+                if (!v.IsNumber ()) return;
+                out = v.As<Napi::Number> ().Int32Value ();
+                change.boundsFields |= field;
+            };
+            readBound ("x", wm::LAYOUT_X, change.bounds.x);
+            readBound ("y", wm::LAYOUT_Y, change.bounds.y);
+            readBound ("width", wm::LAYOUT_WIDTH, change.bounds.width);
+            readBound ("height", wm::LAYOUT_HEIGHT, change.bounds.height);
+        } else if (!bounds.IsUndefined ()) {
+            Napi::TypeError::New (env, "Layout entry " + std::to_string (i) + ": bounds must be an object")
+            .ThrowAsJavaScriptException ();
+            return env.Undefined ();
+        }
+
+        Napi::Value show = obj.Get ("show");
+        if (show.IsBoolean ()) change.visibility = show.As<Napi::Boolean> () ? wm::LAYOUT_SHOW : wm::LAYOUT_HIDE;
+        change.raise = obj.Get ("raise").ToBoolean ();
+    }
+
+    return runLayout (env, changes, apply);
+}
+
+// tileWindows(ids, { layout, gap, outerGap, decoration, masterRatio,
+// masterCount, columns }, workAreas): computes the tiles with wm::computeTiling
+// and applies them as one layout batch. Only `layout` is required.
+inline Napi::Value applyTiling (const Napi::CallbackInfo& info, const ApplyLayoutBatch& apply) {
+    Napi::Env env{ info.Env () };
+
+    if (info.Length () < 3 || !info[0].IsArray () || !info[1].IsObject () || !info[2].IsArray ()) {
+        Napi::TypeError::New (env, "Window ids, tiling spec and work areas expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    Napi::Array ids = info[0].As<Napi::Array> ();
+    std::vector<wm::LayoutChange> changes (ids.Length ());
+    for (uint32_t i = 0; i < ids.Length (); ++i) {
+        Napi::Value id = ids.Get (i);
+        if (!id.IsNumber ()) {
+            Napi::TypeError::New (env, "Window id " + std::to_string (i) + " is not a number")
+            .ThrowAsJavaScriptException ();
+            return env.Undefined ();
+        }
+        changes[i] = { id.As<Napi::Number> ().Int64Value (), wm::Rect{}, wm::LAYOUT_BOUNDS, wm::LAYOUT_KEEP, false };
+    }
+
+    Napi::Object obj = info[1].As<Napi::Object> ();
+    wm::TilingSpec spec{ wm::TILING_GRID, 0, 0, { 0, 0, 0, 0 }, 0.5, 1, 0 };
+
+    std::string layout = obj.Get ("layout").ToString ().Utf8Value ();
+    if (layout == "grid") {
+        spec.mode = wm::TILING_GRID;
+    } else if (layout == "master-stack") {
+        spec.mode = wm::TILING_MASTER_STACK;
+    } else if (layout == "columns") {
+        spec.mode = wm::TILING_COLUMNS;
+    } else {
+        Napi::TypeError::New (env, "Unknown layout \"" + layout + "\"").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    auto readInt = [&] (Napi::Object from, const char* key, int& out) {
+        Napi::Value v = from.Get (key);
+        if (v.IsNumber ()) out = v.As<Napi::Number> ().Int32Value ();
+    };
+    readInt (obj, "gap", spec.gap);
+    readInt (obj, "outerGap", spec.outerGap);
+    readInt (obj, "masterCount", spec.masterCount);
+    readInt (obj, "columns", spec.columns);
+    Napi::Value ratio = obj.Get ("masterRatio");
+    if (ratio.IsNumber ()) spec.masterRatio = ratio.As<Napi::Number> ().DoubleValue ();
+    Napi::Value decoration = obj.Get ("decoration");
+    if (decoration.IsObject ()) {
+        Napi::Object insets = decoration.As<Napi::Object> ();
+        readInt (insets, "left", spec.decoration.left);
+        readInt (insets, "top", spec.decoration.top);
+        readInt (insets, "right", spec.decoration.right);
+        readInt (insets, "bottom", spec.decoration.bottom);
+    }
+
+    Napi::Array array = info[2].As<Napi::Array> ();
+    std::vector<wm::Rect> areas (array.Length ());
+    for (uint32_t i = 0; i < array.Length (); ++i) {
+        if (!readRect (array.Get (i), areas[i])) {
+            Napi::TypeError::New (env, "Work area " + std::to_string (i) + " is not a rectangle")
+            .ThrowAsJavaScriptException ();
+            return env.Undefined ();
+        }
+    }
+    if (areas.empty () && !changes.empty ()) {
+        Napi::TypeError::New (env, "At least one work area expected").ThrowAsJavaScriptException ();
+        return env.Undefined ();
+    }
+
+    std::vector<wm::Rect> tiles = wm::computeTiling (spec, areas, changes.size ());
+    for (size_t i = 0; i < changes.size (); ++i) changes[i].bounds = tiles[i];
+
+    return runLayout (env, changes, apply);
+}
+
+// What happens to updates while the JS thread is still busy with earlier
+// ones: "latest" keeps a single pending update and merges newer ones into
+// it, "queue" keeps up to queueSize and merges into the last, "block"
+// stalls the monitor thread until the queue has room.
+enum MonitorDelivery { DELIVER_LATEST, DELIVER_QUEUE, DELIVER_BLOCK };
+
+// What startWindowsMonitoring(callback, options) asked for. Written on the
+// JS thread, read by the monitor thread.
+struct MonitorOptions {
+    std::atomic<bool> summaries{ true };
+    std::atomic<bool> deltas{ false };
+    // Foreground window changes, pushed as they happen
+    std::atomic<bool> activation{ false };
+    // Set when summaries are switched back on, so the next refresh sends
+    // one even if nothing changed
+    std::atomic<bool> resendSummaries{ false };
+    // Set when deltas are switched back on, so they restart from a full
+    // "created" set
+    std::atomic<bool> restartDeltas{ false };
+    std::atomic<int> delivery{ DELIVER_LATEST };
+    std::atomic<unsigned> queueSize{ 4 };
+};
+
+// startWindowsMonitoring(callback, { summaries, deltas, activation, delivery,
+// queueSize }); throws and returns false on an invalid delivery policy or
+// queue size
+inline bool readMonitorOptions (const Napi::CallbackInfo& info, MonitorOptions& options) {
+    bool summaries = true;
+    bool deltas = false;
+    bool activation = false;
+    int delivery = DELIVER_LATEST;
+    unsigned queueSize = 4;
+
+    if (info.Length () > 1 && info[1].IsObject ()) {
+        Napi::Object obj = info[1].As<Napi::Object> ();
+        if (obj.Has ("summaries")) summaries = obj.Get ("summaries").ToBoolean ();
+        if (obj.Has ("deltas")) deltas = obj.Get ("deltas").ToBoolean ();
+        if (obj.Has ("activation")) activation = obj.Get ("activation").ToBoolean ();
+
+        Napi::Value policy = obj.Get ("delivery");
+        if (!policy.IsUndefined ()) {
+            std::string name = policy.IsString () ? policy.As<Napi::String> ().Utf8Value () : "";
+            if (name == "latest") {
+                delivery = DELIVER_LATEST;
+            } else if (name == "queue") {
+                delivery = DELIVER_QUEUE;
+            } else if (name == "block") {
+                delivery = DELIVER_BLOCK;
+            } else {
+                Napi::TypeError::New (info.Env (), "delivery must be \"latest\", \"queue\" or \"block\"")
+                .ThrowAsJavaScriptException ();
+                return false;
+            }
+        }
+
+        Napi::Value size = obj.Get ("queueSize");
+        if (!size.IsUndefined ()) {
+            double value = size.IsNumber () ? size.As<Napi::Number> ().DoubleValue () : 0;
+            if (!(value >= 1 && value <= 1024)) {
+                Napi::TypeError::New (info.Env (), "queueSize must be a number between 1 and 1024")
+                .ThrowAsJavaScriptException ();
+                return false;
+            }
+            queueSize = static_cast<unsigned> (value);
+        }
+    }
+
+    if (summaries && !options.summaries) options.resendSummaries = true;
+    if (deltas && !options.deltas) options.restartDeltas = true;
+    options.summaries = summaries;
+    options.deltas = deltas;
+    options.activation = activation;
+    options.delivery = delivery;
+    options.queueSize = queueSize;
+    return true;
+}
+
+// Identifies one refresh in the trace: `id` tags the collect, diff,
+// dispatch, marshal and callback events, and the "update" span runs from
+// `triggeredAt` (the first event the refresh answers) to the end of the
+// callback. Both are 0 while tracing is off.
+struct MonitorTrace {
+    uint64_t id;
+    uint64_t triggeredAt;
+
+    static MonitorTrace begin (uint64_t triggeredAt = 0) {
+        if (!wm::tracer ().enabled ()) return {};
+        return { wm::tracer ().nextId (), triggeredAt ? triggeredAt : wm::traceNow () };
+    }
+};
+
+struct MonitorUpdate {
+    MonitorTrace trace;
+    bool hasSummaries;
+    std::vector<wm::WindowRecord> summaries;
+    bool hasDeltas;
+    std::vector<wm::WindowDelta> deltas;
+    bool hasActiveWindow;
+    int64_t activeWindow;
+};
+
+// Runs the snapshot through the differ and keeps only what the listeners
+// asked for. Returns nullptr when there is nothing to deliver: summaries
+// go out until `initialSummarySent` is set (even an empty desktop gets one)
+// and then only when the differ saw a change, so an idle desktop costs no
+// JS callbacks in either mode.
+inline MonitorUpdate* makeMonitorUpdate (wm::WindowDiffer& differ,
+                                         bool& initialSummarySent,
+                                         std::vector<wm::WindowRecord> snapshot,
+                                         MonitorOptions& options,
+                                         const MonitorTrace& trace = {}) {
+    wm::stats ().add (wm::STAT_MONITOR_REFRESHES);
+    wm::TraceScope scope ("diff", trace.id);
+    auto update = new MonitorUpdate{};
+    update->trace = trace;
+
+    if (options.restartDeltas.exchange (false)) differ.reset ();
+    bool first = options.resendSummaries.exchange (false) || !initialSummarySent;
+    bool summaries = options.summaries;
+    std::vector<wm::WindowDelta> deltas = differ.update (summaries ? snapshot : std::move (snapshot));
+
+    if (summaries && (first || !deltas.empty ())) {
+        update->hasSummaries = true;
+        update->summaries = std::move (snapshot);
+        initialSummarySent = true;
+    }
+    if (options.deltas && !deltas.empty ()) {
+        update->hasDeltas = true;
+        update->deltas = std::move (deltas);
+    }
+
+    if (!update->hasSummaries && !update->hasDeltas) {
+        wm::stats ().add (wm::STAT_MONITOR_UNCHANGED);
+        if (trace.id) wm::traceAsync ("update (unchanged)", trace.id, trace.triggeredAt, wm::traceNow ());
+        delete update;
+        return nullptr;
+    }
+
+    return update;
+}
+
+// ThreadSafeFunction callback: calls callback(summaries?, deltas?,
+// activeWindow?) on the JS thread and frees the update.
+inline void deliverMonitorUpdate (Napi::Env env, Napi::Function jsCallback, MonitorUpdate* update) {
+    MonitorTrace trace = update->trace;
+    Napi::Value summaries, deltas, activeWindow;
+    {
+        wm::TraceScope scope ("marshal", trace.id);
+        summaries = update->hasSummaries ? Napi::Value (windowRecordsToArray (env, update->summaries)) :
+                                           env.Undefined ();
+        deltas = update->hasDeltas ? Napi::Value (windowDeltasToArray (env, update->deltas)) : env.Undefined ();
+        activeWindow = update->hasActiveWindow ? Napi::Value (Napi::Number::New (env, update->activeWindow)) :
+                                                 env.Undefined ();
+    }
+    delete update;
+
+    {
+        wm::ScopedTimer timer (wm::TIMER_CALLBACK);
+        wm::TraceScope scope ("callback", trace.id);
+        jsCallback.Call ({ summaries, deltas, activeWindow });
+    }
+    if (trace.id) wm::traceAsync ("update", trace.id, trace.triggeredAt, wm::traceNow ());
+}
+
+// Sits between a monitor thread and its ThreadSafeFunction. At most one
+// call is queued on the function at a time; updates arriving meanwhile wait
+// here under the delivery policy, so memory and staleness stay bounded
+// however long the event loop is busy.
+class MonitorMailbox {
+public:
+    // Accepts updates again after close ()
+    void open () {
+        std::lock_guard<std::mutex> lock (mutex_);
+        closed_ = false;
+    }
+
+    // Drops pending updates and releases a monitor thread blocked in post ().
+    // Call before joining the monitor thread. A call still queued on the old
+    // function finds its generation gone and does nothing.
+    void close () {
+        std::lock_guard<std::mutex> lock (mutex_);
+        closed_ = true;
+        scheduled_ = false;
+        ++generation_;
+        dropPending ();
+        drained_.notify_all ();
+    }
+
+    // Monitor thread: takes ownership of `update`. False if it was dropped
+    // because the mailbox is closed or the function refused the call.
+    bool post (Napi::ThreadSafeFunction& tsfn, MonitorUpdate* update, const MonitorOptions& options) {
+        std::unique_lock<std::mutex> lock (mutex_);
+        int delivery = options.delivery;
+        size_t limit = delivery == DELIVER_LATEST ? 1 : options.queueSize.load ();
+
+        if (delivery == DELIVER_BLOCK) {
+            drained_.wait (lock, [&] { return closed_ || pending_.size () < limit; });
+        }
+        if (closed_) {
+            drop (update);
+            return false;
+        }
+
+        if (pending_.size () >= limit) {
+            merge (*pending_.back (), update);
+        } else {
+            pending_.push_back (update);
+        }
+
+        tsfn_ = &tsfn;
+        return scheduled_ || schedule ();
+    }
+
+private:
+    struct Ticket {
+        MonitorMailbox* mailbox;
+        uint64_t generation;
+    };
+
+    // Called with the lock held
+    bool schedule () {
+        auto ticket = new Ticket{ this, generation_ };
+        if (tsfn_->NonBlockingCall (ticket, drain) != napi_ok) {
+            delete ticket;
+            dropPending ();
+            return false;
+        }
+        scheduled_ = true;
+        wm::traceInstant ("dispatch", pending_.front ()->trace.id);
+        return true;
+    }
+
+    // JS thread: delivers the oldest pending update and schedules the next
+    static void drain (Napi::Env env, Napi::Function jsCallback, Ticket* ticket) {
+        MonitorMailbox* mailbox = ticket->mailbox;
+        uint64_t generation = ticket->generation;
+        delete ticket;
+
+        MonitorUpdate* update = nullptr;
+        {
+            std::lock_guard<std::mutex> lock (mailbox->mutex_);
+            if (generation != mailbox->generation_) return;
+            mailbox->scheduled_ = false;
+            if (mailbox->pending_.empty ()) return;
+            update = mailbox->pending_.front ();
+            mailbox->pending_.pop_front ();
+            mailbox->drained_.notify_all ();
+        }
+
+        // Merging can cancel every delta out
+        if (update->hasSummaries || update->hasDeltas || update->hasActiveWindow) {
+            wm::stats ().add (wm::STAT_MONITOR_DISPATCHED);
+            deliverMonitorUpdate (env, jsCallback, update);
+        } else {
+            delete update;
+        }
+
+        std::lock_guard<std::mutex> lock (mailbox->mutex_);
+        if (generation == mailbox->generation_ && !mailbox->pending_.empty () && !mailbox->scheduled_) {
+            mailbox->schedule ();
+        }
+    }
+
+    // `newer` is folded into `older`, which keeps its trace id, so latency
+    // still counts from the first event it answers
+    static void merge (MonitorUpdate& older, MonitorUpdate* newer) {
+        wm::stats ().add (wm::STAT_MONITOR_MERGED);
+        if (newer->trace.id) {
+            wm::traceAsync ("update (merged)", newer->trace.id, newer->trace.triggeredAt, wm::traceNow ());
+        }
+        if (newer->hasSummaries) {
+            older.hasSummaries = true;
+            older.summaries = std::move (newer->summaries);
+        }
+        if (newer->hasDeltas) {
+            wm::mergeWindowDeltas (older.deltas, std::move (newer->deltas));
+            older.hasDeltas = !older.deltas.empty ();
+        }
+        if (newer->hasActiveWindow) {
+            older.hasActiveWindow = true;
+            older.activeWindow = newer->activeWindow;
+        }
+        delete newer;
+    }
+
+    static void drop (MonitorUpdate* update) {
+        wm::stats ().add (wm::STAT_MONITOR_DROPPED);
+        if (update->trace.id) {
+            wm::traceAsync ("update (dropped)", update->trace.id, update->trace.triggeredAt, wm::traceNow ());
+        }
+        delete update;
+    }
+
+    void dropPending () {
+        for (MonitorUpdate* update : pending_) drop (update);
+        pending_.clear ();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable drained_;
+    std::deque<MonitorUpdate*> pending_;
+    Napi::ThreadSafeFunction* tsfn_ = nullptr;
+    uint64_t generation_ = 0;
+    bool scheduled_ = false;
+    bool closed_ = true;
+};
+
+// What a NativeWindow caches about its window: everything initWindow used to
+// be called for, loaded once in native code
+struct WindowInfo {
+    int64_t id;
+    int64_t processId;
+    std::string path;
+    // Window class: the Win32 class name, the class part of WM_CLASS on
+    // Linux, the bundle identifier on macOS
+    std::string className;
+    // False if the window was gone when the info was loaded
+    bool valid;
+};
+
+// Defined by each backend. collectWindowInfos() lists the windows
+// getWindows() returns: valid ones owned by a process with a known path.
+// Neither touches JS values, so both may run on the thread pool.
+std::vector<WindowInfo> collectWindowInfos ();
+WindowInfo loadWindowInfo (int64_t id);
+
+// State of one environment. The main thread and every worker that loads the
+// addon get their own instance (Init installs it with SetInstanceData), so
+// their filters and monitors never see each other; only caches of the
+// window system itself, the stats and the tracer are process-wide. Each
+// backend derives its AddonState from this with its monitor thread's
+// handles.
+struct EnvState {
+    explicit EnvState (const std::vector<wm::FilterRule>& defaultFilters) : windowFilter (defaultFilters) {}
+
+    EnvState (const EnvState&) = delete;
+    EnvState& operator= (const EnvState&) = delete;
+
+    wm::SharedWindowFilter windowFilter;
+
+    Napi::ThreadSafeFunction tsfn;
+    std::atomic<bool> monitoring{ false };
+    // Bumped by every start, so the finalizer of an earlier function leaves
+    // a newer monitor alone
+    uint64_t generation = 0;
+    MonitorOptions monitorOptions;
+    MonitorMailbox mailbox;
+    wm::WindowDiffer differ; // monitor thread only
+    // Set once the first summary of a monitoring session went out; monitor
+    // thread only, cleared on start
+    bool initialSummarySent = false;
+    wm::SharedSpatialIndex spatialIndex;
+    // NativeWindow class of this environment, set by NativeWindow::Init
+    Napi::FunctionReference windowConstructor;
+    // Last foreground window pushed; monitor thread only
+    int64_t lastActiveWindow = 0;
+
+    // Monitor thread: false while only activation is monitored. The index
+    // and the differ's baseline are dropped then, so neither goes stale and
+    // turning summaries or deltas back on starts from a full snapshot.
+    bool collectsWindows () {
+        if (monitorOptions.summaries || monitorOptions.deltas) return true;
+        spatialIndex.set (nullptr);
+        differ.reset ();
+        initialSummarySent = false;
+        return false;
+    }
+
+    // Monitor thread: pushes a foreground change straight to the mailbox,
+    // bypassing the throttle and the differ; it is one handle, so it costs
+    // nothing to send as soon as the window system reports it.
+    void postActivation (int64_t window) {
+        if (!monitorOptions.activation || window == lastActiveWindow) return;
+        lastActiveWindow = window;
+
+        auto update = new MonitorUpdate{};
+        update->trace = MonitorTrace::begin ();
+        update->hasActiveWindow = true;
+        update->activeWindow = window;
+        wm::traceInstant ("activation", update->trace.id);
+        mailbox.post (tsfn, update, monitorOptions);
+    }
+};
+
+// Window object returned by getWindows(): { id, processId, path, className,
+// valid } read from the WindowInfo it was created with, so property reads
+// never go back to the window system. refresh() reloads the info and
+// returns the object. `new NativeWindow(id)` loads a single window.
+class NativeWindow : public Napi::ObjectWrap<NativeWindow> {
+public:
+    static void Init (Napi::Env env, Napi::Object exports, EnvState& state) {
+        Napi::Function constructor =
+        DefineClass (env, "NativeWindow",
+                     { InstanceAccessor ("id", &NativeWindow::id, nullptr),
+                       InstanceAccessor ("processId", &NativeWindow::processId, nullptr),
+                       InstanceAccessor ("path", &NativeWindow::path, nullptr),
+                       InstanceAccessor ("className", &NativeWindow::className, nullptr),
+                       InstanceAccessor ("valid", &NativeWindow::valid, nullptr),
+                       InstanceMethod ("refresh", &NativeWindow::refresh) });
+        state.windowConstructor = Napi::Persistent (constructor);
+        exports.Set ("NativeWindow", constructor);
+    }
+
+    // One object per window, each taking a copy of its info
+    static Napi::Array fromInfos (Napi::Env env, EnvState& state, const std::vector<WindowInfo>& infos) {
+        wm::ScopedTimer timer (wm::TIMER_MARSHAL);
+        Napi::Array array = Napi::Array::New (env, infos.size ());
+        for (size_t i = 0; i < infos.size (); ++i) {
+            WindowInfo info = infos[i];
+            array.Set (i, state.windowConstructor.New ({ Napi::External<WindowInfo>::New (env, &info) }));
+        }
+        return array;
+    }
+
+    // From C++ the argument is an External holding the info; from JS it is
+    // a window handle
+    explicit NativeWindow (const Napi::CallbackInfo& info) : Napi::ObjectWrap<NativeWindow> (info), info_{} {
+        if (info.Length () > 0 && info[0].IsExternal ()) {
+            info_ = std::move (*info[0].As<Napi::External<WindowInfo>> ().Data ());
+        } else if (info.Length () > 0 && info[0].IsNumber ()) {
+            info_ = loadWindowInfo (info[0].As<Napi::Number> ().Int64Value ());
+        } else {
+            Napi::TypeError::New (info.Env (), "NativeWindow expects a window handle").ThrowAsJavaScriptException ();
+        }
+    }
+
+private:
+    Napi::Value id (const Napi::CallbackInfo& info) {
+        return Napi::Number::New (info.Env (), static_cast<double> (info_.id));
+    }
+    Napi::Value processId (const Napi::CallbackInfo& info) {
+        return Napi::Number::New (info.Env (), static_cast<double> (info_.processId));
+    }
+    Napi::Value path (const Napi::CallbackInfo& info) {
+        return Napi::String::New (info.Env (), info_.path);
+    }
+    Napi::Value className (const Napi::CallbackInfo& info) {
+        return Napi::String::New (info.Env (), info_.className);
+    }
+    Napi::Value valid (const Napi::CallbackInfo& info) {
+        return Napi::Boolean::New (info.Env (), info_.valid);
+    }
+
+    Napi::Value refresh (const Napi::CallbackInfo& info) {
+        info_ = loadWindowInfo (info_.id);
+        return Value ();
+    }
+
+    WindowInfo info_;
+};
+
+// startTracing([{ bufferSize }]): records the monitor pipeline into a ring
+// of `bufferSize` events (65536 by default), replacing what was recorded
+inline Napi::Value startTracing (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    size_t capacity = wm::Tracer::DEFAULT_CAPACITY;
+    if (info.Length () > 0 && info[0].IsObject ()) {
+        Napi::Value size = info[0].As<Napi::Object> ().Get ("bufferSize");
+        if (!size.IsUndefined ()) {
+            double value = size.IsNumber () ? size.As<Napi::Number> ().DoubleValue () : 0;
+            if (!(value >= 1 && value <= (1 << 24))) {
+                Napi::TypeError::New (env, "bufferSize must be a number between 1 and 16777216")
+                .ThrowAsJavaScriptException ();
+                return env.Undefined ();
+            }
+            capacity = static_cast<size_t> (value);
+        }
+    }
+
+    wm::tracer ().nameThread ("JavaScript");
+    wm::tracer ().start (capacity);
+    return env.Undefined ();
+}
+
+inline Napi::Value stopTracing (const Napi::CallbackInfo& info) {
+    wm::tracer ().stop ();
+    return info.Env ().Undefined ();
+}
+
+// Chrome trace_event JSON of what the ring holds; works after stopTracing()
+inline Napi::Value dumpTrace (const Napi::CallbackInfo& info) {
+    return Napi::String::New (info.Env (), wm::tracer ().json ());
+}
@@ -1,28 +1,21 @@
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <napi.h>
 #include <shtypes.h>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <windows.h>
 #include <thread>
 #include <atomic>
 
+#include "window_summary.h"
+
 typedef int (__stdcall* lp_GetScaleFactorForMonitor) (HMONITOR, DEVICE_SCALE_FACTOR*);
 
-// Global variables for window monitoring
-static std::vector<HWINEVENTHOOK> g_hooks;
-static Napi::ThreadSafeFunction g_tsfn;
-static std::atomic<bool> g_monitoring(false);
-static std::thread* g_monitorThread = nullptr;
-static DWORD g_monitorThreadId = 0;
-
-// Throttling state variables
-static std::atomic<DWORD> g_lastProcessedTime(0);
-static std::atomic<bool> g_pendingTrailingUpdate(false);
-static UINT_PTR g_throttleTimerId = 0;
 static const DWORD THROTTLE_MS = 64; // ~30fps throttle interval
 
 struct Process {
@@ -49,23 +42,50 @@ std::string toUtf8 (const std::wstring& str) {
     return ret;
 }
 
-Process getWindowProcess (HWND handle) {
-    DWORD pid{ 0 };
-    GetWindowThreadProcessId (handle, &pid);
-
-    HANDLE pHandle{ OpenProcess (PROCESS_QUERY_LIMITED_INFORMATION, false, pid) };
+// Cached process entries keep their handle open: it tells when the process
+// exits (WaitForSingleObject) and stops the pid from being reused meanwhile,
+// so a hit needs no OpenProcess or QueryFullProcessImageNameW.
+static bool loadProcess (int64_t pid, wm::ProcessInfo& info) {
+    // OpenProcess, QueryFullProcessImageNameW and GetProcessTimes
+    wm::stats ().add (wm::STAT_NATIVE_CALLS, 3);
+    HANDLE pHandle{ OpenProcess (PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, false,
+                                 static_cast<DWORD> (pid)) };
+    if (!pHandle) return false;
 
     DWORD dwSize{ MAX_PATH };
-    wchar_t exeName[MAX_PATH]{};
+    wchar_t exePath[MAX_PATH]{};
+    QueryFullProcessImageNameW (pHandle, 0, exePath, &dwSize);
 
-    QueryFullProcessImageNameW (pHandle, 0, exeName, &dwSize);
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    GetProcessTimes (pHandle, &creation, &exit, &kernel, &user);
 
-    CloseHandle (pHandle);
+    info.path = toUtf8 (std::wstring (exePath));
+    info.startTime = (static_cast<uint64_t> (creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+    info.handle = reinterpret_cast<intptr_t> (pHandle);
+    return true;
+}
 
-    auto wspath (exeName);
-    auto path = toUtf8 (wspath);
+static bool processAlive (const wm::ProcessInfo& info) {
+    wm::stats ().add (wm::STAT_NATIVE_CALLS);
+    return WaitForSingleObject (reinterpret_cast<HANDLE> (info.handle), 0) == WAIT_TIMEOUT;
+}
 
-    return { static_cast<int> (pid), path };
+static void releaseProcess (wm::ProcessInfo& info) {
+    CloseHandle (reinterpret_cast<HANDLE> (info.handle));
+}
+
+static wm::ProcessCache g_processCache{ { loadProcess, processAlive, releaseProcess } };
+
+Process getWindowProcess (HWND handle) {
+    DWORD pid{ 0 };
+    GetWindowThreadProcessId (handle, &pid);
+
+    wm::ProcessInfo info;
+    if (pid == 0 || !g_processCache.lookup (pid, info)) {
+        return { static_cast<int> (pid), "" };
+    }
+
+    return { static_cast<int> (pid), info.path };
 }
 
 HWND find_top_window (DWORD pid) {
@@ -130,52 +150,108 @@ Napi::Number getActiveWindow (const Napi::CallbackInfo& info) {
     return Napi::Number::New (env, reinterpret_cast<int64_t> (handle));
 }
 
-std::vector<int64_t> _windows;
-
+// Enumeration fills a caller-owned list passed through lParam, so it can run
+// on the monitor thread or the thread pool as well as the JS thread
 BOOL CALLBACK EnumWindowsProc (HWND hwnd, LPARAM lparam) {
-    _windows.push_back (reinterpret_cast<int64_t> (hwnd));
+    reinterpret_cast<std::vector<int64_t>*> (lparam)->push_back (reinterpret_cast<int64_t> (hwnd));
     return TRUE;
 }
 
-Napi::Array getWindows (const Napi::CallbackInfo& info) {
-    Napi::Env env{ info.Env () };
+std::vector<int64_t> collectWindows () {
+    std::vector<int64_t> windows;
+    EnumWindows (&EnumWindowsProc, reinterpret_cast<LPARAM> (&windows));
+    return windows;
+}
+
+// GetScaleFactorForMonitor is in Shcore.dll from Windows 8.1 on; resolved
+// once, nullptr before that
+static lp_GetScaleFactorForMonitor scaleFactorForMonitorProc () {
+    static lp_GetScaleFactorForMonitor proc = [] () -> lp_GetScaleFactorForMonitor {
+        HMODULE hShcore{ LoadLibraryA ("SHcore.dll") };
+        if (!hShcore) return nullptr;
+        return (lp_GetScaleFactorForMonitor)GetProcAddress (hShcore, "GetScaleFactorForMonitor");
+    }();
+    return proc;
+}
 
-    _windows.clear ();
-    EnumWindows (&EnumWindowsProc, NULL);
+// Scale factors by monitor. A process without windows is not told when a
+// scale setting changes, so entries are trusted for SCALE_CACHE_MS only.
+static const ULONGLONG SCALE_CACHE_MS = 1000;
 
-    auto arr = Napi::Array::New (env);
-    auto i = 0;
-    for (auto _win : _windows) {
-        arr.Set (i++, Napi::Number::New (env, _win));
+struct ScaleCache {
+    std::mutex mutex;
+    std::unordered_map<HMONITOR, std::pair<double, ULONGLONG>> entries;
+};
+static ScaleCache g_scaleCache;
+
+static double monitorScaleFactor (HMONITOR monitor) {
+    ULONGLONG now = GetTickCount64 ();
+    {
+        std::lock_guard<std::mutex> lock (g_scaleCache.mutex);
+        auto it = g_scaleCache.entries.find (monitor);
+        if (it != g_scaleCache.entries.end () && now - it->second.second < SCALE_CACHE_MS) return it->second.first;
     }
 
-    return arr;
-}
+    double scale = 1;
+    DEVICE_SCALE_FACTOR sf{};
+    lp_GetScaleFactorForMonitor f{ scaleFactorForMonitorProc () };
+    if (f && f (monitor, &sf) == S_OK && sf > 0) scale = static_cast<double> (sf) / 100.;
+    wm::stats ().add (wm::STAT_NATIVE_CALLS);
 
-std::vector<int64_t> _monitors;
+    std::lock_guard<std::mutex> lock (g_scaleCache.mutex);
+    g_scaleCache.entries[monitor] = { scale, now };
+    return scale;
+}
 
 BOOL CALLBACK EnumMonitorsProc (HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
-    _monitors.push_back (reinterpret_cast<int64_t> (hMonitor));
+    reinterpret_cast<std::vector<int64_t>*> (dwData)->push_back (reinterpret_cast<int64_t> (hMonitor));
     return TRUE;
 }
 
-Napi::Array getMonitors (const Napi::CallbackInfo& info) {
-    Napi::Env env{ info.Env () };
-
-    _monitors.clear ();
-    if (EnumDisplayMonitors (NULL, NULL, &EnumMonitorsProc, NULL)) {
-        auto arr = Napi::Array::New (env);
-        auto i = 0;
-
-        for (auto _mon : _monitors) {
+std::vector<int64_t> collectMonitors () {
+    std::vector<int64_t> monitors;
+    if (!EnumDisplayMonitors (NULL, NULL, &EnumMonitorsProc, reinterpret_cast<LPARAM> (&monitors))) {
+        monitors.clear ();
+    }
+    return monitors;
+}
 
-            arr.Set (i++, Napi::Number::New (env, _mon));
-        }
+// Monitor rectangles in the coordinates GetWindowRect uses, for clipping
+// visible regions
+static std::vector<wm::Rect> collectMonitorRects () {
+    std::vector<wm::Rect> rects;
+    for (int64_t handle : collectMonitors ()) {
+        MONITORINFO mInfo;
+        mInfo.cbSize = sizeof (MONITORINFO);
+        if (!GetMonitorInfoW (reinterpret_cast<HMONITOR> (handle), &mInfo)) continue;
+
+        const RECT& r = mInfo.rcMonitor;
+        rects.push_back ({ static_cast<int> (r.left), static_cast<int> (r.top), static_cast<int> (r.right - r.left),
+                           static_cast<int> (r.bottom - r.top) });
+    }
+    return rects;
+}
 
-        return arr;
+// Monitor rectangles with their scale factors, for logicalBounds
+static std::vector<wm::MonitorRecord> collectMonitorScales () {
+    std::vector<wm::MonitorRecord> monitors;
+    for (int64_t handle : collectMonitors ()) {
+        MONITORINFO mInfo;
+        mInfo.cbSize = sizeof (MONITORINFO);
+        if (!GetMonitorInfoW (reinterpret_cast<HMONITOR> (handle), &mInfo)) continue;
+
+        const RECT& r = mInfo.rcMonitor;
+        wm::Rect bounds{ static_cast<int> (r.left), static_cast<int> (r.top), static_cast<int> (r.right - r.left),
+                         static_cast<int> (r.bottom - r.top) };
+        monitors.push_back ({ handle, bounds, bounds, (mInfo.dwFlags & MONITORINFOF_PRIMARY) != 0,
+                              monitorScaleFactor (reinterpret_cast<HMONITOR> (handle)) });
     }
+    return monitors;
+}
 
-    return Napi::Array::New (env);
+Napi::Array getMonitors (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    return handlesToArray (env, collectMonitors ());
 }
 
 Napi::Number getMonitorFromWindow (const Napi::CallbackInfo& info) {
@@ -200,6 +276,32 @@ Napi::Object initWindow (const Napi::CallbackInfo& info) {
     return obj;
 }
 
+WindowInfo loadWindowInfo (int64_t id) {
+    auto handle = reinterpret_cast<HWND> (id);
+    WindowInfo info{};
+    info.id = id;
+    info.valid = IsWindow (handle) != FALSE;
+    if (!info.valid) return info;
+
+    auto process = getWindowProcess (handle);
+    info.processId = process.pid;
+    info.path = process.path;
+
+    wchar_t className[256];
+    int length = GetClassNameW (handle, className, sizeof (className) / sizeof (className[0]));
+    if (length > 0) info.className = toUtf8 (std::wstring (className, length));
+    return info;
+}
+
+std::vector<WindowInfo> collectWindowInfos () {
+    std::vector<WindowInfo> windows;
+    for (int64_t handle : collectWindows ()) {
+        WindowInfo info = loadWindowInfo (handle);
+        if (info.valid && !info.path.empty ()) windows.push_back (std::move (info));
+    }
+    return windows;
+}
+
 Napi::Object getWindowBounds (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
 
@@ -208,14 +310,23 @@ Napi::Object getWindowBounds (const Napi::CallbackInfo& info) {
     RECT rect{};
     GetWindowRect (handle, &rect);
 
-    Napi::Object bounds{ Napi::Object::New (env) };
+    wm::Rect bounds{ static_cast<int> (rect.left), static_cast<int> (rect.top),
+                     static_cast<int> (rect.right - rect.left), static_cast<int> (rect.bottom - rect.top) };
+    if (readLogicalOption (info, 1)) {
+        bounds = wm::logicalRect (bounds, monitorScaleFactor (MonitorFromWindow (handle, MONITOR_DEFAULTTONEAREST)));
+    }
+
+    return rectToObject (env, bounds);
+}
 
-    bounds.Set ("x", rect.left);
-    bounds.Set ("y", rect.top);
-    bounds.Set ("width", rect.right - rect.left);
-    bounds.Set ("height", rect.bottom - rect.top);
+// Scale factor of the monitor the window is on, for callers converting
+// logical bounds back
+Napi::Number getWindowScaleFactor (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+
+    auto handle{ getValueFromCallbackData<HWND> (info, 0) };
 
-    return bounds;
+    return Napi::Number::New (env, monitorScaleFactor (MonitorFromWindow (handle, MONITOR_DEFAULTTONEAREST)));
 }
 
 Napi::String getWindowTitle (const Napi::CallbackInfo& info) {
@@ -270,14 +381,7 @@ Napi::Number getWindowOwner (const Napi::CallbackInfo& info) {
 Napi::Number getMonitorScaleFactor (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
 
-    HMODULE hShcore{ LoadLibraryA ("SHcore.dll") };
-    lp_GetScaleFactorForMonitor f{ (
-    lp_GetScaleFactorForMonitor)GetProcAddress (hShcore, "GetScaleFactorForMonitor") };
-
-    DEVICE_SCALE_FACTOR sf{};
-    f (getValueFromCallbackData<HMONITOR> (info, 0), &sf);
-
-    return Napi::Number::New (env, static_cast<double> (sf) / 100.);
+    return Napi::Number::New (env, monitorScaleFactor (getValueFromCallbackData<HMONITOR> (info, 0)));
 }
 
 Napi::Boolean toggleWindowTransparency (const Napi::CallbackInfo& info) {
@@ -355,6 +459,91 @@ Napi::Boolean showWindow (const Napi::CallbackInfo& info) {
     return Napi::Boolean::New (env, ShowWindow (handle, flag));
 }
 
+// Moves, resizes, shows, hides and raises every window of the layout in one
+// DeferWindowPos batch, so they are repainted once and together. If the
+// batch cannot be built (one window belongs to a hung or elevated process,
+// say) each window is positioned on its own instead, which still reports
+// the window that failed.
+static std::vector<wm::LayoutResult> applyLayoutBatch (const std::vector<wm::LayoutChange>& changes) {
+    struct Placement {
+        size_t index;
+        HWND handle;
+        wm::Rect bounds;
+        UINT flags;
+    };
+
+    std::vector<wm::LayoutResult> results (changes.size ());
+    std::vector<Placement> placements;
+    placements.reserve (changes.size ());
+    HWND activate = NULL;
+
+    for (size_t i = 0; i < changes.size (); ++i) {
+        const wm::LayoutChange& change = changes[i];
+        auto handle = reinterpret_cast<HWND> (change.id);
+        results[i] = { change.id, true, "" };
+
+        if (!IsWindow (handle)) {
+            results[i] = { change.id, false, "Window not found" };
+            continue;
+        }
+
+        UINT flags = SWP_NOACTIVATE | SWP_NOOWNERZORDER;
+        if (!(change.boundsFields & wm::LAYOUT_POSITION)) flags |= SWP_NOMOVE;
+        if (!(change.boundsFields & wm::LAYOUT_SIZE)) flags |= SWP_NOSIZE;
+        if (!change.raise) flags |= SWP_NOZORDER;
+        if (change.visibility == wm::LAYOUT_SHOW) flags |= SWP_SHOWWINDOW;
+        if (change.visibility == wm::LAYOUT_HIDE) flags |= SWP_HIDEWINDOW;
+
+        // SetWindowPos takes position and size together, so partial bounds
+        // are completed from the current window rectangle
+        wm::Rect bounds = change.bounds;
+        if (change.boundsFields != 0 && change.boundsFields != wm::LAYOUT_BOUNDS) {
+            RECT rect{};
+            GetWindowRect (handle, &rect);
+            bounds = wm::resolveLayoutBounds (
+            { rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top }, change);
+        }
+
+        if (change.raise) activate = handle;
+        placements.push_back ({ i, handle, bounds, flags });
+    }
+
+    bool deferred = false;
+    if (!placements.empty ()) {
+        HDWP batch = BeginDeferWindowPos (static_cast<int> (placements.size ()));
+        for (const Placement& p : placements) {
+            if (!batch) break;
+            batch = DeferWindowPos (batch, p.handle, (p.flags & SWP_NOZORDER) ? NULL : HWND_TOP,
+                                    p.bounds.x, p.bounds.y, p.bounds.width, p.bounds.height, p.flags);
+        }
+        // A failed DeferWindowPos has already released the batch
+        deferred = batch && EndDeferWindowPos (batch);
+    }
+
+    if (!deferred) {
+        for (const Placement& p : placements) {
+            if (SetWindowPos (p.handle, (p.flags & SWP_NOZORDER) ? NULL : HWND_TOP, p.bounds.x,
+                              p.bounds.y, p.bounds.width, p.bounds.height, p.flags)) {
+                continue;
+            }
+            results[p.index] = { changes[p.index].id, false,
+                                 "SetWindowPos failed with error " + std::to_string (GetLastError ()) };
+        }
+    }
+
+    if (activate) SetForegroundWindow (activate);
+
+    return results;
+}
+
+Napi::Value applyLayout (const Napi::CallbackInfo& info) {
+    return applyLayoutChanges (info, applyLayoutBatch);
+}
+
+Napi::Value tileWindows (const Napi::CallbackInfo& info) {
+    return applyTiling (info, applyLayoutBatch);
+}
+
 Napi::Boolean bringWindowToTop (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
     auto handle{ getValueFromCallbackData<HWND> (info, 0) };
@@ -419,181 +608,293 @@ Napi::Number getWindowZOrder (const Napi::CallbackInfo& info) {
     return Napi::Number::New (env, zIndex);
 }
 
-struct WindowFilter {
-    std::string executableName;
-    std::string titlePrefix;
+// Applications ignored in the window summary until setWindowFilters
+// replaces the rules
+static const std::vector<wm::FilterRule> IGNORE_LIST = {
+    wm::FilterRule::exeWithTitlePrefix ("xeester.exe", "XEESTER:"),
+    wm::FilterRule::exeWithTitlePrefix ("PokerTracker4.exe", "MVS "),
+    wm::FilterRule::exeWithTitlePrefix ("PokerTrackerHud4.exe", "ptTableCover"),
+    wm::FilterRule::exeWithTitlePrefix ("HM3Hud.exe", "MVS "),
+    wm::FilterRule::exeWithTitlePrefix ("HM3HudProcess.exe", "ptTableCover")
 };
 
-// List of applications to ignore in the window summary
-static const std::vector<WindowFilter> IGNORE_LIST = {
-    { "xeester.exe", "XEESTER:" },
-    { "PokerTracker4.exe", "MVS " },
-    { "PokerTrackerHud4.exe", "ptTableCover" },
-    { "HM3Hud.exe", "MVS " },
-    { "HM3HudProcess.exe", "ptTableCover" }
+// Per-environment state; see EnvState. The hooks, the throttle and its timer
+// belong to the monitor thread, which finds them through t_monitorState.
+struct AddonState : EnvState {
+    AddonState () : EnvState (IGNORE_LIST) {}
+    ~AddonState () {
+        stopMonitor ();
+    }
+
+    void stopMonitor ();
+
+    std::thread monitorThread;
+    std::atomic<DWORD> monitorThreadId{ 0 };
+
+    // Monitor thread only
+    std::vector<HWINEVENTHOOK> hooks;
+    DWORD lastProcessedTime = 0;
+    bool pendingTrailingUpdate = false;
+    UINT_PTR throttleTimerId = 0;
+    // Trace time of the first event the pending refresh answers
+    uint64_t firstPendingEvent = 0;
 };
 
-bool shouldIgnoreWindow(const std::string& path, const std::string& title) {
-    if (path.empty()) return false;
+// WinEvent hooks and thread timers carry no user data; both are called on
+// the monitor thread that installed them
+static thread_local AddonState* t_monitorState = nullptr;
 
-    // Extract filename from path
-    size_t lastSep = path.find_last_of("\\/");
-    std::string filename = (lastSep != std::string::npos) ? path.substr(lastSep + 1) : path;
+static AddonState& addonState (Napi::Env env) {
+    return *env.GetInstanceData<AddonState> ();
+}
 
-    for (const auto& filter : IGNORE_LIST) {
-        if (filename == filter.executableName) {
-            // Check title prefix
-            if (title.length() >= filter.titlePrefix.length() &&
-                title.compare(0, filter.titlePrefix.length(), filter.titlePrefix) == 0) {
-                return true;
-            }
-        }
-    }
-    return false;
+Napi::Value setWindowFilters (const Napi::CallbackInfo& info) {
+    return applyWindowFilters (info, addonState (info.Env ()).windowFilter);
 }
 
-// Helper function to build windows summary
-Napi::Array buildWindowsSummary(Napi::Env env) {
-    _windows.clear ();
-    EnumWindows (&EnumWindowsProc, NULL);
+// Collects the summary into plain records; no JS values are created here so
+// it can run on the monitor thread. Only the queries behind `requested`
+// (wm::SummaryField bits) and the active filter rules are made, plus those
+// that decide which windows are listed (title length, rect, process path),
+// so every projection returns the same windows.
+std::vector<wm::WindowRecord> collectWindowsSummary (const wm::WindowFilter& filter,
+                                                     unsigned requested = wm::SUMMARY_ALL) {
+    wm::ScopedTimer timer (wm::TIMER_COLLECT);
+    std::vector<int64_t> windows = collectWindows ();
+    // Win32 queries made here, reported once as getStats().nativeCalls
+    uint64_t nativeCalls = 1;
+
+    const unsigned fields = wm::summaryFieldsToCollect (requested, filter.fields ());
 
     // Build Z-order map once
-    std::unordered_map<HWND, int> zOrderMap;
-    int currentZ = 0;
-    HWND walker = GetTopWindow (NULL);
-    while (walker) {
-        zOrderMap[walker] = currentZ++;
-        walker = GetWindow (walker, GW_HWNDNEXT);
+    std::vector<int64_t> stack;
+    if (fields & wm::SUMMARY_Z_ORDER) {
+        HWND walker = GetTopWindow (NULL);
+        while (walker) {
+            stack.push_back (reinterpret_cast<int64_t> (walker));
+            walker = GetWindow (walker, GW_HWNDNEXT);
+        }
+        nativeCalls += stack.size () + 1;
     }
+    wm::ZOrderMap zOrderMap = wm::ZOrderMap::fromTopDown (stack);
 
     // Load dwmapi.dll once for DWM cloaking checks
-    HMODULE hDwmapi = LoadLibraryA ("dwmapi.dll");
+    HMODULE hDwmapi = (fields & wm::SUMMARY_IS_VISIBLE) ? LoadLibraryA ("dwmapi.dll") : NULL;
     typedef HRESULT (WINAPI *DwmGetWindowAttributeProc)(HWND, DWORD, PVOID, DWORD);
     DwmGetWindowAttributeProc pDwmGetWindowAttribute = nullptr;
     if (hDwmapi) {
         pDwmGetWindowAttribute = (DwmGetWindowAttributeProc)GetProcAddress (hDwmapi, "DwmGetWindowAttribute");
     }
 
-    auto arr = Napi::Array::New (env);
-    int resultIndex = 0;
+    std::vector<wm::WindowRecord> results;
+    results.reserve (windows.size ());
 
     // Reusable buffer for window titles (most titles < 256 chars)
     std::vector<WCHAR> titleBuffer (256);
 
-    for (auto _win : _windows) {
+    std::unordered_set<int64_t> livePids;
+
+    for (auto _win : windows) {
         HWND handle = reinterpret_cast<HWND> (_win);
 
         // Filter: only visible windows
+        ++nativeCalls;
         if (!IsWindowVisible (handle))
             continue;
 
-        // Get title length first
-        int titleLen = GetWindowTextLengthW (handle);
-        if (titleLen == 0)
-            continue;
+        wm::WindowRecord summary{};
+        summary.id = _win;
 
-        // Resize buffer if needed
-        if (titleLen >= static_cast<int>(titleBuffer.size ())) {
-            titleBuffer.resize (titleLen + 1);
-        }
-
-        // Get title into reusable buffer
-        int actualLen = GetWindowTextW (handle, titleBuffer.data (), titleBuffer.size ());
-        if (actualLen == 0)
+        // Cheap fields first, so pid and size rules skip the title and
+        // process queries entirely
+        DWORD pid = 0;
+        GetWindowThreadProcessId (handle, &pid);
+        ++nativeCalls;
+        if (pid == 0)
             continue;
+        summary.processId = static_cast<int> (pid);
 
-        std::string title = toUtf8 (std::wstring (titleBuffer.data (), actualLen));
-        if (title.empty ())
+        // Queried whatever the fields: a window whose rect cannot be read is
+        // left out, and the projection must not change which windows come back
+        RECT rect{};
+        ++nativeCalls;
+        if (!GetWindowRect (handle, &rect))
             continue;
 
-        // Get process info (optimized to batch process handle operations)
-        DWORD pid = 0;
-        GetWindowThreadProcessId (handle, &pid);
-        if (pid == 0)
+        // Bounds: Return raw physical coordinates - Electron handles DIP conversion
+        summary.bounds.x = static_cast<int> (rect.left);
+        summary.bounds.y = static_cast<int> (rect.top);
+        summary.bounds.width = rect.right - rect.left;
+        summary.bounds.height = rect.bottom - rect.top;
+
+        unsigned available = wm::FILTER_PID | wm::FILTER_BOUNDS;
+        if (filter.excludes (summary, available))
             continue;
 
-        HANDLE pHandle = OpenProcess (PROCESS_QUERY_LIMITED_INFORMATION, false, pid);
-        if (!pHandle)
+        // Get title length first; untitled windows are skipped even when the
+        // title itself was not requested
+        int titleLen = GetWindowTextLengthW (handle);
+        ++nativeCalls;
+        if (titleLen == 0)
             continue;
 
-        DWORD pathSize = MAX_PATH;
-        wchar_t exePath[MAX_PATH]{};
-        QueryFullProcessImageNameW (pHandle, 0, exePath, &pathSize);
-        CloseHandle (pHandle);
+        if (fields & wm::SUMMARY_TITLE) {
+            // Resize buffer if needed
+            if (titleLen >= static_cast<int>(titleBuffer.size ())) {
+                titleBuffer.resize (titleLen + 1);
+            }
+
+            // Get title into reusable buffer
+            int actualLen = GetWindowTextW (handle, titleBuffer.data (), titleBuffer.size ());
+            ++nativeCalls;
+            if (actualLen == 0)
+                continue;
+
+            summary.title = toUtf8 (std::wstring (titleBuffer.data (), actualLen));
+            if (summary.title.empty ())
+                continue;
 
-        std::string path = toUtf8 (std::wstring (exePath));
-        if (path.empty ())
+            if (filter.excludes (summary, available | wm::FILTER_TITLE, available))
+                continue;
+            available |= wm::FILTER_TITLE;
+        }
+
+        // Process path from the cache, also when it was not requested: windows
+        // without one are skipped. Only rules on the executable are left
+        wm::ProcessInfo process;
+        if (!g_processCache.lookup (pid, process))
             continue;
+        livePids.insert (pid);
 
-        // Apply filters
-        if (shouldIgnoreWindow(path, title))
+        summary.path = process.path;
+        if (summary.path.empty ())
             continue;
 
-        // Get bounds
-        RECT rect{};
-        if (!GetWindowRect (handle, &rect))
+        if (filter.excludes (summary, available | wm::FILTER_PATH, available))
             continue;
 
-        // Check window visibility (more comprehensive than just IsWindowVisible)
-        bool isVisible = true;
-        
-        // Check if window is cloaked by DWM (Windows 8+)
-        // Cloaked windows are technically "visible" but hidden by the system
-        if (pDwmGetWindowAttribute) {
-            DWORD cloaked = 0;
-            // DWMWA_CLOAKED = 14
-            HRESULT hr = pDwmGetWindowAttribute (handle, 14, &cloaked, sizeof(cloaked));
-            if (SUCCEEDED(hr) && cloaked != 0) {
-                isVisible = false;
+        if (fields & wm::SUMMARY_IS_VISIBLE) {
+            // Check window visibility (more comprehensive than just IsWindowVisible)
+            bool isVisible = true;
+
+            // Check if window is cloaked by DWM (Windows 8+)
+            // Cloaked windows are technically "visible" but hidden by the system
+            if (pDwmGetWindowAttribute) {
+                DWORD cloaked = 0;
+                // DWMWA_CLOAKED = 14
+                HRESULT hr = pDwmGetWindowAttribute (handle, 14, &cloaked, sizeof(cloaked));
+                ++nativeCalls;
+                if (SUCCEEDED(hr) && cloaked != 0) {
+                    isVisible = false;
+                }
             }
-        }
-        
-        // Calculate physical dimensions for filtering
-        int physWidth = rect.right - rect.left;
-        int physHeight = rect.bottom - rect.top;
-        
-        // Filter out zero or very small windows (likely invisible UI elements)
-        if (physWidth < 1 || physHeight < 1) {
-            isVisible = false;
-        }
 
-        // Create summary object
-        Napi::Object summary = Napi::Object::New (env);
-        summary.Set ("id", Napi::Number::New (env, _win));
-        summary.Set ("title", Napi::String::New (env, title));
-        summary.Set ("path", Napi::String::New (env, path));
-        summary.Set ("processId", Napi::Number::New (env, static_cast<int> (pid)));
+            // Filter out zero or very small windows (likely invisible UI elements)
+            if (summary.bounds.width < 1 || summary.bounds.height < 1) {
+                isVisible = false;
+            }
 
-        // Bounds: Return raw physical coordinates - Electron handles DIP conversion
-        Napi::Object bounds = Napi::Object::New (env);
-        bounds.Set ("x", Napi::Number::New (env, rect.left));
-        bounds.Set ("y", Napi::Number::New (env, rect.top));
-        bounds.Set ("width", Napi::Number::New (env, rect.right - rect.left));
-        bounds.Set ("height", Napi::Number::New (env, rect.bottom - rect.top));
-        summary.Set ("bounds", bounds);
+            summary.isVisible = isVisible;
+        }
 
         // Z-order
-        auto zIt = zOrderMap.find (handle);
-        int zOrder = (zIt != zOrderMap.end ()) ? zIt->second : -1;
-        summary.Set ("zOrder", Napi::Number::New (env, zOrder));
-        
-        // Visibility
-        summary.Set ("isVisible", Napi::Boolean::New (env, isVisible));
+        summary.zOrder = zOrderMap.find (reinterpret_cast<int64_t> (handle));
 
-        arr.Set (resultIndex++, summary);
+        results.push_back (std::move (summary));
     }
 
     // Cleanup
     if (hDwmapi) {
         FreeLibrary (hDwmapi);
     }
+    wm::stats ().add (wm::STAT_NATIVE_CALLS, nativeCalls);
 
-    return arr;
+    // Close the handles of processes that no longer own a listed window
+    g_processCache.retain (livePids);
+
+    if (fields & wm::SUMMARY_VISIBLE_REGION)
+        wm::computeVisibleRegions (results, collectMonitorRects ());
+    if (fields & wm::SUMMARY_LOGICAL_BOUNDS)
+        wm::computeLogicalBounds (results, collectMonitorScales ());
+
+    wm::projectWindowRecords (results, requested);
+    return results;
+}
+
+// Helper function to build windows summary
+Napi::Array buildWindowsSummary(Napi::Env env, unsigned fields) {
+    auto filter = addonState (env).windowFilter.get ();
+    return windowRecordsToArray (env, collectWindowsSummary (*filter, fields), fields);
+}
+
+Napi::Value getWindowsSummary (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return env.Undefined ();
+    return buildWindowsSummary(env, fields);
 }
 
-Napi::Array getWindowsSummary (const Napi::CallbackInfo& info) {
+Napi::Value getWindowsSummaryBinary (const Napi::CallbackInfo& info) {
     Napi::Env env{ info.Env () };
-    return buildWindowsSummary(env);
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return env.Undefined ();
+    auto filter = addonState (env).windowFilter.get ();
+    return windowRecordsToArrayBuffer (env, collectWindowsSummary (*filter, fields));
+}
+
+Napi::Array getWindows (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    return NativeWindow::fromInfos (env, addonState (env), collectWindowInfos ());
+}
+
+// Async variants: enumeration and process queries run on the thread pool,
+// so a hung window cannot stall the event loop
+Napi::Promise getWindowsAsync (const Napi::CallbackInfo& info) {
+    return queueCollect<std::vector<WindowInfo>> (info.Env (), collectWindowInfos,
+                                                  [] (Napi::Env env, const std::vector<WindowInfo>& windows) {
+                                                      return NativeWindow::fromInfos (env, addonState (env), windows);
+                                                  });
+}
+
+Napi::Promise getMonitorsAsync (const Napi::CallbackInfo& info) {
+    return queueCollect<std::vector<int64_t>> (info.Env (), collectMonitors, marshalHandles);
+}
+
+Napi::Value getWindowsSummaryAsync (const Napi::CallbackInfo& info) {
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return info.Env ().Undefined ();
+    // The rules in force now, even if they are replaced before the worker runs
+    auto filter = addonState (info.Env ()).windowFilter.get ();
+    return queueCollect<std::vector<wm::WindowRecord>> (
+    info.Env (), [filter, fields] { return collectWindowsSummary (*filter, fields); },
+    [fields] (Napi::Env env, const std::vector<wm::WindowRecord>& windows) {
+        return windowRecordsToArray (env, windows, fields);
+    });
+}
+
+Napi::Value getWindowsSummaryBinaryAsync (const Napi::CallbackInfo& info) {
+    unsigned fields;
+    if (!readSummaryFields (info, 0, fields)) return info.Env ().Undefined ();
+    auto filter = addonState (info.Env ()).windowFilter.get ();
+    return queueCollect<std::vector<uint8_t>> (
+    info.Env (), [filter, fields] { return wm::serializeWindowColumns (collectWindowsSummary (*filter, fields)); },
+    marshalBytes);
+}
+
+Napi::Object getProcessCacheStats (const Napi::CallbackInfo& info) {
+    Napi::Env env{ info.Env () };
+    return processCacheStatsToObject (env, g_processCache.stats ());
+}
+
+Napi::Object getStats (const Napi::CallbackInfo& info) {
+    wm::ProcessCacheStats processCache = g_processCache.stats ();
+    return statsToObject (info.Env (), &processCache);
+}
+
+Napi::Value resetStats (const Napi::CallbackInfo& info) {
+    wm::stats ().reset ();
+    g_processCache.resetStats ();
+    return info.Env ().Undefined ();
 }
 
 Napi::Object getMonitorInfo (const Napi::CallbackInfo& info) {
@@ -783,18 +1084,29 @@ Napi::Boolean showInstantly (const Napi::CallbackInfo& info) {
     return Napi::Boolean::New (env, true);
 }
 
-// Helper function to invoke JS callback with window summary
-static void invokeWindowsSummaryCallback() {
-    if (!g_monitoring || !g_tsfn) {
+// Helper function to invoke JS callback with window summary. Collection and
+// diffing run on the monitor thread; only the marshalling happens on the JS
+// thread.
+static void invokeWindowsSummaryCallback(AddonState& state) {
+    if (!state.monitoring || !state.tsfn || !state.collectsWindows()) {
         return;
     }
 
-    auto callback = [](Napi::Env env, Napi::Function jsCallback) {
-        Napi::Array summaries = buildWindowsSummary(env);
-        jsCallback.Call({ summaries });
-    };
+    MonitorTrace trace = MonitorTrace::begin(state.firstPendingEvent);
+    state.firstPendingEvent = 0;
 
-    g_tsfn.NonBlockingCall(callback);
+    std::vector<wm::WindowRecord> snapshot;
+    {
+        wm::TraceScope scope("collect", trace.id);
+        snapshot = collectWindowsSummary(*state.windowFilter.get());
+        state.spatialIndex.set(std::make_shared<wm::SpatialIndex>(snapshot));
+    }
+
+    MonitorUpdate* update =
+        makeMonitorUpdate(state.differ, state.initialSummarySent, std::move(snapshot), state.monitorOptions, trace);
+    if (!update) return;
+
+    state.mailbox.post(state.tsfn, update, state.monitorOptions);
 }
 
 // Forward declaration for timer callback
@@ -810,261 +1122,279 @@ void CALLBACK WinEventProc(
     DWORD dwEventThread,
     DWORD dwmsEventTime
 ) {
-    if (!g_monitoring || !g_tsfn) {
+    AddonState* state = t_monitorState;
+    if (!state || !state->monitoring || !state->tsfn) {
         return;
     }
 
+    wm::stats().add(wm::STAT_MONITOR_EVENTS);
+
     // Only process window-level events (not child controls)
     if (idObject != OBJID_WINDOW || idChild != CHILDID_SELF) {
         return;
     }
+    wm::stats().add(wm::STAT_MONITOR_RELEVANT_EVENTS);
+    wm::traceInstant("win-event", 0, "event", event);
+
+    // Not throttled: listeners hear about a new foreground window at once.
+    // Same handle as GetForegroundWindow
+    if (event == EVENT_SYSTEM_FOREGROUND) {
+        state->postActivation(reinterpret_cast<int64_t>(hwnd));
+    }
+    if (!state->collectsWindows()) {
+        return;
+    }
+
+    if (!state->firstPendingEvent && wm::tracer().enabled()) state->firstPendingEvent = wm::traceNow();
 
     // Throttle: check if enough time has passed since last processing
     DWORD now = GetTickCount();
-    DWORD lastTime = g_lastProcessedTime.load();
-    DWORD elapsed = now - lastTime;
+    DWORD elapsed = now - state->lastProcessedTime;
 
     if (elapsed >= THROTTLE_MS) {
         // Enough time passed - process immediately
-        g_lastProcessedTime.store(now);
-        g_pendingTrailingUpdate.store(false);
+        state->lastProcessedTime = now;
+        state->pendingTrailingUpdate = false;
         
         // Cancel any pending timer
-        if (g_throttleTimerId) {
-            KillTimer(NULL, g_throttleTimerId);
-            g_throttleTimerId = 0;
+        if (state->throttleTimerId) {
+            KillTimer(NULL, state->throttleTimerId);
+            state->throttleTimerId = 0;
         }
         
-        invokeWindowsSummaryCallback();
-    } else if (!g_pendingTrailingUpdate.exchange(true)) {
+        invokeWindowsSummaryCallback(*state);
+    } else if (!state->pendingTrailingUpdate) {
         // Schedule trailing-edge timer to capture final state
+        state->pendingTrailingUpdate = true;
+        wm::traceInstant("throttled");
         UINT delay = THROTTLE_MS - elapsed;
-        g_throttleTimerId = SetTimer(NULL, 0, delay, ThrottleTimerProc);
+        state->throttleTimerId = SetTimer(NULL, 0, delay, ThrottleTimerProc);
     }
     // else: timer already pending, do nothing - it will capture the final state
 }
 
 // Timer callback for trailing-edge throttle updates
 void CALLBACK ThrottleTimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime) {
+    wm::traceInstant("throttle-timer");
     KillTimer(NULL, idEvent);
-    g_throttleTimerId = 0;
-    g_lastProcessedTime.store(GetTickCount());
-    g_pendingTrailingUpdate.store(false);
+
+    AddonState* state = t_monitorState;
+    if (!state) return;
+    state->throttleTimerId = 0;
+    state->lastProcessedTime = GetTickCount();
+    state->pendingTrailingUpdate = false;
     
-    invokeWindowsSummaryCallback();
+    invokeWindowsSummaryCallback(*state);
 }
 
-void MonitorThreadProc() {
-    g_monitorThreadId = GetCurrentThreadId();
+void MonitorThreadProc(AddonState* state) {
+    t_monitorState = state;
+    wm::tracer().nameThread("WinEvent monitor");
 
-    // Force creation of message queue
+    // Force creation of message queue, then let stopMonitor post to it
     MSG msg;
     PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+    state->monitorThreadId = GetCurrentThreadId();
 
     // Set up the event hook for multiple events
-    g_hooks.push_back(SetWinEventHook(
-        EVENT_OBJECT_LOCATIONCHANGE,
+    const DWORD events[] = {
         EVENT_OBJECT_LOCATIONCHANGE,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
         EVENT_OBJECT_REORDER,
-        EVENT_OBJECT_REORDER,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
         EVENT_OBJECT_CREATE,
-        EVENT_OBJECT_CREATE,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
-        EVENT_OBJECT_DESTROY,
         EVENT_OBJECT_DESTROY,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
-        EVENT_SYSTEM_MOVESIZEEND,
         EVENT_SYSTEM_MOVESIZEEND,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
         EVENT_SYSTEM_FOREGROUND,
-        EVENT_SYSTEM_FOREGROUND,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
-        EVENT_SYSTEM_MINIMIZESTART,
         EVENT_SYSTEM_MINIMIZESTART,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
-
-    g_hooks.push_back(SetWinEventHook(
-        EVENT_SYSTEM_MINIMIZEEND,
         EVENT_SYSTEM_MINIMIZEEND,
-        NULL,
-        WinEventProc,
-        0,
-        0,
-        WINEVENT_OUTOFCONTEXT
-    ));
+    };
+    for (DWORD event : events) {
+        state->hooks.push_back(SetWinEventHook(event, event, NULL, WinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT));
+    }
 
     // Message loop
     while (GetMessage(&msg, NULL, 0, 0)) {
         if (msg.message == WM_QUIT) break;
+        // New options: refresh, so a listener that was just added gets its
+        // first summary
+        if (msg.message == WM_APP && msg.hwnd == NULL) {
+            invokeWindowsSummaryCallback(*state);
+            continue;
+        }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
 
-    // Cleanup hooks
-    for (auto hook : g_hooks) {
+    // Cleanup hooks; the thread's timers go with its message queue
+    for (auto hook : state->hooks) {
         if (hook) UnhookWinEvent(hook);
     }
-    g_hooks.clear();
+    state->hooks.clear();
+    state->throttleTimerId = 0;
+    t_monitorState = nullptr;
 }
 
 Napi::Value startWindowsMonitoring(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
+    AddonState& state = addonState(env);
 
-    if (g_monitoring) {
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Function callback expected").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    if (info.Length() < 1 || !info[0].IsFunction()) {
-        Napi::TypeError::New(env, "Function callback expected").ThrowAsJavaScriptException();
+    // Calling again while running only updates what gets delivered
+    if (!readMonitorOptions(info, state.monitorOptions)) {
+        return env.Undefined();
+    }
+    if (state.monitoring) {
+        if (state.monitorThreadId != 0) {
+            PostThreadMessage(state.monitorThreadId, WM_APP, 0, 0);
+        }
         return env.Undefined();
     }
 
     Napi::Function callback = info[0].As<Napi::Function>();
 
-    // Create thread-safe function
-    g_tsfn = Napi::ThreadSafeFunction::New(
+    // The finalizer also runs when the environment shuts down, e.g. a worker
+    // exiting while it monitors; the thread has to be gone before the function
+    AddonState* owner = &state;
+    uint64_t generation = ++state.generation;
+    state.tsfn = Napi::ThreadSafeFunction::New(
         env,
         callback,
         "WindowsMonitoringCallback",
         0,
         1,
-        [](Napi::Env) {
-            // Cleanup when TSFN is finalized
-            // We handle cleanup in stopWindowsMonitoring mainly
+        [owner, generation](Napi::Env) {
+            if (owner->generation == generation) owner->stopMonitor();
         }
     );
 
-    g_monitoring = true;
+    state.differ.reset();
+    state.initialSummarySent = false;
+    state.lastActiveWindow = 0;
+    state.mailbox.open();
+    state.lastProcessedTime = 0;
+    state.pendingTrailingUpdate = false;
+    state.firstPendingEvent = 0;
+    state.monitoring = true;
     
     // Start the monitor thread
-    g_monitorThread = new std::thread(MonitorThreadProc);
+    state.monitorThread = std::thread(MonitorThreadProc, owner);
 
     return env.Undefined();
 }
 
-Napi::Value stopWindowsMonitoring(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-
-    if (!g_monitoring) {
-        return env.Undefined();
+// Stops and joins the monitor thread; the caller releases the function.
+// Does nothing if no monitor runs.
+void AddonState::stopMonitor() {
+    if (!monitoring.exchange(false) && !monitorThread.joinable()) {
+        return;
     }
 
-    // Cancel any pending throttle timer
-    if (g_throttleTimerId) {
-        KillTimer(NULL, g_throttleTimerId);
-        g_throttleTimerId = 0;
+    // Signal thread to exit. Its id is published once it has a message
+    // queue, so the quit message cannot get lost
+    while (monitorThread.joinable() && !monitorThreadId) {
+        std::this_thread::yield();
     }
-    g_pendingTrailingUpdate.store(false);
-    g_lastProcessedTime.store(0);
-
-    // Signal thread to exit
-    if (g_monitorThreadId != 0) {
-        PostThreadMessage(g_monitorThreadId, WM_QUIT, 0, 0);
+    if (monitorThreadId != 0) {
+        PostThreadMessage(monitorThreadId, WM_QUIT, 0, 0);
     }
+    // Releases the thread if it is blocked on a full queue
+    mailbox.close();
 
-    if (g_monitorThread) {
-        if (g_monitorThread->joinable()) {
-            g_monitorThread->join();
-        }
-        delete g_monitorThread;
-        g_monitorThread = nullptr;
+    if (monitorThread.joinable()) {
+        monitorThread.join();
     }
-    g_monitorThreadId = 0;
+    monitorThreadId = 0;
+
+    // Nothing keeps the index current any more
+    spatialIndex.set(nullptr);
+}
+
+Napi::Value stopWindowsMonitoring(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonState& state = addonState(env);
 
-    if (g_tsfn) {
-        g_tsfn.Release();
+    if (!state.monitoring) {
+        return env.Undefined();
     }
 
-    g_monitoring = false;
+    state.stopMonitor();
+    if (state.tsfn) {
+        state.tsfn.Release();
+    }
 
     return env.Undefined();
 }
 
+Napi::Value windowAt (const Napi::CallbackInfo& info) {
+    AddonState& state = addonState (info.Env ());
+    return queryWindowAt (info, state.spatialIndex,
+                          [&state] { return collectWindowsSummary (*state.windowFilter.get ()); });
+}
+
+Napi::Value windowsIntersecting (const Napi::CallbackInfo& info) {
+    AddonState& state = addonState (info.Env ());
+    return queryWindowsIntersecting (info, state.spatialIndex,
+                                     [&state] { return collectWindowsSummary (*state.windowFilter.get ()); });
+}
+
 Napi::Object Init (Napi::Env env, Napi::Object exports) {
-    exports.Set (Napi::String::New (env, "getActiveWindow"), Napi::Function::New (env, getActiveWindow));
-    exports.Set (Napi::String::New (env, "getMonitorFromWindow"), Napi::Function::New (env, getMonitorFromWindow));
-    exports.Set (Napi::String::New (env, "getMonitorScaleFactor"),
-                 Napi::Function::New (env, getMonitorScaleFactor));
-    exports.Set (Napi::String::New (env, "setWindowBounds"), Napi::Function::New (env, setWindowBounds));
-    exports.Set (Napi::String::New (env, "showWindow"), Napi::Function::New (env, showWindow));
-    exports.Set (Napi::String::New (env, "bringWindowToTop"), Napi::Function::New (env, bringWindowToTop));
-    exports.Set (Napi::String::New (env, "redrawWindow"), Napi::Function::New (env, redrawWindow));
-    exports.Set (Napi::String::New (env, "isWindow"), Napi::Function::New (env, isWindow));
-    exports.Set (Napi::String::New (env, "isWindowVisible"), Napi::Function::New (env, isWindowVisible));
-    exports.Set (Napi::String::New (env, "setWindowOpacity"), Napi::Function::New (env, setWindowOpacity));
-    exports.Set (Napi::String::New (env, "toggleWindowTransparency"),
-                 Napi::Function::New (env, toggleWindowTransparency));
-    exports.Set (Napi::String::New (env, "setWindowParent"), Napi::Function::New (env, setWindowParent));
-    exports.Set (Napi::String::New (env, "initWindow"), Napi::Function::New (env, initWindow));
-    exports.Set (Napi::String::New (env, "getWindowBounds"), Napi::Function::New (env, getWindowBounds));
-    exports.Set (Napi::String::New (env, "getWindowTitle"), Napi::Function::New (env, getWindowTitle));
-    exports.Set (Napi::String::New (env, "getWindowName"), Napi::Function::New (env, getWindowName));
-    exports.Set (Napi::String::New (env, "getWindowOwner"), Napi::Function::New (env, getWindowOwner));
-    exports.Set (Napi::String::New (env, "getWindowOpacity"), Napi::Function::New (env, getWindowOpacity));
-    exports.Set (Napi::String::New (env, "getMonitorInfo"), Napi::Function::New (env, getMonitorInfo));
-    exports.Set (Napi::String::New (env, "getWindows"), Napi::Function::New (env, getWindows));
-    exports.Set (Napi::String::New (env, "getMonitors"), Napi::Function::New (env, getMonitors));
-    exports.Set (Napi::String::New (env, "createProcess"), Napi::Function::New (env, createProcess));
-    exports.Set (Napi::String::New (env, "getProcessMainWindow"), Napi::Function::New (env, getProcessMainWindow));
-    exports.Set (Napi::String::New (env, "forceWindowPaint"), Napi::Function::New (env, forceWindowPaint));
-    exports.Set (Napi::String::New (env, "hideInstantly"), Napi::Function::New (env, hideInstantly));
-    exports.Set (Napi::String::New (env, "setWindowAsPopup"), Napi::Function::New (env, setWindowAsPopup));
-    exports.Set (Napi::String::New (env, "setWindowAsPopupWithRoundedCorners"),
-                 Napi::Function::New (env, setWindowAsPopupWithRoundedCorners));
-    exports.Set (Napi::String::New (env, "showInstantly"), Napi::Function::New (env, showInstantly));
-    exports.Set (Napi::String::New (env, "getWindowZOrder"), Napi::Function::New (env, getWindowZOrder));
-    exports.Set (Napi::String::New (env, "getWindowsSummary"), Napi::Function::New (env, getWindowsSummary));
-    exports.Set (Napi::String::New (env, "startWindowsMonitoring"), Napi::Function::New (env, startWindowsMonitoring));
-    exports.Set (Napi::String::New (env, "stopWindowsMonitoring"), Napi::Function::New (env, stopWindowsMonitoring));
+    // Deleted with the environment, after the monitor's finalizer stopped it
+    AddonState* state = new AddonState ();
+    env.SetInstanceData (state);
+    NativeWindow::Init (env, exports, *state);
+
+    exportFunction (exports, "getActiveWindow", getActiveWindow);
+    exportFunction (exports, "getMonitorFromWindow", getMonitorFromWindow);
+    exportFunction (exports, "getMonitorScaleFactor", getMonitorScaleFactor);
+    exportFunction (exports, "getWindowScaleFactor", getWindowScaleFactor);
+    exportFunction (exports, "setWindowBounds", setWindowBounds);
+    exportFunction (exports, "showWindow", showWindow);
+    exportFunction (exports, "applyLayout", applyLayout);
+    exportFunction (exports, "tileWindows", tileWindows);
+    exportFunction (exports, "bringWindowToTop", bringWindowToTop);
+    exportFunction (exports, "redrawWindow", redrawWindow);
+    exportFunction (exports, "isWindow", isWindow);
+    exportFunction (exports, "isWindowVisible", isWindowVisible);
+    exportFunction (exports, "setWindowOpacity", setWindowOpacity);
+    exportFunction (exports, "toggleWindowTransparency", toggleWindowTransparency);
+    exportFunction (exports, "setWindowParent", setWindowParent);
+    exportFunction (exports, "initWindow", initWindow);
+    exportFunction (exports, "getProcessCacheStats", getProcessCacheStats);
+    exportFunction (exports, "getStats", getStats);
+    exportFunction (exports, "resetStats", resetStats);
+    exportFunction (exports, "startTracing", startTracing);
+    exportFunction (exports, "stopTracing", stopTracing);
+    exportFunction (exports, "dumpTrace", dumpTrace);
+    exportFunction (exports, "getWindowBounds", getWindowBounds);
+    exportFunction (exports, "getWindowTitle", getWindowTitle);
+    exportFunction (exports, "getWindowName", getWindowName);
+    exportFunction (exports, "getWindowOwner", getWindowOwner);
+    exportFunction (exports, "getWindowOpacity", getWindowOpacity);
+    exportFunction (exports, "getMonitorInfo", getMonitorInfo);
+    exportFunction (exports, "getWindows", getWindows);
+    exportFunction (exports, "getMonitors", getMonitors);
+    exportFunction (exports, "createProcess", createProcess);
+    exportFunction (exports, "getProcessMainWindow", getProcessMainWindow);
+    exportFunction (exports, "forceWindowPaint", forceWindowPaint);
+    exportFunction (exports, "hideInstantly", hideInstantly);
+    exportFunction (exports, "setWindowAsPopup", setWindowAsPopup);
+    exportFunction (exports, "setWindowAsPopupWithRoundedCorners", setWindowAsPopupWithRoundedCorners);
+    exportFunction (exports, "showInstantly", showInstantly);
+    exportFunction (exports, "getWindowZOrder", getWindowZOrder);
+    exportFunction (exports, "getWindowsSummary", getWindowsSummary);
+    exportFunction (exports, "getWindowsSummaryBinary", getWindowsSummaryBinary);
+    exportFunction (exports, "setWindowFilters", setWindowFilters);
+    exportFunction (exports, "getWindowsAsync", getWindowsAsync);
+    exportFunction (exports, "getMonitorsAsync", getMonitorsAsync);
+    exportFunction (exports, "getWindowsSummaryAsync", getWindowsSummaryAsync);
+    exportFunction (exports, "getWindowsSummaryBinaryAsync", getWindowsSummaryBinaryAsync);
+    exportFunction (exports, "windowAt", windowAt);
+    exportFunction (exports, "windowsIntersecting", windowsIntersecting);
+    exportFunction (exports, "startWindowsMonitoring", startWindowsMonitoring);
+    exportFunction (exports, "stopWindowsMonitoring", stopWindowsMonitoring);
     return exports;
 }
 
@@ -0,0 +1,80 @@
+import { execFileSync } from "node:child_process"
+import { existsSync, readFileSync, writeFileSync } from "node:fs"
+import { fileURLToPath } from "node:url"
+import { addon } from "../dist/index.js"
+
+// Per-call latency of the single-window exports, next to a baseline:
+//   npm run bench:calls
+//   BASELINE=before.json node scripts/bench-calls.mjs
+// On Linux the baseline is test/e2e/baseline_calls.cc, the exports as they
+// were before the shared X connection, run on the same display. BASELINE=
+// replaces it with a recorded run, e.g. the JSON this script writes to OUT=.
+
+const ITERATIONS = Number(process.env.ITERATIONS ?? 2000)
+const BASELINE = process.env.BASELINE
+const OUT = process.env.OUT
+const baselineBinary = fileURLToPath(new URL("../build/Release/baseline_calls", import.meta.url))
+
+function percentile(sorted, p) {
+  if (sorted.length === 0) return 0
+  const idx = Math.min(sorted.length - 1, Math.floor((p / 100) * sorted.length))
+  return sorted[idx]
+}
+
+function measure(fn) {
+  // Warm up so the first connection / atom interning is not counted
+  for (let i = 0; i < 20; i++) fn()
+
+  const samples = new Array(ITERATIONS)
+  for (let i = 0; i < ITERATIONS; i++) {
+    const start = process.hrtime.bigint()
+    fn()
+    samples[i] = Number(process.hrtime.bigint() - start) / 1e3
+  }
+
+  samples.sort((a, b) => a - b)
+  const mean = samples.reduce((sum, v) => sum + v, 0) / samples.length
+  return { mean, p50: percentile(samples, 50), p95: percentile(samples, 95), p99: percentile(samples, 99) }
+}
+
+function loadBaseline(active) {
+  if (BASELINE) return JSON.parse(readFileSync(BASELINE, "utf8"))
+  if (process.platform !== "linux" || !existsSync(baselineBinary)) return null
+  const args = [String(ITERATIONS), String(active ?? 0)]
+  return JSON.parse(execFileSync(baselineBinary, args, { encoding: "utf8" }))
+}
+
+function report(name, after, before) {
+  const fmt = v => v.toFixed(1).padStart(9)
+  const line = stats =>
+    `mean=${fmt(stats.mean)}us p50=${fmt(stats.p50)}us p95=${fmt(stats.p95)}us p99=${fmt(stats.p99)}us`
+  console.log(`${name.padEnd(20)} after  ${line(after)}`)
+  if (!before) return
+  console.log(`${"".padEnd(20)} before ${line(before)}  (p50 ${(before.p50 / after.p50).toFixed(1)}x)`)
+}
+
+function main() {
+  if (!addon) {
+    console.error("Native addon not available")
+    process.exitCode = 1
+    return
+  }
+
+  const active = addon.getActiveWindow()
+  console.log(`Measuring ${ITERATIONS} calls per export (active window ${active})\n`)
+
+  const results = { getActiveWindow: measure(() => addon.getActiveWindow()) }
+  if (active) {
+    results.getWindowBounds = measure(() => addon.getWindowBounds(active))
+    results.getWindowZOrder = measure(() => addon.getWindowZOrder(active))
+    results.isWindow = measure(() => addon.isWindow(active))
+  }
+
+  const baseline = loadBaseline(active)
+  if (!baseline) console.log("No baseline: set BASELINE= or build with --e2e_bench=true on Linux\n")
+  for (const [name, after] of Object.entries(results)) report(name, after, baseline?.[name])
+
+  if (OUT) writeFileSync(OUT, JSON.stringify(results, null, 2) + "\n")
+}
+
+main()
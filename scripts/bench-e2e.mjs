@@ -0,0 +1,161 @@
+import { execFileSync } from "node:child_process"
+import { writeFileSync } from "node:fs"
+import { once } from "node:events"
+import os from "node:os"
+import { sleep, spawnWindows, startWindowManager, startXvfb, stopAll, waitFor } from "../test/e2e/harness.mjs"
+
+// End-to-end benchmark on a private Xvfb server with the stand-in window
+// manager from test/e2e. For every population size it maps that many
+// synthetic windows, measures per-call latency of the exports and the delay
+// between a window move and its "windows-changed" event, then writes JSON:
+//
+//   npm run bench:e2e
+//   SIZES=10,100 ITERATIONS=500 OUT=before.json node scripts/bench-e2e.mjs
+
+const SIZES = (process.env.SIZES ?? "10,100,1000,5000").split(",").map(Number)
+const ITERATIONS = Number(process.env.ITERATIONS ?? 500)
+const EVENT_SAMPLES = Number(process.env.EVENT_SAMPLES ?? 50)
+const OUT = process.env.OUT ?? "bench-e2e.json"
+const SCREEN = process.env.SCREEN ?? "1920x1080x24"
+
+function percentile(sorted, p) {
+  if (sorted.length === 0) return 0
+  const idx = Math.min(sorted.length - 1, Math.floor((p / 100) * sorted.length))
+  return sorted[idx]
+}
+
+// Microseconds
+function summarize(samples) {
+  samples.sort((a, b) => a - b)
+  const mean = samples.reduce((sum, v) => sum + v, 0) / samples.length
+  const round = v => Math.round(v * 10) / 10
+  return {
+    n: samples.length,
+    mean: round(mean),
+    p50: round(percentile(samples, 50)),
+    p95: round(percentile(samples, 95)),
+    p99: round(percentile(samples, 99)),
+    max: round(samples[samples.length - 1]),
+  }
+}
+
+function measure(fn, iterations) {
+  for (let i = 0; i < Math.min(20, iterations); i++) fn()
+
+  const samples = new Array(iterations)
+  for (let i = 0; i < iterations; i++) {
+    const start = process.hrtime.bigint()
+    fn()
+    samples[i] = Number(process.hrtime.bigint() - start) / 1e3
+  }
+  return summarize(samples)
+}
+
+// Window-to-event latency: move one window and wait for the delta that
+// reports it. Samples are spaced beyond the monitor's 64ms throttle so each
+// one measures the leading edge.
+async function measureEvents(windowManager, id) {
+  const samples = []
+  let pending = null
+
+  const listener = changes => {
+    if (!pending) return
+    if (changes.some(change => change.id === id && change.kind === "moved")) {
+      samples.push(Number(process.hrtime.bigint() - pending) / 1e3)
+      pending = null
+    }
+  }
+  windowManager.on("windows-changed", listener)
+  await sleep(200)
+
+  for (let i = 0; i < EVENT_SAMPLES; i++) {
+    pending = process.hrtime.bigint()
+    windowManager.applyLayout([{ id, bounds: { x: 10 + (i % 2) * 20, y: 10 } }])
+    const deadline = Date.now() + 2000
+    while (pending && Date.now() < deadline) await sleep(1)
+    pending = null
+    await sleep(80)
+  }
+
+  windowManager.off("windows-changed", listener)
+  return summarize(samples)
+}
+
+async function benchmarkSize(windowManager, addon, size) {
+  const clients = spawnWindows(size)
+  const listed = () => addon.getWindowsSummary({ fields: ["id"] }).length
+  await waitFor(() => listed() >= size, `${size} windows`)
+
+  const ids = addon.getWindowsSummary({ fields: ["id"] }).map(w => w.id)
+  const target = ids[Math.floor(ids.length / 2)]
+  windowManager.applyLayout([{ id: target, raise: true }])
+  await waitFor(() => addon.getActiveWindow() === target, "the target window to activate", 5000)
+
+  // Whole-desktop calls get fewer iterations as the population grows
+  const summaryIterations = Math.max(20, Math.min(ITERATIONS, Math.floor(50000 / size)))
+  const result = {
+    windows: ids.length,
+    getWindowBounds: measure(() => addon.getWindowBounds(target), ITERATIONS),
+    getWindowZOrder: measure(() => addon.getWindowZOrder(target), ITERATIONS),
+    getActiveWindow: measure(() => addon.getActiveWindow(), ITERATIONS),
+    getWindowsSummary: measure(() => addon.getWindowsSummary(), summaryIterations),
+    getWindowsSummaryBinary: measure(() => addon.getWindowsSummaryBinary(), summaryIterations),
+    windowsChangedLatency: await measureEvents(windowManager, target),
+  }
+
+  clients.stdin.end()
+  await once(clients, "exit")
+  await waitFor(() => listed() === 0, "the windows to close")
+  return result
+}
+
+function commit() {
+  try {
+    return execFileSync("git", ["rev-parse", "--short", "HEAD"], { encoding: "utf8" }).trim()
+  } catch {
+    return null
+  }
+}
+
+async function main() {
+  const display = await startXvfb(SCREEN)
+  await startWindowManager(display)
+
+  // The addon opens its display on first use
+  process.env.DISPLAY = display
+  const { windowManager, addon } = await import("../dist/index.js")
+
+  const results = {
+    commit: commit(),
+    date: new Date().toISOString(),
+    node: process.version,
+    cpu: os.cpus()[0]?.model,
+    iterations: ITERATIONS,
+    unit: "us",
+    sizes: {},
+  }
+
+  for (const size of SIZES) {
+    const result = await benchmarkSize(windowManager, addon, size)
+    results.sizes[size] = result
+    console.log(`${String(size).padStart(5)} windows`)
+    for (const [name, stats] of Object.entries(result)) {
+      if (typeof stats !== "object") continue
+      console.log(`  ${name.padEnd(24)} p50=${stats.p50}us p95=${stats.p95}us p99=${stats.p99}us`)
+    }
+  }
+
+  writeFileSync(OUT, JSON.stringify(results, null, 2) + "\n")
+  console.log(`\nwrote ${OUT}`)
+}
+
+main()
+  .catch(error => {
+    console.error(error)
+    process.exitCode = 1
+  })
+  .finally(() => {
+    stopAll()
+    // The window monitor thread keeps the process alive otherwise
+    setTimeout(() => process.exit(), 100)
+  })
@@ -15,66 +15,45 @@ function formatWindowLine(rank, z, title, bounds, exeName, isVisible) {
   return `  #${rank} [${zLabel}${visLabel}] "${safeTitle}" x=${x} y=${y} w=${width} h=${height}${exeLabel}`
 }
 
-let previousState = []
+// Current state, kept up to date from the native deltas
+const windows = new Map()
 let updateCount = 0
 let lastUpdateTime = process.hrtime.bigint()
 
-function compareStates(current, previous) {
-  const changes = []
-  
-  // Create maps for easier comparison
-  const prevMap = new Map(previous.map(w => [w.id, w]))
-  const currMap = new Map(current.map(w => [w.id, w]))
-  
-  // Check for new windows
-  for (const win of current) {
-    if (!prevMap.has(win.id)) {
-      changes.push({ type: 'created', window: win })
-    }
+function applyDelta(delta) {
+  if (delta.kind === 'created') {
+    windows.set(delta.id, delta.newValue)
+    return delta.newValue
   }
-  
-  // Check for closed windows
-  for (const win of previous) {
-    if (!currMap.has(win.id)) {
-      changes.push({ type: 'destroyed', window: win })
-    }
+  if (delta.kind === 'destroyed') {
+    windows.delete(delta.id)
+    return delta.oldValue
   }
-  
-  // Check for moved/resized/reordered windows
-  for (const win of current) {
-    const prev = prevMap.get(win.id)
-    if (prev) {
-      if (prev.zOrder !== win.zOrder) {
-        changes.push({ type: 'reordered', window: win, oldZ: prev.zOrder, newZ: win.zOrder })
-      }
-      if (prev.bounds.x !== win.bounds.x || prev.bounds.y !== win.bounds.y) {
-        changes.push({ type: 'moved', window: win, oldBounds: prev.bounds, newBounds: win.bounds })
-      }
-      if (prev.bounds.width !== win.bounds.width || prev.bounds.height !== win.bounds.height) {
-        changes.push({ type: 'resized', window: win, oldBounds: prev.bounds, newBounds: win.bounds })
-      }
-      if (prev.isVisible !== win.isVisible) {
-        changes.push({ type: 'visibility', window: win, visible: win.isVisible })
-      }
-    }
+
+  const win = windows.get(delta.id)
+  if (!win) return undefined
+  switch (delta.kind) {
+    case 'moved':
+    case 'resized':
+      win.bounds = delta.newValue
+      break
+    case 'reordered':
+      win.zOrder = delta.newValue
+      break
+    case 'visibility':
+      win.isVisible = delta.newValue
+      break
+    case 'retitled':
+      win.title = delta.newValue
+      break
   }
-  
-  return changes
+  return win
 }
 
-function handleWindowsUpdate(summaries) {
+function handleWindowsChanged(deltas) {
   const now = process.hrtime.bigint()
   const timeSinceLastUpdate = getElapsedMs(lastUpdateTime)
   
-  // Detect what changed
-  const changes = compareStates(summaries, previousState)
-  
-  // Skip updates with no changes
-  if (changes.length === 0) {
-    previousState = summaries
-    return
-  }
-  
   updateCount++
   lastUpdateTime = now
   
@@ -82,13 +61,14 @@ function handleWindowsUpdate(summaries) {
   console.log(`Update #${updateCount} (${timeSinceLastUpdate.toFixed(2)}ms since last update)`)
   console.log(`${"=".repeat(80)}`)
   
-  console.log(`\nDetected ${changes.length} change(s):`)
-  for (const change of changes) {
-    const w = change.window
+  console.log(`\nDetected ${deltas.length} change(s):`)
+  for (const delta of deltas) {
+    const w = applyDelta(delta) || {}
     const title = w.title || "(no title)"
     const exeName = w.path ? path.basename(w.path) : ""
+    const { oldValue, newValue } = delta
     
-    switch (change.type) {
+    switch (delta.kind) {
       case 'created':
         console.log(`  + NEW: "${title}" (${exeName}) - Z=${w.zOrder}`)
         break
@@ -96,23 +76,26 @@ function handleWindowsUpdate(summaries) {
         console.log(`  - CLOSED: "${title}" (${exeName})`)
         break
       case 'reordered':
-        console.log(`  ↕ REORDERED: "${title}" - Z: ${change.oldZ} → ${change.newZ}`)
+        console.log(`  ↕ REORDERED: "${title}" - Z: ${oldValue} → ${newValue}`)
         break
       case 'moved':
-        console.log(`  → MOVED: "${title}" - from (${change.oldBounds.x},${change.oldBounds.y}) to (${change.newBounds.x},${change.newBounds.y})`)
+        console.log(`  → MOVED: "${title}" - from (${oldValue.x},${oldValue.y}) to (${newValue.x},${newValue.y})`)
         break
       case 'resized':
-        console.log(`  ⇔ RESIZED: "${title}" - ${change.oldBounds.width}x${change.oldBounds.height} → ${change.newBounds.width}x${change.newBounds.height}`)
+        console.log(`  ⇔ RESIZED: "${title}" - ${oldValue.width}x${oldValue.height} → ${newValue.width}x${newValue.height}`)
         break
       case 'visibility':
-        console.log(`  👁 VISIBILITY: "${title}" - visible: ${change.visible}`)
+        console.log(`  👁 VISIBILITY: "${title}" - visible: ${newValue}`)
+        break
+      case 'retitled':
+        console.log(`  ✎ RETITLED: "${oldValue}" → "${newValue}"`)
         break
     }
   }
   
   // Filter visible windows only and sort by Z-order
-  const visibleWindows = summaries.filter(w => w.isVisible)
-  const sorted = [...visibleWindows].sort((a, b) => {
+  const visibleWindows = [...windows.values()].filter(w => w.isVisible)
+  const sorted = visibleWindows.sort((a, b) => {
     const az = a.zOrder >= 0 ? a.zOrder : Number.MAX_SAFE_INTEGER
     const bz = b.zOrder >= 0 ? b.zOrder : Number.MAX_SAFE_INTEGER
     return az - bz
@@ -127,8 +110,6 @@ function handleWindowsUpdate(summaries) {
   if (sorted.length > 10) {
     console.log(`  ... and ${sorted.length - 10} more windows`)
   }
-  
-  previousState = summaries
 }
 
 async function main() {
@@ -151,15 +132,15 @@ async function main() {
     console.log()
   }
   
-  // Register event listener
-  windowManager.on('windows-summary-updated', handleWindowsUpdate)
+  // Register event listener; the first batch reports every existing window as created
+  windowManager.on('windows-changed', handleWindowsChanged)
   
   console.log("Monitoring started. Waiting for window changes...")
   
   // Handle Ctrl+C gracefully
   process.on('SIGINT', () => {
     console.log("\n\nStopping window monitoring...")
-    windowManager.removeAllListeners('windows-summary-updated')
+    windowManager.removeAllListeners('windows-changed')
     console.log(`Total updates received: ${updateCount}`)
     process.exit(0)
   })
@@ -28,7 +28,9 @@ export class Monitor {
 
   getScaleFactor(): number {
     if (!addon || !addon.getMonitorScaleFactor) return;
+    if (process.platform !== "win32") return addon.getMonitorScaleFactor(this.id);
 
+    // GetScaleFactorForMonitor needs Windows 8.1
     const numbers = release()
       .split(".")
       .map(d => parseInt(d, 10));
@@ -0,0 +1,128 @@
+import { IRectangle, IWindowSummary } from "../interfaces"
+
+// Layout written by lib/core/window_columns.h
+const HEADER_WORDS = 4
+const COLUMN_ID = 0
+const COLUMN_PROCESS_ID = 1
+const COLUMN_X = 2
+const COLUMN_Y = 3
+const COLUMN_WIDTH = 4
+const COLUMN_HEIGHT = 5
+const COLUMN_Z_ORDER = 6
+const COLUMN_FLAGS = 7
+const COLUMN_TITLE = 8
+const COLUMN_PATH = 9
+const COLUMN_COUNT = 10
+const FLAG_VISIBLE = 1
+
+// Read-only view over the ArrayBuffer returned by getWindowsSummaryBinary().
+// Numeric fields are read straight from the typed arrays; titles and paths are
+// decoded on first access and shared between windows with the same string.
+export class WindowSummaryView {
+  public readonly length: number
+
+  private ids: Uint32Array
+  private columns: Int32Array
+  private offsets: Int32Array
+  private bytes: Buffer
+  private strings: string[]
+
+  constructor(buffer: ArrayBuffer) {
+    const header = new Int32Array(buffer, 0, HEADER_WORDS)
+    const count = header[1]
+    const stringCount = header[2]
+    const stringBytes = header[3]
+
+    const columnsOffset = HEADER_WORDS * 4
+    const offsetsOffset = columnsOffset + COLUMN_COUNT * count * 4
+    const bytesOffset = offsetsOffset + (stringCount + 1) * 4
+
+    this.length = count
+    this.ids = new Uint32Array(buffer, columnsOffset + COLUMN_ID * count * 4, count)
+    this.columns = new Int32Array(buffer, columnsOffset, COLUMN_COUNT * count)
+    this.offsets = new Int32Array(buffer, offsetsOffset, stringCount + 1)
+    this.bytes = Buffer.from(buffer, bytesOffset, stringBytes)
+    this.strings = new Array(stringCount)
+  }
+
+  private column(column: number, index: number) {
+    return this.columns[column * this.length + index]
+  }
+
+  private string(ref: number) {
+    let value = this.strings[ref]
+    if (value === undefined) {
+      value = this.bytes.toString("utf8", this.offsets[ref], this.offsets[ref + 1])
+      this.strings[ref] = value
+    }
+    return value
+  }
+
+  id(index: number): number {
+    return this.ids[index]
+  }
+
+  processId(index: number): number {
+    return this.column(COLUMN_PROCESS_ID, index)
+  }
+
+  x(index: number): number {
+    return this.column(COLUMN_X, index)
+  }
+
+  y(index: number): number {
+    return this.column(COLUMN_Y, index)
+  }
+
+  width(index: number): number {
+    return this.column(COLUMN_WIDTH, index)
+  }
+
+  height(index: number): number {
+    return this.column(COLUMN_HEIGHT, index)
+  }
+
+  bounds(index: number): IRectangle {
+    return {
+      x: this.x(index),
+      y: this.y(index),
+      width: this.width(index),
+      height: this.height(index)
+    }
+  }
+
+  zOrder(index: number): number {
+    return this.column(COLUMN_Z_ORDER, index)
+  }
+
+  isVisible(index: number): boolean {
+    return (this.column(COLUMN_FLAGS, index) & FLAG_VISIBLE) !== 0
+  }
+
+  title(index: number): string {
+    return this.string(this.column(COLUMN_TITLE, index))
+  }
+
+  path(index: number): string {
+    return this.string(this.column(COLUMN_PATH, index))
+  }
+
+  // Materialises one window as the same object getWindowsSummary() returns
+  get(index: number): IWindowSummary {
+    return {
+      id: this.id(index),
+      title: this.title(index),
+      path: this.path(index),
+      processId: this.processId(index),
+      bounds: this.bounds(index),
+      zOrder: this.zOrder(index),
+      isVisible: this.isVisible(index)
+    }
+  }
+
+  toArray(): IWindowSummary[] {
+    const result = new Array(this.length)
+    for (let i = 0; i < this.length; i++) result[i] = this.get(i)
+    return result
+  }
+}
@@ -1,6 +1,6 @@
 import { addon } from ".."
 import { Monitor } from "./monitor"
-import { IRectangle } from "../interfaces"
+import { IBoundsOptions, INativeWindow, IRectangle } from "../interfaces"
 import { EmptyMonitor } from "./empty-monitor"
 
 export class Window {
@@ -8,50 +8,60 @@ export class Window {
 
   public processId: number
   public path: string
+  // Win32 window class, the WM_CLASS class on Linux, the bundle identifier
+  // on macOS
+  public className: string
 
-  constructor(id: number) {
+  private native: INativeWindow
+
+  // getWindows() passes the native objects it got, already populated; a
+  // handle loads its window natively in one call
+  constructor(window: number | INativeWindow) {
     if (!addon) return
 
+    this.native = typeof window === "number" ? new addon.NativeWindow(window) : window
+    this.copyNative()
+  }
+
+  // Reloads processId, path and className, which are otherwise read once
+  refresh() {
+    if (!addon) return
+    this.native.refresh()
+    this.copyNative()
+  }
+
+  private copyNative() {
+    const { id, processId, path, className } = this.native
     this.id = id
-    const { processId, path } = addon.initWindow(id)
     this.processId = processId
     this.path = path
+    this.className = className
   }
 
-  getBounds(): IRectangle {
+  // Scaled natively, with the monitor's cached scale factor
+  getBounds(options: IBoundsOptions = {}): IRectangle {
     if (!addon) return
 
-    const bounds = addon.getWindowBounds(this.id)
-
-    if (process.platform === "win32") {
-      const sf = this.getMonitor().getScaleFactor()
-
-      bounds.x = Math.floor(bounds.x / sf)
-      bounds.y = Math.floor(bounds.y / sf)
-      bounds.width = Math.floor(bounds.width / sf)
-      bounds.height = Math.floor(bounds.height / sf)
-    }
-
-    return bounds
+    const logical = options.logical ?? process.platform === "win32"
+    return addon.getWindowBounds(this.id, { logical })
   }
 
   setBounds(bounds: IRectangle) {
     if (!addon) return
 
-    const newBounds = { ...this.getBounds(), ...bounds }
+    // Unset properties keep their value natively, so there is no getBounds()
+    // round trip first
+    const newBounds = { ...bounds }
 
     if (process.platform === "win32") {
-      const sf = this.getMonitor().getScaleFactor()
+      const sf = addon.getWindowScaleFactor(this.id)
 
-      newBounds.x = Math.floor(newBounds.x * sf)
-      newBounds.y = Math.floor(newBounds.y * sf)
-      newBounds.width = Math.floor(newBounds.width * sf)
-      newBounds.height = Math.floor(newBounds.height * sf)
-
-      addon.setWindowBounds(this.id, newBounds)
-    } else if (process.platform === "darwin") {
-      addon.setWindowBounds(this.id, newBounds)
+      for (const key of ["x", "y", "width", "height"] as const) {
+        if (newBounds[key] !== undefined) newBounds[key] = Math.floor(newBounds[key] * sf)
+      }
     }
+
+    addon.applyLayout([{ id: this.id, bounds: newBounds }])
   }
 
   getTitle(): string {
@@ -127,11 +137,8 @@ export class Window {
   isWindow(): boolean {
     if (!addon) return
 
-    if (process.platform === "win32") {
-      return this.path && this.path !== "" && addon.isWindow(this.id)
-    } else if (process.platform === "darwin") {
-      return this.path && this.path !== "" && !!addon.initWindow(this.id)
-    }
+    // Asked natively every time; the cached properties may outlive the window
+    return !!this.path && addon.isWindow(this.id)
   }
 
   isVisible(): boolean {
@@ -1,46 +1,67 @@
 import { Window } from "./classes/window"
 import { EventEmitter } from "events"
+import { writeFileSync } from "fs"
 import { Monitor } from "./classes/monitor"
 import { EmptyMonitor } from "./classes/empty-monitor"
-import { IWindowSummary } from "./interfaces"
+import { WindowSummaryView } from "./classes/window-summary-view"
+import {
+  IBoundsOptions,
+  ILayoutEntry,
+  ILayoutResult,
+  IMonitorDeliveryOptions,
+  INativeWindow,
+  IProcessCacheStats,
+  IRectangle,
+  IStats,
+  ITilingSpec,
+  ITraceOptions,
+  IWindowDelta,
+  IWindowFilterRule,
+  IWindowSummary,
+  IWindowSummaryOptions,
+  WindowSummaryField,
+} from "./interfaces"
 import bindings from "bindings"
 
 const addon = bindings("addon.node")
 
 let interval: any = null
 
+let lastActiveId: number
+
 let registeredEvents: string[] = []
 
+let monitorDelivery: IMonitorDeliveryOptions = {}
+
+// Linux and Windows push foreground changes from the native monitor; macOS
+// has no window-level notification, so it keeps polling
+const nativeActivation = process.platform !== "darwin"
+
 class WindowManager extends EventEmitter {
   constructor() {
     super()
 
-    let lastId: number
-
     if (!addon) return
 
     this.on("newListener", event => {
       if (event === "window-activated") {
-        lastId = addon.getActiveWindow()
+        lastActiveId = addon.getActiveWindow()
       }
 
       if (registeredEvents.indexOf(event) !== -1) return
 
-      if (event === "window-activated") {
+      if (event === "window-activated" && !nativeActivation) {
         interval = setInterval(async () => {
-          const win = addon.getActiveWindow()
-
-          if (lastId !== win) {
-            lastId = win
-            this.emit("window-activated", new Window(win))
-          }
+          this.activeWindowChanged(addon.getActiveWindow())
         }, 50)
-      } else if (event === "windows-summary-updated") {
-        if (addon && addon.startWindowsMonitoring) {
-          addon.startWindowsMonitoring((summaries: IWindowSummary[]) => {
-            this.emit("windows-summary-updated", summaries)
-          })
-        }
+      } else if (
+        event === "window-activated" ||
+        event === "windows-summary-updated" ||
+        event === "windows-changed"
+      ) {
+        registeredEvents.push(event)
+        this.updateWindowsMonitoring()
+        return
       } else if (event === "drag-crossed-monitor") {
         if (addon && addon.startDragCrossedMonitorMonitoring) {
           addon.startDragCrossedMonitorMonitoring(() => {
@@ -57,12 +78,16 @@ class WindowManager extends EventEmitter {
     this.on("removeListener", event => {
       if (this.listenerCount(event) > 0) return
 
-      if (event === "window-activated") {
+      if (event === "window-activated" && !nativeActivation) {
         clearInterval(interval)
-      } else if (event === "windows-summary-updated") {
-        if (addon && addon.stopWindowsMonitoring) {
-          addon.stopWindowsMonitoring()
-        }
+      } else if (
+        event === "window-activated" ||
+        event === "windows-summary-updated" ||
+        event === "windows-changed"
+      ) {
+        registeredEvents = registeredEvents.filter(x => x !== event)
+        this.updateWindowsMonitoring()
+        return
       } else if (event === "drag-crossed-monitor") {
         if (addon && addon.stopDragCrossedMonitorMonitoring) {
           addon.stopDragCrossedMonitorMonitoring()
@@ -73,6 +98,45 @@ class WindowManager extends EventEmitter {
     })
   }
 
+  // The native monitor may report a window that is already active, e.g.
+  // when the listener was added in between
+  private activeWindowChanged(id: number) {
+    if (id === lastActiveId) return
+    lastActiveId = id
+    this.emit("window-activated", new Window(id))
+  }
+
+  // One native monitor serves all three events; it only marshals full
+  // snapshots, deltas and foreground changes for the events that currently
+  // have listeners.
+  private updateWindowsMonitoring() {
+    if (!addon || !addon.startWindowsMonitoring) return
+
+    const summaries = registeredEvents.indexOf("windows-summary-updated") !== -1
+    const deltas = registeredEvents.indexOf("windows-changed") !== -1
+    const activation = nativeActivation && registeredEvents.indexOf("window-activated") !== -1
+
+    if (!summaries && !deltas && !activation) {
+      addon.stopWindowsMonitoring()
+      return
+    }
+
+    addon.startWindowsMonitoring(
+      (updated?: IWindowSummary[], changes?: IWindowDelta[], activeId?: number) => {
+        if (updated) this.emit("windows-summary-updated", updated)
+        if (changes) this.emit("windows-changed", changes)
+        if (activeId !== undefined) this.activeWindowChanged(activeId)
+      },
+      { summaries, deltas, activation, ...monitorDelivery }
+    )
+  }
+
+  // Applies right away if the monitor is running
+  setMonitorDelivery = (options: IMonitorDeliveryOptions) => {
+    monitorDelivery = { delivery: options.delivery, queueSize: options.queueSize }
+    this.updateWindowsMonitoring()
+  }
+
   requestAccessibility = () => {
     if (!addon || !addon.requestAccessibility) return true
     return addon.requestAccessibility()
@@ -90,10 +154,8 @@ class WindowManager extends EventEmitter {
 
   getWindows = (): Window[] => {
     if (!addon || !addon.getWindows) return []
-    return addon
-      .getWindows()
-      .map((win: any) => new Window(win))
-      .filter((x: Window) => x.isWindow())
+    // Already limited to windows with a process path
+    return addon.getWindows().map((win: INativeWindow) => new Window(win))
   }
 
   getMonitors = (): Monitor[] => {
@@ -101,9 +163,23 @@ class WindowManager extends EventEmitter {
     return addon.getMonitors().map((mon: any) => new Monitor(mon))
   }
 
+  // The *Async variants enumerate on a worker thread so a slow window system
+  // or a hung window cannot block the event loop
+  getWindowsAsync = async (): Promise<Window[]> => {
+    if (!addon || !addon.getWindowsAsync) return this.getWindows()
+    const windows = await addon.getWindowsAsync()
+    return windows.map((win: INativeWindow) => new Window(win))
+  }
+
+  getMonitorsAsync = async (): Promise<Monitor[]> => {
+    if (!addon || !addon.getMonitorsAsync) return this.getMonitors()
+    const monitors = await addon.getMonitorsAsync()
+    return monitors.map((mon: any) => new Monitor(mon))
+  }
+
   getPrimaryMonitor = (): Monitor | EmptyMonitor => {
-    if (process.platform === "win32") {
-      return this.getMonitors().find(x => x.isPrimary)
+    if (process.platform === "win32" || process.platform === "linux") {
+      return this.getMonitors().find(x => x.isPrimary()) ?? new EmptyMonitor()
     } else {
       return new EmptyMonitor()
     }
@@ -144,12 +220,145 @@ class WindowManager extends EventEmitter {
     return addon.showInstantly(handleNumber)
   }
 
-  getWindowsSummary = (): IWindowSummary[] => {
+  getWindowsSummary = <K extends WindowSummaryField = WindowSummaryField>(
+    options?: IWindowSummaryOptions<K>
+  ): Pick<IWindowSummary, K | "id">[] => {
     if (!addon || !addon.getWindowsSummary) return []
-    return addon.getWindowsSummary()
+    return addon.getWindowsSummary(options)
+  }
+
+  // Hit-testing against the native spatial index. While the summary monitor
+  // runs ("windows-summary-updated" or "windows-changed" listeners) queries
+  // never touch the window system; otherwise each call takes a snapshot.
+  windowAt = (x: number, y: number): IWindowSummary | undefined => {
+    if (!addon || !addon.windowAt) return undefined
+    return addon.windowAt(x, y) ?? undefined
+  }
+
+  windowsIntersecting = (rect: IRectangle): IWindowSummary[] => {
+    if (!addon || !addon.windowsIntersecting) return []
+    return addon.windowsIntersecting(rect)
+  }
+
+  // Applies every entry in one native call: a single flushed request batch on
+  // Linux and one DeferWindowPos transaction on Windows. Entries for the same
+  // window are merged, later ones winning. Returns one result per entry.
+  applyLayout = (entries: ILayoutEntry[]): ILayoutResult[] => {
+    if (!addon || !addon.applyLayout) return entries.map(({ id }) => ({ id, ok: false, error: "Not supported" }))
+    return addon.applyLayout(entries)
+  }
+
+  // Tiles the windows over the work areas (by default those of getMonitors())
+  // and applies the result as one applyLayout() batch. Windows are spread
+  // over the areas in order, earlier areas taking the extra ones.
+  tileWindows = (ids: number[], spec: ITilingSpec, workAreas?: IRectangle[]): ILayoutResult[] => {
+    if (!addon || !addon.tileWindows) return ids.map((id) => ({ id, ok: false, error: "Not supported" }))
+    return addon.tileWindows(ids, spec, workAreas ?? this.defaultWorkAreas())
+  }
+
+  // Every monitor's work area; without monitor exports (macOS) the primary
+  // monitor's, or else the screens' as reported by the addon
+  private defaultWorkAreas(): IRectangle[] {
+    const areas = this.getMonitors().map((monitor) => monitor.getWorkArea())
+    if (areas.length > 0) return areas
+    const primary = this.getPrimaryMonitor()
+    if (primary.isValid()) return [primary.getWorkArea()]
+    return addon.getScreenWorkAreas ? addon.getScreenWorkAreas() : []
+  }
+
+  // Replaces the native filter used by getWindowsSummary() and the monitors;
+  // throws a TypeError (and keeps the previous rules) if a rule is invalid.
+  setWindowFilters = (rules: IWindowFilterRule[]) => {
+    if (!addon || !addon.setWindowFilters) return
+    addon.setWindowFilters(
+      rules.map((rule) => {
+        if (!(rule.titleRegex instanceof RegExp)) return rule
+        return {
+          ...rule,
+          titleRegex: rule.titleRegex.source,
+          ignoreCase: rule.ignoreCase ?? rule.titleRegex.flags.includes("i"),
+        }
+      })
+    )
+  }
+
+  getProcessCacheStats = (): IProcessCacheStats => {
+    if (!addon || !addon.getProcessCacheStats) return { hits: 0, misses: 0, expired: 0, size: 0 }
+    return addon.getProcessCacheStats()
+  }
+
+  // Native counters and latency histograms since load or the last
+  // resetStats(); undefined with an addon that predates them
+  getStats = (): IStats | undefined => {
+    if (!addon || !addon.getStats) return undefined
+    return addon.getStats()
+  }
+
+  resetStats = () => {
+    if (!addon || !addon.resetStats) return
+    addon.resetStats()
+  }
+
+  // Records every stage of the monitor pipeline into a native ring buffer
+  // until stopTracing(); starting again discards the previous recording
+  startTracing = (options?: ITraceOptions) => {
+    if (!addon || !addon.startTracing) return
+    addon.startTracing(options)
+  }
+
+  stopTracing = () => {
+    if (!addon || !addon.stopTracing) return
+    addon.stopTracing()
+  }
+
+  // Chrome trace_event JSON, for chrome://tracing or ui.perfetto.dev;
+  // also written to `path` when one is given
+  dumpTrace = (path?: string): string => {
+    const trace: string = addon && addon.dumpTrace ? addon.dumpTrace() : '{"traceEvents":[]}'
+    if (path) writeFileSync(path, trace)
+    return trace
+  }
+
+  // Same data as getWindowsSummary() in one ArrayBuffer; nothing is allocated
+  // per window until a field is read through the view. Columns of fields
+  // left out of options.fields read as 0 or "".
+  getWindowsSummaryBinary = (options?: IWindowSummaryOptions): WindowSummaryView => {
+    if (!addon || !addon.getWindowsSummaryBinary) return new WindowSummaryView(emptySummaryBuffer)
+    return new WindowSummaryView(addon.getWindowsSummaryBinary(options))
+  }
+
+  getWindowsSummaryAsync = async <K extends WindowSummaryField = WindowSummaryField>(
+    options?: IWindowSummaryOptions<K>
+  ): Promise<Pick<IWindowSummary, K | "id">[]> => {
+    if (!addon || !addon.getWindowsSummaryAsync) return this.getWindowsSummary(options)
+    return addon.getWindowsSummaryAsync(options)
+  }
+
+  getWindowsSummaryBinaryAsync = async (options?: IWindowSummaryOptions): Promise<WindowSummaryView> => {
+    if (!addon || !addon.getWindowsSummaryBinaryAsync) return this.getWindowsSummaryBinary(options)
+    return new WindowSummaryView(await addon.getWindowsSummaryBinaryAsync(options))
   }
 }
 
+// version 1, zero windows, a single string offset
+const emptySummaryBuffer = new Int32Array([1, 0, 0, 0, 0]).buffer
+
 const windowManager = new WindowManager()
 
-export { windowManager, Window, addon, IWindowSummary }
+export {
+  windowManager,
+  Window,
+  WindowSummaryView,
+  addon,
+  IWindowSummary,
+  IWindowSummaryOptions,
+  IWindowDelta,
+  IWindowFilterRule,
+  ILayoutEntry,
+  ILayoutResult,
+  ITilingSpec,
+  IStats,
+  ITraceOptions,
+  INativeWindow,
+  IBoundsOptions,
+}
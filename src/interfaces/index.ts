@@ -5,6 +5,12 @@ export interface IRectangle {
   height?: number;
 }
 
+export interface IBoundsOptions {
+  // Device-independent pixels, scaled by the window's monitor. The default
+  // on Windows; macOS always reports points
+  logical?: boolean;
+}
+
 export interface IMonitorInfo {
   id: number;
   bounds?: IRectangle;
@@ -20,4 +26,150 @@ export interface IWindowSummary {
   bounds: IRectangle;
   zOrder: number;
   isVisible: boolean;
+  // Only present when requested through IWindowSummaryOptions.fields
+  visibleFraction?: number;
+  visibleRects?: IRectangle[];
+  // bounds in device-independent pixels, scaled by the window's monitor
+  logicalBounds?: IRectangle;
+}
+
+export type WindowSummaryField = keyof IWindowSummary;
+
+// Fields to collect; the native side skips the queries behind the others.
+// `id` is always included.
+export interface IWindowSummaryOptions<K extends WindowSummaryField = WindowSummaryField> {
+  fields?: K[];
+}
+
+export type WindowDeltaKind =
+  | "created"
+  | "destroyed"
+  | "moved"
+  | "resized"
+  | "reordered"
+  | "visibility"
+  | "retitled";
+
+// oldValue/newValue hold the whole summary for created/destroyed, bounds for
+// moved/resized, zOrder for reordered, isVisible for visibility and the title
+// for retitled.
+export interface IWindowDelta {
+  id: number;
+  kind: WindowDeltaKind;
+  oldValue?: IWindowSummary | IRectangle | number | boolean | string;
+  newValue?: IWindowSummary | IRectangle | number | boolean | string;
+}
+
+// A window is hidden when it satisfies every field the rule sets, and it is
+// hidden if any rule matches. exe is compared with the executable file name.
+export interface IWindowFilterRule {
+  exe?: string;
+  titlePrefix?: string;
+  titleSuffix?: string;
+  titleRegex?: string | RegExp;
+  ignoreCase?: boolean;
+  pid?: number;
+  minWidth?: number;
+  minHeight?: number;
+  maxWidth?: number;
+  maxHeight?: number;
+}
+
+// One window of applyLayout(). bounds may set any subset of x, y, width and
+// height, in the same native pixels getWindowsSummary() reports. show: false
+// hides the window (minimizes it on macOS); raise brings it to the front.
+export interface ILayoutEntry {
+  id: number;
+  bounds?: IRectangle;
+  show?: boolean;
+  raise?: boolean;
+}
+
+export interface ILayoutResult {
+  id: number;
+  ok: boolean;
+  error?: string;
+}
+
+export type TilingLayout = "grid" | "master-stack" | "columns";
+
+// decoration is the frame the window system draws around the rectangle a
+// window is moved to (title bar and borders of a reparenting X window
+// manager); use negative values for the invisible borders of Windows 10+.
+export interface ITilingSpec {
+  layout: TilingLayout;
+  gap?: number;
+  outerGap?: number;
+  decoration?: { left?: number; top?: number; right?: number; bottom?: number };
+  // master-stack only: share of the width for the master column (0.5) and
+  // number of windows in it (1)
+  masterRatio?: number;
+  masterCount?: number;
+  // grid only: fixed column count, default is the smallest square grid
+  columns?: number;
+}
+
+// addon.NativeWindow: what getWindows() returns, with the process and class
+// cached natively
+export interface INativeWindow {
+  readonly id: number;
+  readonly processId: number;
+  readonly path: string;
+  readonly className: string;
+  // False if the window was gone when the info was loaded
+  readonly valid: boolean;
+  // Reloads the cached info and returns the object
+  refresh(): INativeWindow;
+}
+
+export interface IProcessCacheStats {
+  hits: number;
+  misses: number;
+  expired: number;
+  size: number;
+}
+
+// Estimated from log-linear buckets; percentiles are within 12.5%
+export interface ILatencyStats {
+  count: number;
+  meanUs: number;
+  p50Us: number;
+  p95Us: number;
+  p99Us: number;
+  maxUs: number;
+}
+
+export interface ITraceOptions {
+  // Events kept in the ring; the oldest are overwritten. 65536 by default
+  bufferSize?: number;
+}
+
+export interface IMonitorDeliveryOptions {
+  // What happens to updates while the listeners are still busy: "latest"
+  // keeps one pending update and merges newer ones into it, "queue" keeps
+  // up to queueSize, "block" stalls the monitor thread. "latest" by default
+  delivery?: "latest" | "queue" | "block";
+  // 1 to 1024, 4 by default; not used by "latest"
+  queueSize?: number;
+}
+
+export interface IStats {
+  // Per export that was called since the last reset
+  exports: { [name: string]: { calls: number; latency: ILatencyStats } };
+  // X replies on Linux, Win32 queries on Windows, Core Graphics and
+  // NSRunningApplication lookups on macOS
+  nativeCalls: number;
+  // Not on macOS
+  processCache?: IProcessCacheStats;
+  monitor: {
+    eventsReceived: number;
+    eventsRelevant: number;
+    eventsCoalesced: number;
+    refreshes: number;
+    refreshesUnchanged: number;
+    updatesDispatched: number;
+    updatesMerged: number;
+    updatesDropped: number;
+  };
+  timings: { collect: ILatencyStats; marshal: ILatencyStats; callback: ILatencyStats };
 }
@@ -0,0 +1,121 @@
+// Micro-benchmarks for the lib/core hot path (filtering, z-order, diffing,
+// serialization) on synthetic snapshots. Builds without a window system:
+//   node-gyp rebuild --core_tests=true && ./build/Release/core_bench
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "core/spatial_index.h"
+#include "core/visible_region.h"
+#include "core/window_columns.h"
+#include "core/window_diff.h"
+#include "core/window_filter.h"
+#include "core/z_order.h"
+
+static const int ITERATIONS = 200;
+
+static std::vector<wm::WindowRecord> makeSnapshot (size_t count) {
+    std::vector<wm::WindowRecord> windows (count);
+    for (size_t i = 0; i < count; ++i) {
+        wm::WindowRecord& window = windows[i];
+        window.id = 0x1000000 + static_cast<int64_t> (i);
+        window.title = "Window " + std::to_string (i) + " - Synthetic Document";
+        window.path = "/usr/lib/app" + std::to_string (i % 16) + "/bin/app";
+        window.processId = 1000 + static_cast<int64_t> (i % 16);
+        window.bounds = { static_cast<int> (i % 1920), static_cast<int> (i % 1080), 800, 600 };
+        window.zOrder = static_cast<int> (i);
+        window.isVisible = true;
+    }
+    return windows;
+}
+
+// Runs `fn` ITERATIONS times and prints p50/p99 in microseconds
+template <typename Fn> static void measure (const char* name, size_t count, Fn fn) {
+    for (int i = 0; i < 5; ++i) fn ();
+
+    std::vector<double> samples (ITERATIONS);
+    for (int i = 0; i < ITERATIONS; ++i) {
+        auto start = std::chrono::steady_clock::now ();
+        fn ();
+        samples[i] =
+        std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now () - start).count ();
+    }
+
+    std::sort (samples.begin (), samples.end ());
+    std::printf ("%-24s n=%-5zu p50=%9.1fus p99=%9.1fus\n", name, count, samples[ITERATIONS / 2],
+                 samples[ITERATIONS * 99 / 100]);
+}
+
+int main () {
+    wm::WindowFilter filter{ {
+    wm::FilterRule::exeWithTitlePrefix ("xeester.exe", "XEESTER:"),
+    wm::FilterRule::exeWithTitlePrefix ("app3", "Window 3"),
+    wm::FilterRule::exeWithTitlePrefix ("app7", "Overlay"),
+    } };
+
+    for (size_t count : { 10, 100, 1000, 5000 }) {
+        const auto snapshot = makeSnapshot (count);
+
+        std::vector<int64_t> stack;
+        for (const auto& window : snapshot) stack.push_back (window.id);
+
+        // Same snapshot with every tenth window moved
+        auto moved = snapshot;
+        for (size_t i = 0; i < moved.size (); i += 10) moved[i].bounds.x += 5;
+
+        size_t sink = 0;
+
+        measure ("filter", count, [&] {
+            for (const auto& window : snapshot) sink += filter.excludes (window.path, window.title);
+        });
+
+        measure ("zorder", count, [&] {
+            auto map = wm::ZOrderMap::fromTopDown (stack);
+            for (const auto& window : snapshot) sink += map.find (window.id);
+        });
+
+        measure ("spatial build", count, [&] { sink += wm::SpatialIndex (snapshot).size (); });
+
+        wm::SpatialIndex index (snapshot);
+        measure ("spatial 1000 hits", count, [&] {
+            for (int i = 0; i < 1000; ++i) {
+                const wm::WindowRecord* hit = index.at ((i * 37) % 2400, (i * 53) % 1600);
+                sink += hit ? 1 : 0;
+            }
+        });
+
+        // Cascaded windows, so most of them partly cover each other
+        auto cascaded = snapshot;
+        for (size_t i = 0; i < cascaded.size (); ++i) {
+            cascaded[i].bounds = { static_cast<int> ((i * 23) % 1600), static_cast<int> ((i * 17) % 900), 640, 480 };
+        }
+        measure ("visible regions", count, [&] {
+            auto windows = cascaded;
+            wm::computeVisibleRegions (windows, { { 0, 0, 1920, 1080 }, { 1920, 0, 1920, 1080 } });
+            sink += windows.back ().visibleRects.size ();
+        });
+
+        measure ("diff unchanged", count, [&] {
+            wm::WindowDiffer differ;
+            differ.update (snapshot);
+            sink += differ.update (snapshot).size ();
+        });
+
+        measure ("diff 10% moved", count, [&] {
+            wm::WindowDiffer differ;
+            differ.update (snapshot);
+            sink += differ.update (moved).size ();
+        });
+
+        measure ("serialize columns", count,
+                 [&] { sink += wm::serializeWindowColumns (snapshot).size (); });
+
+        if (sink == 0) std::printf ("\n");
+        std::printf ("\n");
+    }
+
+    return 0;
+}
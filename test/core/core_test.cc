@@ -0,0 +1,701 @@
+// Unit tests for lib/core. Builds without a window system:
+//   node-gyp rebuild --core_tests=true && ./build/Release/core_test
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/layout.h"
+#include "core/monitors.h"
+#include "core/process_cache.h"
+#include "core/spatial_index.h"
+#include "core/stats.h"
+#include "core/summary_fields.h"
+#include "core/tiling.h"
+#include "core/trace.h"
+#include "core/visible_region.h"
+#include "core/window_cache.h"
+#include "core/window_columns.h"
+#include "core/window_diff.h"
+#include "core/window_filter.h"
+#include "core/z_order.h"
+
+static int g_failures = 0;
+
+#define CHECK(expr)                                                                           \
+    do {                                                                                      \
+        if (!(expr)) {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed" << std::endl; \
+            ++g_failures;                                                                     \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK ((a) == (b))
+
+static wm::WindowRecord makeWindow (int64_t id, const std::string& title, int zOrder) {
+    wm::WindowRecord window{};
+    window.id = id;
+    window.title = title;
+    window.path = "/usr/bin/app";
+    window.processId = 100;
+    window.bounds = { 10, 20, 300, 200 };
+    window.zOrder = zOrder;
+    window.isVisible = true;
+    return window;
+}
+
+static void testFilter () {
+    wm::WindowFilter filter{ {
+    wm::FilterRule::exeWithTitlePrefix ("app.exe", "Hidden:"),
+    wm::FilterRule::exeWithTitlePrefix ("app.exe", "Overlay"),
+    wm::FilterRule::exeWithTitlePrefix ("other.exe", ""),
+    } };
+
+    CHECK (filter.excludes ("C:\\Program Files\\app.exe", "Hidden: window"));
+    CHECK (filter.excludes ("/opt/app.exe", "Overlay"));
+    CHECK (!filter.excludes ("C:\\app.exe", "Visible"));
+    CHECK (!filter.excludes ("C:\\app.exe", "Hidden"));
+    CHECK (filter.excludes ("other.exe", "anything"));
+    CHECK (!filter.excludes ("", "Hidden: window"));
+    CHECK (!filter.excludes ("C:\\APP.EXE", "Hidden: window"));
+
+    CHECK (wm::WindowFilter{}.empty ());
+    CHECK (!wm::WindowFilter{}.excludes ("app.exe", "Hidden:"));
+}
+
+static void testFilterRules () {
+    wm::FilterRule suffix{};
+    suffix.titleSuffix = " - Tooltip";
+    wm::FilterRule pattern{};
+    pattern.executableName = "app";
+    pattern.titlePattern = "^notification \\d+$";
+    pattern.titlePatternIgnoreCase = true;
+    wm::FilterRule tiny{};
+    tiny.maxWidth = 10;
+    tiny.maxHeight = 10;
+    wm::FilterRule pid{};
+    pid.processId = 42;
+
+    wm::WindowFilter filter;
+    size_t failed = 0;
+    CHECK (wm::WindowFilter::compile ({ suffix, pattern, tiny, pid }, filter, failed).empty ());
+    CHECK_EQ (filter.fields (), static_cast<unsigned> (wm::FILTER_ALL));
+
+    auto window = makeWindow (1, "Editor - Tooltip", 0);
+    CHECK (filter.excludes (window));
+    window.title = "Tooltip";
+    CHECK (!filter.excludes (window));
+
+    window.title = "Notification 12";
+    window.path = "/usr/bin/other";
+    CHECK (!filter.excludes (window));
+    window.path = "/opt/app";
+    CHECK (filter.excludes (window));
+    window.title = "Notification 12 more";
+    CHECK (!filter.excludes (window));
+
+    window.bounds = { 0, 0, 8, 8 };
+    CHECK (filter.excludes (window));
+    window.bounds = { 0, 0, 8, 80 };
+    CHECK (!filter.excludes (window));
+
+    window.processId = 42;
+    CHECK (filter.excludes (window));
+
+    // Staged evaluation: a rule runs once all its fields are available and
+    // is not repeated by a later stage that passes the earlier ones as checked
+    auto staged = makeWindow (2, "Notification 1", 0);
+    staged.path = "/opt/app";
+    CHECK (!filter.excludes (staged, wm::FILTER_PID | wm::FILTER_BOUNDS | wm::FILTER_TITLE));
+    CHECK (filter.excludes (staged, wm::FILTER_ALL, wm::FILTER_PID | wm::FILTER_BOUNDS | wm::FILTER_TITLE));
+    CHECK (!filter.excludes (staged, wm::FILTER_ALL, wm::FILTER_ALL));
+
+    wm::FilterRule broken{};
+    broken.titlePattern = "(unclosed";
+    CHECK (!wm::WindowFilter::compile ({ suffix, broken }, filter, failed).empty ());
+    CHECK_EQ (failed, 1u);
+    // The previous filter is left untouched on failure
+    CHECK (filter.excludes (window));
+
+    CHECK (!wm::WindowFilter::compile ({ wm::FilterRule{} }, filter, failed).empty ());
+    CHECK_EQ (failed, 0u);
+
+    wm::FilterRule inverted{};
+    inverted.minWidth = 100;
+    inverted.maxWidth = 50;
+    CHECK (!wm::WindowFilter::compile ({ inverted }, filter, failed).empty ());
+}
+
+static void testZOrder () {
+    auto topDown = wm::ZOrderMap::fromTopDown ({ 7, 8, 9 });
+    CHECK_EQ (topDown.find (7), 0);
+    CHECK_EQ (topDown.find (9), 2);
+    CHECK_EQ (topDown.find (1), -1);
+
+    auto bottomUp = wm::ZOrderMap::fromBottomUp ({ 7, 8, 9 });
+    CHECK_EQ (bottomUp.find (9), 0);
+    CHECK_EQ (bottomUp.find (7), 2);
+    CHECK_EQ (bottomUp.size (), 3u);
+}
+
+static void testDiff () {
+    wm::WindowDiffer differ;
+
+    auto deltas = differ.update ({ makeWindow (1, "a", 0), makeWindow (2, "b", 1) });
+    CHECK_EQ (deltas.size (), 2u);
+    CHECK (deltas[0].kind == wm::DeltaKind::Created && deltas[0].id == 1);
+    CHECK (deltas[1].kind == wm::DeltaKind::Created && deltas[1].id == 2);
+
+    CHECK (differ.update ({ makeWindow (1, "a", 0), makeWindow (2, "b", 1) }).empty ());
+
+    auto moved = makeWindow (1, "a2", 1);
+    moved.bounds = { 50, 20, 400, 200 };
+    moved.isVisible = false;
+    deltas = differ.update ({ makeWindow (3, "c", 0), moved });
+
+    std::vector<wm::DeltaKind> kinds;
+    for (const auto& delta : deltas) kinds.push_back (delta.kind);
+    std::vector<wm::DeltaKind> expected{ wm::DeltaKind::Created,   wm::DeltaKind::Destroyed,
+                                         wm::DeltaKind::Reordered, wm::DeltaKind::Moved,
+                                         wm::DeltaKind::Resized,   wm::DeltaKind::Visibility,
+                                         wm::DeltaKind::Retitled };
+    CHECK (kinds == expected);
+    CHECK_EQ (deltas[1].id, 2);
+    CHECK_EQ (deltas[1].before.title, "b");
+    CHECK_EQ (deltas[3].before.bounds.x, 10);
+    CHECK_EQ (deltas[3].after.bounds.x, 50);
+    CHECK_EQ (std::string (wm::deltaKindName (deltas[6].kind)), "retitled");
+
+    differ.reset ();
+    CHECK_EQ (differ.update ({ makeWindow (3, "c", 0) }).size (), 1u);
+}
+
+// Merging the deltas of two updates gives what one update would have seen
+static void testMergeDeltas () {
+    std::vector<wm::WindowRecord> first{ makeWindow (1, "a", 0), makeWindow (2, "b", 1) };
+    auto moved = makeWindow (1, "a", 0);
+    moved.bounds.x = 50;
+    std::vector<wm::WindowRecord> second{ moved, makeWindow (2, "b", 1), makeWindow (3, "c", 2) };
+    auto retitled = makeWindow (2, "b2", 0);
+    std::vector<wm::WindowRecord> third{ makeWindow (1, "a", 1), retitled, makeWindow (4, "d", 2) };
+
+    wm::WindowDiffer differ;
+    differ.update (first);
+    auto merged = differ.update (second);
+    wm::mergeWindowDeltas (merged, differ.update (third));
+
+    wm::WindowDiffer direct;
+    direct.update (first);
+    auto expected = direct.update (third);
+
+    CHECK_EQ (merged.size (), expected.size ());
+    for (size_t i = 0; i < merged.size () && i < expected.size (); ++i) {
+        CHECK_EQ (merged[i].id, expected[i].id);
+        CHECK (merged[i].kind == expected[i].kind);
+        CHECK_EQ (merged[i].before.title, expected[i].before.title);
+        CHECK_EQ (merged[i].after.title, expected[i].after.title);
+    }
+
+    // Window 3 came and went, window 1 moved there and back: nothing left
+    // of either
+    for (const auto& delta : merged) CHECK (delta.id != 3 && !(delta.id == 1 && delta.kind == wm::DeltaKind::Moved));
+
+    std::vector<wm::WindowDelta> none;
+    wm::mergeWindowDeltas (none, direct.update (third));
+    CHECK (none.empty ());
+}
+
+static void testColumns () {
+    auto first = makeWindow (0x1a00003, "t\xc3\xa9tle", 0);
+    auto second = makeWindow (0xffffffff, "other", 1);
+    second.isVisible = false;
+    second.bounds = { -5, 6, 7, 8 };
+
+    std::vector<uint8_t> bytes = wm::serializeWindowColumns ({ first, second });
+
+    std::vector<int32_t> words ((bytes.size () + 3) / 4);
+    std::memcpy (words.data (), bytes.data (), bytes.size ());
+
+    const size_t count = 2;
+    CHECK_EQ (words[0], wm::WINDOW_COLUMNS_VERSION);
+    CHECK_EQ (words[1], 2);
+    // "t\xc3\xa9tle", "/usr/bin/app" (shared), "other"
+    CHECK_EQ (words[2], 3);
+    CHECK_EQ (words[3], 6 + 12 + 5);
+
+    auto column = [&] (int col, size_t i) {
+        return words[wm::WINDOW_COLUMNS_HEADER_WORDS + col * count + i];
+    };
+    CHECK_EQ (static_cast<uint32_t> (column (wm::COLUMN_ID, 1)), 0xffffffffu);
+    CHECK_EQ (column (wm::COLUMN_X, 1), -5);
+    CHECK_EQ (column (wm::COLUMN_Z_ORDER, 1), 1);
+    CHECK_EQ (column (wm::COLUMN_FLAGS, 0), wm::WINDOW_FLAG_VISIBLE);
+    CHECK_EQ (column (wm::COLUMN_FLAGS, 1), 0);
+    CHECK_EQ (column (wm::COLUMN_PATH, 0), column (wm::COLUMN_PATH, 1));
+
+    size_t offsets = wm::WINDOW_COLUMNS_HEADER_WORDS + wm::COLUMN_COUNT * count;
+    const char* blob = reinterpret_cast<const char*> (bytes.data ()) + (offsets + words[2] + 1) * 4;
+    int32_t titleRef = column (wm::COLUMN_TITLE, 1);
+    CHECK_EQ (std::string (blob + words[offsets + titleRef], blob + words[offsets + titleRef + 1]),
+              "other");
+
+    std::vector<uint8_t> empty = wm::serializeWindowColumns ({});
+    CHECK_EQ (empty.size (), (wm::WINDOW_COLUMNS_HEADER_WORDS + 1) * 4);
+}
+
+static void testSummaryFields () {
+    CHECK_EQ (wm::summaryFieldFromName ("zOrder"), static_cast<unsigned> (wm::SUMMARY_Z_ORDER));
+    CHECK_EQ (wm::summaryFieldFromName ("isVisible"), static_cast<unsigned> (wm::SUMMARY_IS_VISIBLE));
+    CHECK_EQ (wm::summaryFieldFromName ("zorder"), 0u);
+    // Logical bounds are scaled from the physical ones
+    CHECK_EQ (wm::summaryFieldsToCollect (wm::SUMMARY_ID | wm::SUMMARY_LOGICAL_BOUNDS, 0),
+              wm::SUMMARY_ID | wm::SUMMARY_LOGICAL_BOUNDS | wm::SUMMARY_BOUNDS);
+
+    // Filter rules pull in the fields they read; a path needs the pid
+    unsigned requested = wm::SUMMARY_ID | wm::SUMMARY_BOUNDS;
+    CHECK_EQ (wm::summaryFieldsToCollect (requested, 0), requested);
+    CHECK_EQ (wm::summaryFieldsToCollect (requested, wm::FILTER_PATH | wm::FILTER_TITLE),
+              requested | wm::SUMMARY_PATH | wm::SUMMARY_PROCESS_ID | wm::SUMMARY_TITLE);
+
+    std::vector<wm::WindowRecord> windows{ makeWindow (5, "title", 3) };
+    wm::projectWindowRecords (windows, requested);
+    CHECK_EQ (windows[0].id, 5);
+    CHECK_EQ (windows[0].bounds.width, 300);
+    CHECK (windows[0].title.empty () && windows[0].path.empty ());
+    CHECK_EQ (windows[0].processId, 0);
+    CHECK_EQ (windows[0].zOrder, 0);
+    CHECK (!windows[0].isVisible);
+}
+
+static void testSpatialIndex () {
+    auto back = makeWindow (1, "back", 2);
+    back.bounds = { 0, 0, 1000, 800 };
+    auto front = makeWindow (2, "front", 0);
+    front.bounds = { 100, 100, 300, 200 };
+    auto left = makeWindow (3, "left monitor", 1);
+    left.bounds = { -1920, 0, 1920, 1080 };
+    auto hidden = makeWindow (4, "minimized", 3);
+    hidden.isVisible = false;
+    auto huge = makeWindow (5, "huge", 4);
+    huge.bounds = { -100000, -100000, 200000, 200000 };
+
+    wm::SpatialIndex index ({ back, front, left, hidden, huge }, 64);
+    CHECK_EQ (index.size (), 4u);
+
+    CHECK_EQ (index.at (150, 150)->id, 2);
+    CHECK_EQ (index.at (50, 50)->id, 1);
+    // Right and bottom edges are exclusive
+    CHECK_EQ (index.at (400, 150)->id, 1);
+    CHECK_EQ (index.at (-1, 0)->id, 3);
+    CHECK_EQ (index.at (-1921, 0)->id, 5);
+    CHECK (index.at (200000, 0) == nullptr);
+
+    auto hits = index.intersecting ({ 350, 250, 100, 100 });
+    CHECK_EQ (hits.size (), 3u);
+    CHECK (hits[0]->id == 2 && hits[1]->id == 1 && hits[2]->id == 5);
+
+    hits = index.intersecting ({ -50000, -50000, 100000, 100000 });
+    CHECK_EQ (hits.size (), 4u);
+    CHECK (index.intersecting ({ 0, 0, 0, 10 }).empty ());
+
+    CHECK (wm::SpatialIndex ({}).at (0, 0) == nullptr);
+}
+
+static int64_t totalArea (const std::vector<wm::Rect>& rects) {
+    int64_t area = 0;
+    for (const auto& r : rects) area += static_cast<int64_t> (r.width) * r.height;
+    return area;
+}
+
+static void testVisibleRegion () {
+    std::vector<wm::Rect> visible;
+
+    // A hole in the middle leaves four pieces: top, left, right, bottom
+    CHECK_EQ (wm::visibleRegion ({ 0, 0, 100, 100 }, { { 25, 25, 50, 50 } }, {}, visible), 7500);
+    CHECK_EQ (visible.size (), 4u);
+    CHECK_EQ (totalArea (visible), 7500);
+
+    // Overlapping occluders are only subtracted once
+    CHECK_EQ (wm::visibleRegion ({ 0, 0, 100, 100 }, { { 0, 0, 60, 100 }, { 40, 0, 60, 50 } }, {}, visible), 2000);
+    CHECK_EQ (visible.size (), 1u);
+    CHECK (visible[0] == (wm::Rect{ 60, 50, 40, 50 }));
+
+    // Clipped to two side-by-side monitors with a gap below the shorter one
+    std::vector<wm::Rect> monitors{ { 0, 0, 100, 100 }, { 100, 0, 100, 50 } };
+    CHECK_EQ (wm::visibleRegion ({ 50, 0, 100, 100 }, {}, monitors, visible), 50 * 100 + 50 * 50);
+    CHECK_EQ (wm::visibleRegion ({ 300, 0, 10, 10 }, {}, monitors, visible), 0);
+    CHECK (visible.empty ());
+
+    auto top = makeWindow (1, "top", 0);
+    top.bounds = { 0, 0, 50, 100 };
+    auto middle = makeWindow (2, "middle", 1);
+    middle.bounds = { 0, 0, 100, 100 };
+    auto hidden = makeWindow (3, "hidden", 2);
+    hidden.isVisible = false;
+    auto bottom = makeWindow (4, "bottom", 3);
+    bottom.bounds = { 50, 0, 100, 100 };
+
+    std::vector<wm::WindowRecord> windows{ bottom, hidden, middle, top };
+    wm::computeVisibleRegions (windows, { { 0, 0, 1000, 1000 } });
+    CHECK_EQ (windows[3].visibleFraction, 1.0);
+    CHECK_EQ (windows[2].visibleFraction, 0.5);
+    CHECK_EQ (windows[1].visibleFraction, 0.0);
+    CHECK_EQ (windows[0].visibleFraction, 0.5);
+    CHECK (windows[0].visibleRects.size () == 1 && windows[0].visibleRects[0] == (wm::Rect{ 100, 0, 50, 100 }));
+}
+
+// Fake process table for the cache: pids are alive while listed here
+static std::vector<int64_t> g_running;
+static int g_released = 0;
+
+static bool fakeLoad (int64_t pid, wm::ProcessInfo& info) {
+    for (int64_t running : g_running) {
+        if (running == pid) {
+            info.path = "/bin/proc" + std::to_string (pid);
+            info.startTime = static_cast<uint64_t> (pid) * 10;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool fakeAlive (const wm::ProcessInfo& info) {
+    for (int64_t running : g_running) {
+        if (running == info.pid) return true;
+    }
+    return false;
+}
+
+static void fakeRelease (wm::ProcessInfo&) {
+    ++g_released;
+}
+
+static void testLayout () {
+    wm::LayoutChange move{ 1, { 10, 20, 0, 0 }, wm::LAYOUT_POSITION, wm::LAYOUT_KEEP, false };
+    wm::LayoutChange other{ 2, { 0, 0, 300, 200 }, wm::LAYOUT_SIZE, wm::LAYOUT_HIDE, false };
+    wm::LayoutChange widen{ 1, { 0, 0, 640, 0 }, wm::LAYOUT_WIDTH, wm::LAYOUT_SHOW, true };
+
+    std::vector<uint32_t> slots;
+    auto merged = wm::coalesceLayoutChanges ({ move, other, widen }, slots);
+    CHECK_EQ (merged.size (), 2u);
+    // Window 1 is placed at its last entry, after window 2
+    CHECK_EQ (merged[0].id, 2);
+    CHECK_EQ (merged[1].id, 1);
+    CHECK (slots == (std::vector<uint32_t>{ 1, 0, 1 }));
+
+    const wm::LayoutChange& first = merged[1];
+    CHECK_EQ (first.boundsFields, static_cast<unsigned> (wm::LAYOUT_POSITION | wm::LAYOUT_WIDTH));
+    CHECK (first.bounds == (wm::Rect{ 10, 20, 640, 0 }));
+    CHECK_EQ (first.visibility, wm::LAYOUT_SHOW);
+    CHECK (first.raise);
+    CHECK_EQ (merged[0].visibility, wm::LAYOUT_HIDE);
+
+    CHECK (wm::resolveLayoutBounds ({ 1, 2, 3, 4 }, first) == (wm::Rect{ 10, 20, 640, 4 }));
+    CHECK (wm::coalesceLayoutChanges ({}, slots).empty ());
+    CHECK (slots.empty ());
+}
+
+static void testTiling () {
+    wm::TilingSpec spec{ wm::TILING_COLUMNS, 10, 5, { 0, 0, 0, 0 }, 0.5, 1, 0 };
+    wm::Rect area{ 0, 0, 1000, 500 };
+
+    // 990 - 2 gaps = 970 split into 323 + 323 + 324
+    auto columns = wm::tileArea (spec, area, 3);
+    CHECK_EQ (columns.size (), 3u);
+    CHECK (columns[0] == (wm::Rect{ 5, 5, 323, 490 }));
+    CHECK (columns[1] == (wm::Rect{ 338, 5, 323, 490 }));
+    CHECK (columns[2] == (wm::Rect{ 671, 5, 324, 490 }));
+
+    spec.mode = wm::TILING_GRID;
+    spec.gap = spec.outerGap = 0;
+    auto grid = wm::tileArea (spec, area, 5);
+    CHECK_EQ (grid.size (), 5u);
+    CHECK (grid[0] == (wm::Rect{ 0, 0, 333, 250 }));
+    CHECK (grid[2] == (wm::Rect{ 666, 0, 334, 250 }));
+    // The short last row shares the full width
+    CHECK (grid[3] == (wm::Rect{ 0, 250, 500, 250 }));
+    CHECK (grid[4] == (wm::Rect{ 500, 250, 500, 250 }));
+
+    spec.mode = wm::TILING_MASTER_STACK;
+    spec.masterRatio = 0.6;
+    spec.decoration = { 2, 20, 2, 2 };
+    auto stack = wm::tileArea (spec, area, 3);
+    CHECK (stack[0] == (wm::Rect{ 2, 20, 596, 478 }));
+    CHECK (stack[1] == (wm::Rect{ 602, 20, 396, 228 }));
+    CHECK (stack[2] == (wm::Rect{ 602, 270, 396, 228 }));
+    // A lone master takes the whole area
+    CHECK (wm::tileArea (spec, area, 1)[0] == (wm::Rect{ 2, 20, 996, 478 }));
+
+    // Five windows over two monitors: 3 + 2
+    spec.decoration = { 0, 0, 0, 0 };
+    spec.mode = wm::TILING_COLUMNS;
+    auto spread = wm::computeTiling (spec, { area, { 1000, 0, 800, 600 } }, 5);
+    CHECK_EQ (spread.size (), 5u);
+    CHECK_EQ (spread[2].x, 666);
+    CHECK (spread[3] == (wm::Rect{ 1000, 0, 400, 600 }));
+    CHECK (spread[4] == (wm::Rect{ 1400, 0, 400, 600 }));
+    CHECK (wm::computeTiling (spec, {}, 3).empty ());
+}
+
+static void testMonitors () {
+    std::vector<wm::MonitorRecord> monitors = {
+        { 10, { 0, 0, 1920, 1080 }, { 0, 0, 1920, 1040 }, true, 1 },
+        { 20, { 1920, 0, 2560, 1440 }, { 1920, 0, 2560, 1440 }, false, 1.5 },
+    };
+
+    CHECK_EQ (wm::monitorForRect (monitors, { 100, 100, 400, 300 }), 0);
+    // Mostly on the second monitor
+    CHECK_EQ (wm::monitorForRect (monitors, { 1800, 100, 400, 300 }), 1);
+    // Off-screen: nearest monitor
+    CHECK_EQ (wm::monitorForRect (monitors, { 5000, 200, 100, 100 }), 1);
+    CHECK_EQ (wm::monitorForRect (monitors, { -500, 2000, 100, 100 }), 0);
+    CHECK_EQ (wm::monitorForRect ({}, { 0, 0, 10, 10 }), -1);
+
+    CHECK (wm::intersectRects ({ 0, 0, 100, 100 }, { 50, 20, 100, 10 }) == (wm::Rect{ 50, 20, 50, 10 }));
+    CHECK_EQ (wm::intersectRects ({ 0, 0, 10, 10 }, { 20, 20, 5, 5 }).width, 0);
+
+    // Rounded down, as Windows scales for DPI-unaware processes
+    CHECK (wm::logicalRect ({ 1921, -3, 301, 200 }, 1.5) == (wm::Rect{ 1280, -2, 200, 133 }));
+    CHECK (wm::logicalRect ({ 5, 5, 10, 10 }, 0) == (wm::Rect{ 5, 5, 10, 10 }));
+
+    std::vector<wm::WindowRecord> windows{ makeWindow (1, "a", 0), makeWindow (2, "b", 1) };
+    windows[1].bounds = { 2100, 150, 600, 300 };
+    wm::computeLogicalBounds (windows, monitors);
+    CHECK (windows[0].logicalBounds == windows[0].bounds);
+    CHECK (windows[1].logicalBounds == (wm::Rect{ 1400, 100, 400, 200 }));
+    wm::computeLogicalBounds (windows, {});
+    CHECK (windows[1].logicalBounds == windows[1].bounds);
+
+    // 27" 4K at 163 dpi, 15.6" 4K at 282 dpi, a projector's bogus EDID
+    CHECK_EQ (wm::scaleFromPhysicalSize (3840, 597), 1);
+    CHECK_EQ (wm::scaleFromPhysicalSize (3840, 344), 2);
+    CHECK_EQ (wm::scaleFromPhysicalSize (1920, 16), 1);
+    CHECK_EQ (wm::scaleFromPhysicalSize (1920, 0), 1);
+}
+
+static void testProcessCache () {
+    g_running = { 1, 2 };
+    wm::ProcessCache cache{ { fakeLoad, fakeAlive, fakeRelease } };
+
+    wm::ProcessInfo info;
+    CHECK (cache.lookup (1, info));
+    CHECK_EQ (info.name, "proc1");
+    CHECK (cache.lookup (1, info));
+    CHECK (cache.lookup (2, info));
+    CHECK (!cache.lookup (3, info));
+
+    auto stats = cache.stats ();
+    CHECK_EQ (stats.hits, 1u);
+    CHECK_EQ (stats.misses, 3u);
+    CHECK_EQ (stats.size, 2u);
+
+    // Exited process: the hit turns into an expiry and a failed reload
+    g_running = { 2 };
+    CHECK (!cache.lookup (1, info));
+    CHECK_EQ (cache.stats ().expired, 1u);
+    CHECK_EQ (g_released, 1);
+
+    cache.retain ({});
+    CHECK_EQ (cache.stats ().size, 0u);
+    CHECK_EQ (g_released, 2);
+
+    // A full cache drops exited processes first, then the least recently used
+    g_running = { 1, 2, 3, 4 };
+    g_released = 0;
+    wm::ProcessCache small{ { fakeLoad, fakeAlive, fakeRelease }, 2 };
+    CHECK (small.lookup (1, info));
+    CHECK (small.lookup (2, info));
+    CHECK (small.lookup (1, info));
+    CHECK (small.lookup (3, info));
+    CHECK_EQ (small.stats ().size, 2u);
+    CHECK_EQ (g_released, 1);
+    CHECK (small.lookup (1, info));
+    CHECK_EQ (small.stats ().hits, 2u);
+
+    g_running = { 4 };
+    CHECK (small.lookup (4, info));
+    CHECK_EQ (small.stats ().size, 1u);
+    CHECK_EQ (g_released, 3);
+}
+
+static void testStats () {
+    // Values below 8ns are exact, above that four buckets per power of two
+    CHECK_EQ (wm::LatencyHistogram::bucketFor (7), 7u);
+    CHECK_EQ (wm::LatencyHistogram::bucketFor (8), 8u);
+    CHECK_EQ (wm::LatencyHistogram::bucketFor (1000), wm::LatencyHistogram::bucketFor (1023));
+    CHECK (wm::LatencyHistogram::bucketFor (1023) < wm::LatencyHistogram::bucketFor (1024));
+    for (unsigned bucket = 0; bucket < 64; ++bucket) {
+        CHECK_EQ (wm::LatencyHistogram::bucketFor (wm::LatencyHistogram::bucketStart (bucket)), bucket);
+    }
+    CHECK_EQ (wm::LatencyHistogram::bucketFor (UINT64_MAX), wm::LatencyHistogram::BUCKETS - 1);
+
+    wm::LatencyHistogram histogram;
+    CHECK_EQ (histogram.snapshot ().count, 0u);
+    for (int i = 0; i < 98; ++i) histogram.record (10000);
+    histogram.record (1000000);
+    histogram.record (5000000);
+
+    wm::LatencySnapshot snapshot = histogram.snapshot ();
+    CHECK_EQ (snapshot.count, 100u);
+    CHECK_EQ (snapshot.maxUs, 5000.0);
+    CHECK (snapshot.meanUs > 69.7 && snapshot.meanUs < 69.9);
+    CHECK (snapshot.p50Us >= 10 * 0.875 && snapshot.p50Us <= 10 * 1.125);
+    CHECK (snapshot.p95Us <= 10 * 1.125);
+    CHECK (snapshot.p99Us >= 1000 * 0.875 && snapshot.p99Us <= 1000 * 1.125);
+    histogram.reset ();
+    CHECK_EQ (histogram.snapshot ().count, 0u);
+
+    // Exports are registered once per name and survive a reset
+    wm::Stats stats;
+    wm::ExportStats* entry = stats.exportStats ("getWindows");
+    CHECK (stats.exportStats ("getWindows") == entry);
+    stats.exportStats ("getActiveWindow");
+    CHECK_EQ (stats.exports ().size (), 2u);
+
+    entry->calls += 3;
+    stats.add (wm::STAT_MONITOR_EVENTS, 5);
+    stats.add (wm::STAT_MONITOR_EVENTS);
+    {
+        wm::ScopedTimer timer (stats.timer (wm::TIMER_COLLECT));
+    }
+    CHECK_EQ (stats.counter (wm::STAT_MONITOR_EVENTS), 6u);
+    CHECK_EQ (stats.timer (wm::TIMER_COLLECT).snapshot ().count, 1u);
+
+    stats.reset ();
+    CHECK_EQ (entry->calls.load (), 0u);
+    CHECK_EQ (stats.counter (wm::STAT_MONITOR_EVENTS), 0u);
+    CHECK_EQ (stats.timer (wm::TIMER_COLLECT).snapshot ().count, 0u);
+    CHECK_EQ (stats.exports ().size (), 2u);
+}
+
+static void testTrace () {
+    // The ring keeps the newest events, oldest first
+    wm::TraceBuffer buffer (4);
+    for (uint64_t i = 1; i <= 6; ++i) buffer.record ({ "event", wm::TRACE_INSTANT, i * 1000, 0, i, 1, nullptr, 0 });
+    std::vector<wm::TraceEvent> events = buffer.events ();
+    CHECK_EQ (events.size (), 4u);
+    CHECK_EQ (events.front ().id, 3u);
+    CHECK_EQ (events.back ().id, 6u);
+    CHECK_EQ (buffer.overwritten (), 2u);
+    buffer.clear ();
+    CHECK (buffer.events ().empty ());
+
+    // Nothing is recorded while stopped
+    wm::Tracer& tracer = wm::tracer ();
+    { wm::TraceScope scope ("ignored"); }
+    CHECK_EQ (tracer.json ().find ("ignored"), std::string::npos);
+
+    tracer.nameThread ("test");
+    tracer.start (16);
+    uint64_t id = tracer.nextId ();
+    { wm::TraceScope scope ("collect", id); }
+    wm::traceInstant ("x-event", 0, "type", 22);
+    wm::traceAsync ("update", id, 1000, 6000);
+    tracer.stop ();
+    wm::traceInstant ("after-stop");
+
+    std::string json = tracer.json ();
+    CHECK_EQ (json.compare (0, 16, "{\"traceEvents\":["), 0);
+    CHECK (json.find ("\"name\":\"collect\",\"cat\":\"wm\",\"ph\":\"X\"") != std::string::npos);
+    CHECK (json.find ("\"s\":\"t\",\"args\":{\"type\":22}") != std::string::npos);
+    CHECK (json.find ("\"ph\":\"b\",\"pid\":1,\"tid\":1,\"ts\":1.000,\"id\":\"" + std::to_string (id)) !=
+           std::string::npos);
+    CHECK (json.find ("\"latencyUs\":5") != std::string::npos);
+    CHECK (json.find ("\"args\":{\"name\":\"test\"}") != std::string::npos);
+    CHECK_EQ (json.find ("after-stop"), std::string::npos);
+
+    // Restarting clears the ring
+    tracer.start (16);
+    tracer.stop ();
+    CHECK_EQ (tracer.json ().find ("collect"), std::string::npos);
+}
+
+static void testWindowCache () {
+    wm::WindowCache cache;
+    CHECK (cache.listDirty ());
+    CHECK (cache.stackingDirty ());
+
+    // New windows start fully dirty, and taking the dirty set clears it
+    cache.setWindows ({ 1, 2, 3 });
+    cache.setStacking ({ 3, 1, 2 });
+    CHECK (!cache.listDirty ());
+    CHECK (!cache.stackingDirty ());
+    CHECK_EQ (cache.find (2)->record.zOrder, 0);
+    CHECK_EQ (cache.find (3)->record.zOrder, 2);
+
+    auto dirty = cache.takeDirty ();
+    CHECK_EQ (dirty.size (), 3u);
+    CHECK_EQ (dirty[0].first, 1);
+    CHECK_EQ (dirty[0].second, static_cast<unsigned> (wm::DIRTY_ALL));
+    CHECK (cache.takeDirty ().empty ());
+
+    // Events for a frame land on its window; unknown windows are ignored
+    cache.setFrame (2, 200);
+    CHECK (cache.markDirty (200, wm::DIRTY_GEOMETRY));
+    CHECK (cache.markDirty (2, wm::DIRTY_TITLE));
+    CHECK (cache.markDirty (1, wm::DIRTY_STATE));
+    CHECK (!cache.markDirty (999, wm::DIRTY_GEOMETRY));
+    dirty = cache.takeDirty ();
+    CHECK_EQ (dirty.size (), 2u);
+    CHECK_EQ (dirty[0].first, 1);
+    CHECK_EQ (dirty[0].second, static_cast<unsigned> (wm::DIRTY_STATE));
+    CHECK_EQ (dirty[1].first, 2);
+    CHECK_EQ (dirty[1].second, static_cast<unsigned> (wm::DIRTY_GEOMETRY | wm::DIRTY_TITLE));
+
+    // Reparenting replaces the frame
+    cache.setFrame (2, 201);
+    CHECK (!cache.markDirty (200, wm::DIRTY_GEOMETRY));
+    CHECK (cache.markDirty (201, wm::DIRTY_GEOMETRY));
+    cache.takeDirty ();
+
+    // Records survive list changes; dropped windows take their frame along
+    cache.find (1)->record.title = "kept";
+    cache.setWindows ({ 4, 1 });
+    CHECK_EQ (cache.find (1)->record.title, "kept");
+    CHECK (cache.find (2) == nullptr);
+    CHECK (!cache.markDirty (201, wm::DIRTY_GEOMETRY));
+    CHECK_EQ (cache.find (4)->dirty, static_cast<unsigned> (wm::DIRTY_ALL));
+    CHECK_EQ (cache.order ().size (), 2u);
+    CHECK_EQ (cache.order ()[0], 4);
+
+    // Windows found gone are skipped until the list drops them
+    cache.find (4)->valid = false;
+    CHECK (cache.get (4) == nullptr);
+    CHECK (cache.get (1) != nullptr);
+    dirty = cache.takeDirty ();
+    CHECK (dirty.empty ());
+
+    cache.markAllDirty (wm::DIRTY_GEOMETRY);
+    CHECK_EQ (cache.takeDirty ().size (), 1u);
+
+    cache.clear ();
+    CHECK (cache.listDirty ());
+    CHECK_EQ (cache.size (), 0u);
+}
+
+int main () {
+    testFilter ();
+    testFilterRules ();
+    testZOrder ();
+    testDiff ();
+    testMergeDeltas ();
+    testColumns ();
+    testSummaryFields ();
+    testSpatialIndex ();
+    testVisibleRegion ();
+    testLayout ();
+    testTiling ();
+    testMonitors ();
+    testProcessCache ();
+    testStats ();
+    testTrace ();
+    testWindowCache ();
+
+    if (g_failures) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "core tests passed" << std::endl;
+    return 0;
+}
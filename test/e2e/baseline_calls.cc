@@ -0,0 +1,142 @@
+// Baseline for npm run bench:calls: the per-call exports as they were before
+// the Linux backend shared one X connection. Every call opens its own
+// display, interns its atoms and closes the display again, exactly like the
+// old lib/linux.cpp did. Prints one JSON object with per-call latency in
+// microseconds, in the shape bench-calls.mjs reports the addon in.
+//
+//   baseline_calls <iterations> <window>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static Window getActiveWindow () {
+    Display* display = XOpenDisplay (NULL);
+    Window root = XDefaultRootWindow (display);
+    Atom activeWindow = XInternAtom (display, "_NET_ACTIVE_WINDOW", False);
+    Atom type;
+    int format;
+    unsigned long nItems, bytesAfter;
+    unsigned char* property = NULL;
+    Window active = 0;
+
+    if (XGetWindowProperty (display, root, activeWindow, 0, 1024, False, AnyPropertyType, &type, &format, &nItems,
+                            &bytesAfter, &property) == Success &&
+        property) {
+        active = *reinterpret_cast<Window*> (property);
+        XFree (property);
+    }
+
+    XCloseDisplay (display);
+    return active;
+}
+
+static void getWindowBounds (Window handle) {
+    Display* display = XOpenDisplay (NULL);
+    Window root;
+    int x, y;
+    unsigned int width, height, borderWidth, depth;
+    XGetGeometry (display, handle, &root, &x, &y, &width, &height, &borderWidth, &depth);
+    XCloseDisplay (display);
+}
+
+static bool isWindow (Window handle) {
+    Display* display = XOpenDisplay (NULL);
+    XWindowAttributes attributes;
+    Status status = XGetWindowAttributes (display, handle, &attributes);
+    XCloseDisplay (display);
+    return status != 0;
+}
+
+static int getWindowZOrder (Window target) {
+    Display* display = XOpenDisplay (NULL);
+    if (!display) return -1;
+
+    Window root = XDefaultRootWindow (display);
+    Atom stackingAtom = XInternAtom (display, "_NET_CLIENT_LIST_STACKING", True);
+    if (stackingAtom == None) {
+        XCloseDisplay (display);
+        return -1;
+    }
+
+    Atom type;
+    int format;
+    unsigned long nItems, bytesAfter;
+    unsigned char* data = NULL;
+    if (XGetWindowProperty (display, root, stackingAtom, 0, 1024, False, XA_WINDOW, &type, &format, &nItems,
+                            &bytesAfter, &data) != Success ||
+        !data) {
+        XCloseDisplay (display);
+        return -1;
+    }
+
+    Window* list = reinterpret_cast<Window*> (data);
+    int zIndex = -1;
+    for (unsigned long i = 0; i < nItems; ++i) {
+        if (list[i] == target) {
+            zIndex = static_cast<int> (nItems - 1 - i);
+            break;
+        }
+    }
+
+    XFree (data);
+    XCloseDisplay (display);
+    return zIndex;
+}
+
+static int ignoreErrors (Display*, XErrorEvent*) {
+    return 0;
+}
+
+template <typename Call>
+static void measure (const char* name, int iterations, Call call, bool last = false) {
+    // Same warm-up as the addon measurement
+    for (int i = 0; i < std::min (20, iterations); ++i) call ();
+
+    std::vector<double> samples (iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now ();
+        call ();
+        samples[i] = std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now () - start).count ();
+    }
+
+    std::sort (samples.begin (), samples.end ());
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    auto percentile = [&] (double p) {
+        size_t index = std::min (samples.size () - 1, static_cast<size_t> (p / 100 * samples.size ()));
+        return samples[index];
+    };
+    printf ("  \"%s\": { \"mean\": %.1f, \"p50\": %.1f, \"p95\": %.1f, \"p99\": %.1f }%s\n", name,
+            sum / samples.size (), percentile (50), percentile (95), percentile (99), last ? "" : ",");
+}
+
+int main (int argc, char** argv) {
+    int iterations = argc > 1 ? atoi (argv[1]) : 2000;
+    Window window = argc > 2 ? strtoul (argv[2], NULL, 10) : 0;
+    if (iterations < 1) iterations = 1;
+
+    Display* probe = XOpenDisplay (NULL);
+    if (!probe) {
+        fprintf (stderr, "baseline_calls: cannot open the X display\n");
+        return 1;
+    }
+    XCloseDisplay (probe);
+    // The old exports had no handler of their own either, but a stale window
+    // must not end the measurement
+    XSetErrorHandler (ignoreErrors);
+
+    printf ("{\n");
+    measure ("getActiveWindow", iterations, [] { getActiveWindow (); }, window == 0);
+    if (window != 0) {
+        measure ("getWindowBounds", iterations, [&] { getWindowBounds (window); });
+        measure ("getWindowZOrder", iterations, [&] { getWindowZOrder (window); });
+        measure ("isWindow", iterations, [&] { isWindow (window); }, true);
+    }
+    printf ("}\n");
+    return 0;
+}
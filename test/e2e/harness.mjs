@@ -0,0 +1,56 @@
+import { spawn } from "node:child_process"
+import { fileURLToPath } from "node:url"
+
+// Private Xvfb server, stand-in window manager and synthetic clients shared
+// by the end-to-end benchmark (scripts/bench-e2e.mjs) and tests. Everything
+// started here is killed by stopAll().
+
+export const buildDir = fileURLToPath(new URL("../../build/Release/", import.meta.url))
+const children = []
+
+export const sleep = ms => new Promise(resolve => setTimeout(resolve, ms))
+
+export async function waitFor(predicate, what, timeoutMs = 60000) {
+  const deadline = Date.now() + timeoutMs
+  while (!predicate()) {
+    if (Date.now() > deadline) throw new Error(`Timed out waiting for ${what}`)
+    await sleep(20)
+  }
+}
+
+function track(child) {
+  children.push(child)
+  return child
+}
+
+// Resolves to the display name, e.g. ":99"
+export async function startXvfb(screen = "1920x1080x24") {
+  const xvfb = track(
+    spawn("Xvfb", ["-displayfd", "3", "-screen", "0", screen, "-nolisten", "tcp"], {
+      stdio: ["ignore", "ignore", "inherit", "pipe"],
+    })
+  )
+  let output = ""
+  xvfb.stdio[3].on("data", chunk => (output += chunk))
+  await waitFor(() => output.includes("\n"), "Xvfb to start", 10000)
+  return `:${output.trim()}`
+}
+
+export async function startWindowManager(display) {
+  const wm = track(spawn(buildDir + "stub_wm", [], { env: { ...process.env, DISPLAY: display } }))
+  wm.stderr.pipe(process.stderr)
+  let output = ""
+  wm.stdout.on("data", chunk => (output += chunk))
+  await waitFor(() => output.includes("ready"), "the window manager", 10000)
+}
+
+// Maps `count` titled windows on $DISPLAY; they close when the returned
+// process' stdin is ended.
+export function spawnWindows(count) {
+  return track(spawn(buildDir + "spawn_windows", [String(count)], { stdio: ["pipe", "ignore", "inherit"] }))
+}
+
+export function stopAll() {
+  for (const child of children.reverse()) child.kill()
+  children.length = 0
+}
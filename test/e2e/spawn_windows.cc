@@ -0,0 +1,74 @@
+// Synthetic client for the end-to-end benchmark: maps `count` titled
+// top-level windows with _NET_WM_PID set, tiled over the screen with some
+// overlap, then keeps them open until stdin is closed.
+//
+//   spawn_windows <count>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <xcb/xcb.h>
+
+static xcb_atom_t internAtom (xcb_connection_t* conn, const char* name) {
+    xcb_intern_atom_reply_t* reply =
+    xcb_intern_atom_reply (conn, xcb_intern_atom (conn, 0, strlen (name), name), NULL);
+    xcb_atom_t atom = reply ? reply->atom : XCB_ATOM_NONE;
+    free (reply);
+    return atom;
+}
+
+int main (int argc, char** argv) {
+    int count = argc > 1 ? atoi (argv[1]) : 10;
+
+    int screenNumber = 0;
+    xcb_connection_t* conn = xcb_connect (NULL, &screenNumber);
+    if (xcb_connection_has_error (conn)) {
+        fprintf (stderr, "spawn_windows: cannot connect to the X server\n");
+        return 1;
+    }
+
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator (xcb_get_setup (conn));
+    for (int i = 0; i < screenNumber; ++i) xcb_screen_next (&screens);
+    xcb_screen_t* screen = screens.data;
+
+    xcb_atom_t netWmName = internAtom (conn, "_NET_WM_NAME");
+    xcb_atom_t netWmPid = internAtom (conn, "_NET_WM_PID");
+    xcb_atom_t utf8 = internAtom (conn, "UTF8_STRING");
+    uint32_t pid = static_cast<uint32_t> (getpid ());
+
+    // A grid of cells, each window a bit larger than its cell so that
+    // neighbours overlap and the visible-region code has work to do
+    int columns = 1;
+    while (columns * columns < count) ++columns;
+    int cellWidth = screen->width_in_pixels / columns;
+    int cellHeight = screen->height_in_pixels / columns;
+
+    for (int i = 0; i < count; ++i) {
+        xcb_window_t window = xcb_generate_id (conn);
+        int16_t x = static_cast<int16_t> ((i % columns) * cellWidth);
+        int16_t y = static_cast<int16_t> ((i / columns) * cellHeight);
+        uint16_t width = static_cast<uint16_t> (cellWidth + cellWidth / 4 + 1);
+        uint16_t height = static_cast<uint16_t> (cellHeight + cellHeight / 4 + 1);
+        const uint32_t background = screen->white_pixel;
+        xcb_create_window (conn, XCB_COPY_FROM_PARENT, window, screen->root, x, y, width, height, 0,
+                           XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, XCB_CW_BACK_PIXEL, &background);
+
+        std::string title = "bench window " + std::to_string (i);
+        xcb_change_property (conn, XCB_PROP_MODE_REPLACE, window, netWmName, utf8, 8, title.size (), title.c_str ());
+        xcb_change_property (conn, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                             title.size (), title.c_str ());
+        xcb_change_property (conn, XCB_PROP_MODE_REPLACE, window, netWmPid, XCB_ATOM_CARDINAL, 32, 1, &pid);
+        xcb_map_window (conn, window);
+    }
+    xcb_flush (conn);
+
+    // The windows live as long as the connection; wait for the runner
+    char buffer[64];
+    while (read (STDIN_FILENO, buffer, sizeof (buffer)) > 0) {
+    }
+
+    xcb_disconnect (conn);
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Minimal EWMH window manager for the end-to-end benchmark (npm run
+// bench:e2e). It does just enough for the addon to see a managed desktop:
+// _NET_CLIENT_LIST(_STACKING) in map and stacking order, _NET_ACTIVE_WINDOW
+// activation requests, one desktop with a full-screen work area. Windows are
+// not reparented or decorated, and configure requests are applied as sent.
+//
+// Prints "ready" once it owns the root window.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <xcb/xcb.h>
+
+enum AtomIndex {
+    NET_SUPPORTED,
+    NET_SUPPORTING_WM_CHECK,
+    NET_WM_NAME,
+    UTF8_STRING,
+    NET_CLIENT_LIST,
+    NET_CLIENT_LIST_STACKING,
+    NET_ACTIVE_WINDOW,
+    NET_NUMBER_OF_DESKTOPS,
+    NET_CURRENT_DESKTOP,
+    NET_WORKAREA,
+    NET_WM_PID,
+    ATOM_COUNT
+};
+
+static const char* ATOM_NAMES[ATOM_COUNT] = {
+    "_NET_SUPPORTED",        "_NET_SUPPORTING_WM_CHECK", "_NET_WM_NAME",
+    "UTF8_STRING",           "_NET_CLIENT_LIST",         "_NET_CLIENT_LIST_STACKING",
+    "_NET_ACTIVE_WINDOW",    "_NET_NUMBER_OF_DESKTOPS",  "_NET_CURRENT_DESKTOP",
+    "_NET_WORKAREA",         "_NET_WM_PID"
+};
+
+static xcb_connection_t* g_conn;
+static xcb_window_t g_root;
+static xcb_atom_t g_atoms[ATOM_COUNT];
+// Map order, and stacking order from bottom to top
+static std::vector<xcb_window_t> g_clients;
+static std::vector<xcb_window_t> g_stacking;
+static xcb_window_t g_active = XCB_WINDOW_NONE;
+// The lists are republished once per burst of events, not per event, so
+// mapping thousands of windows does not rewrite them thousands of times
+static bool g_dirty = false;
+
+static void setCardinals (xcb_window_t window, AtomIndex atom, xcb_atom_t type, const std::vector<uint32_t>& values) {
+    xcb_change_property (g_conn, XCB_PROP_MODE_REPLACE, window, g_atoms[atom], type, 32, values.size (),
+                         values.data ());
+}
+
+static void publish () {
+    setCardinals (g_root, NET_CLIENT_LIST, XCB_ATOM_WINDOW, std::vector<uint32_t> (g_clients.begin (), g_clients.end ()));
+    setCardinals (g_root, NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW,
+                  std::vector<uint32_t> (g_stacking.begin (), g_stacking.end ()));
+    setCardinals (g_root, NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, { g_active });
+    xcb_flush (g_conn);
+}
+
+static bool managed (xcb_window_t window) {
+    return std::find (g_clients.begin (), g_clients.end (), window) != g_clients.end ();
+}
+
+static void forget (xcb_window_t window) {
+    g_clients.erase (std::remove (g_clients.begin (), g_clients.end (), window), g_clients.end ());
+    g_stacking.erase (std::remove (g_stacking.begin (), g_stacking.end (), window), g_stacking.end ());
+    if (g_active == window) g_active = XCB_WINDOW_NONE;
+}
+
+static void raise (xcb_window_t window) {
+    g_stacking.erase (std::remove (g_stacking.begin (), g_stacking.end (), window), g_stacking.end ());
+    g_stacking.push_back (window);
+}
+
+static void lower (xcb_window_t window) {
+    g_stacking.erase (std::remove (g_stacking.begin (), g_stacking.end (), window), g_stacking.end ());
+    g_stacking.insert (g_stacking.begin (), window);
+}
+
+static void onConfigureRequest (const xcb_configure_request_event_t* request) {
+    // Values follow the order of the mask bits
+    uint32_t values[7];
+    int count = 0;
+    if (request->value_mask & XCB_CONFIG_WINDOW_X) values[count++] = static_cast<uint32_t> (request->x);
+    if (request->value_mask & XCB_CONFIG_WINDOW_Y) values[count++] = static_cast<uint32_t> (request->y);
+    if (request->value_mask & XCB_CONFIG_WINDOW_WIDTH) values[count++] = request->width;
+    if (request->value_mask & XCB_CONFIG_WINDOW_HEIGHT) values[count++] = request->height;
+    if (request->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) values[count++] = request->border_width;
+    if (request->value_mask & XCB_CONFIG_WINDOW_SIBLING) values[count++] = request->sibling;
+    if (request->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) values[count++] = request->stack_mode;
+    xcb_configure_window (g_conn, request->window, request->value_mask, values);
+
+    if ((request->value_mask & XCB_CONFIG_WINDOW_STACK_MODE) && managed (request->window)) {
+        if (request->stack_mode == XCB_STACK_MODE_BELOW) {
+            lower (request->window);
+        } else {
+            raise (request->window);
+        }
+        g_dirty = true;
+    }
+}
+
+static void activate (xcb_window_t window) {
+    if (!managed (window)) return;
+
+    const uint32_t above = XCB_STACK_MODE_ABOVE;
+    xcb_configure_window (g_conn, window, XCB_CONFIG_WINDOW_STACK_MODE, &above);
+    xcb_set_input_focus (g_conn, XCB_INPUT_FOCUS_POINTER_ROOT, window, XCB_CURRENT_TIME);
+    raise (window);
+    g_active = window;
+    g_dirty = true;
+}
+
+static void handleEvent (const xcb_generic_event_t* event) {
+    switch (event->response_type & ~0x80) {
+    case XCB_MAP_REQUEST: {
+        auto request = reinterpret_cast<const xcb_map_request_event_t*> (event);
+        xcb_map_window (g_conn, request->window);
+        if (!managed (request->window)) {
+            g_clients.push_back (request->window);
+            g_stacking.push_back (request->window);
+            g_dirty = true;
+        }
+        break;
+    }
+    case XCB_CONFIGURE_REQUEST:
+        onConfigureRequest (reinterpret_cast<const xcb_configure_request_event_t*> (event));
+        break;
+    case XCB_UNMAP_NOTIFY: {
+        auto notify = reinterpret_cast<const xcb_unmap_notify_event_t*> (event);
+        if (notify->event == g_root && managed (notify->window)) {
+            forget (notify->window);
+            g_dirty = true;
+        }
+        break;
+    }
+    case XCB_DESTROY_NOTIFY: {
+        auto notify = reinterpret_cast<const xcb_destroy_notify_event_t*> (event);
+        if (managed (notify->window)) {
+            forget (notify->window);
+            g_dirty = true;
+        }
+        break;
+    }
+    case XCB_CLIENT_MESSAGE: {
+        auto message = reinterpret_cast<const xcb_client_message_event_t*> (event);
+        if (message->type == g_atoms[NET_ACTIVE_WINDOW]) activate (message->window);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int main () {
+    int screenNumber = 0;
+    g_conn = xcb_connect (NULL, &screenNumber);
+    if (xcb_connection_has_error (g_conn)) {
+        fprintf (stderr, "stub_wm: cannot connect to the X server\n");
+        return 1;
+    }
+
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator (xcb_get_setup (g_conn));
+    for (int i = 0; i < screenNumber; ++i) xcb_screen_next (&screens);
+    xcb_screen_t* screen = screens.data;
+    g_root = screen->root;
+
+    // Only one client may redirect the root window's substructure
+    const uint32_t rootMask = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+    xcb_void_cookie_t select = xcb_change_window_attributes_checked (g_conn, g_root, XCB_CW_EVENT_MASK, &rootMask);
+    if (xcb_generic_error_t* error = xcb_request_check (g_conn, select)) {
+        fprintf (stderr, "stub_wm: another window manager is running\n");
+        free (error);
+        return 1;
+    }
+
+    xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+    for (int i = 0; i < ATOM_COUNT; ++i) {
+        cookies[i] = xcb_intern_atom (g_conn, 0, strlen (ATOM_NAMES[i]), ATOM_NAMES[i]);
+    }
+    for (int i = 0; i < ATOM_COUNT; ++i) {
+        xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply (g_conn, cookies[i], NULL);
+        g_atoms[i] = reply ? reply->atom : XCB_ATOM_NONE;
+        free (reply);
+    }
+
+    xcb_window_t check = xcb_generate_id (g_conn);
+    xcb_create_window (g_conn, XCB_COPY_FROM_PARENT, check, g_root, -1, -1, 1, 1, 0,
+                       XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT, 0, NULL);
+    setCardinals (g_root, NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, { check });
+    setCardinals (check, NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, { check });
+    xcb_change_property (g_conn, XCB_PROP_MODE_REPLACE, check, g_atoms[NET_WM_NAME], g_atoms[UTF8_STRING], 8, 7,
+                         "stub-wm");
+
+    std::vector<uint32_t> supported (g_atoms, g_atoms + ATOM_COUNT);
+    setCardinals (g_root, NET_SUPPORTED, XCB_ATOM_ATOM, supported);
+    setCardinals (g_root, NET_NUMBER_OF_DESKTOPS, XCB_ATOM_CARDINAL, { 1 });
+    setCardinals (g_root, NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, { 0 });
+    setCardinals (g_root, NET_WORKAREA, XCB_ATOM_CARDINAL, { 0, 0, screen->width_in_pixels, screen->height_in_pixels });
+    publish ();
+
+    printf ("ready\n");
+    fflush (stdout);
+
+    while (xcb_generic_event_t* event = xcb_wait_for_event (g_conn)) {
+        do {
+            handleEvent (event);
+            free (event);
+        } while ((event = xcb_poll_for_event (g_conn)));
+
+        if (g_dirty) {
+            publish ();
+            g_dirty = false;
+        }
+        xcb_flush (g_conn);
+    }
+
+    xcb_disconnect (g_conn);
+    return 0;
+}
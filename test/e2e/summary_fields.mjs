@@ -0,0 +1,58 @@
+import assert from "node:assert/strict"
+import { spawnWindows, startWindowManager, startXvfb, stopAll, waitFor } from "./harness.mjs"
+
+// Field projection must only change which properties come back, never which
+// windows: every projection lists the same ids as the full call.
+//
+//   npm run test:e2e
+
+const COUNT = 8
+const PROJECTIONS = [
+  ["id"],
+  ["id", "bounds"],
+  ["title"],
+  ["path"],
+  ["processId", "isVisible"],
+  ["zOrder"],
+  ["visibleFraction"],
+  ["logicalBounds"],
+]
+
+const idsOf = windows => windows.map(w => w.id).sort((a, b) => a - b)
+
+async function main() {
+  const display = await startXvfb("1920x1080x24")
+  await startWindowManager(display)
+
+  // The addon opens its display on first use
+  process.env.DISPLAY = display
+  const { windowManager } = await import("../../dist/index.js")
+
+  spawnWindows(COUNT)
+  await waitFor(() => windowManager.getWindowsSummary().length >= COUNT, `${COUNT} windows`)
+
+  const full = idsOf(windowManager.getWindowsSummary())
+  assert.equal(full.length, COUNT, "every synthetic window is listed")
+
+  for (const fields of PROJECTIONS) {
+    assert.deepEqual(idsOf(windowManager.getWindowsSummary({ fields })), full, `ids with fields ${fields}`)
+    assert.deepEqual(
+      idsOf(await windowManager.getWindowsSummaryAsync({ fields })),
+      full,
+      `ids with fields ${fields} (async)`
+    )
+  }
+
+  console.log("summary fields test passed")
+}
+
+main()
+  .catch(error => {
+    console.error(error)
+    process.exitCode = 1
+  })
+  .finally(() => {
+    stopAll()
+    // The window monitor thread keeps the process alive otherwise
+    setTimeout(() => process.exit(), 100)
+  })
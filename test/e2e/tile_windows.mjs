@@ -0,0 +1,83 @@
+import assert from "node:assert/strict"
+import { spawnWindows, startWindowManager, startXvfb, stopAll, waitFor } from "./harness.mjs"
+
+// Tiles synthetic windows on a private Xvfb server and checks where they
+// ended up. The stand-in window manager applies configure requests as sent,
+// so every window must land exactly on its tile:
+//
+//   npm run test:e2e
+
+const COUNT = 4
+
+function boundsOf(windowManager) {
+  return new Map(windowManager.getWindowsSummary({ fields: ["bounds"] }).map(w => [w.id, w.bounds]))
+}
+
+// Waits for the configure requests to reach the server, then compares
+async function expectBounds(windowManager, ids, expected, what) {
+  const matches = () => {
+    const after = boundsOf(windowManager)
+    return ids.every((id, i) => JSON.stringify(after.get(id)) === JSON.stringify(expected[i]))
+  }
+  await waitFor(matches, what, 5000).catch(() => {})
+  const after = boundsOf(windowManager)
+  assert.deepEqual(ids.map(id => after.get(id)), expected, what)
+}
+
+async function main() {
+  const display = await startXvfb("1920x1080x24")
+  await startWindowManager(display)
+
+  // The addon opens its display on first use
+  process.env.DISPLAY = display
+  const { windowManager } = await import("../../dist/index.js")
+
+  spawnWindows(COUNT)
+  await waitFor(() => windowManager.getWindowsSummary({ fields: ["id"] }).length >= COUNT, `${COUNT} windows`)
+  const ids = windowManager.getWindowsSummary({ fields: ["id"] }).map(w => w.id)
+
+  // Explicit work area: a 2x2 grid of equal cells between the gaps
+  let results = windowManager.tileWindows(ids, { layout: "grid", gap: 10, outerGap: 20 }, [
+    { x: 100, y: 50, width: 1050, height: 850 },
+  ])
+  assert.deepEqual(results.map(r => r.ok), ids.map(() => true), "grid tiling applied")
+  await expectBounds(
+    windowManager,
+    ids,
+    [
+      { x: 120, y: 70, width: 500, height: 400 },
+      { x: 630, y: 70, width: 500, height: 400 },
+      { x: 120, y: 480, width: 500, height: 400 },
+      { x: 630, y: 480, width: 500, height: 400 },
+    ],
+    "grid tiles"
+  )
+
+  // Default work areas: the single monitor, which the stub leaves uncovered
+  const [monitor] = windowManager.getMonitors()
+  assert.ok(monitor, "a monitor is reported")
+  const area = monitor.getWorkArea()
+  results = windowManager.tileWindows(ids, { layout: "columns" })
+  assert.deepEqual(results.map(r => r.ok), ids.map(() => true), "column tiling applied")
+  // Columns split the width to the pixel, as wm::computeTiling does
+  const edge = i => Math.floor((area.width * i) / COUNT)
+  await expectBounds(
+    windowManager,
+    ids,
+    ids.map((_, i) => ({ x: area.x + edge(i), y: area.y, width: edge(i + 1) - edge(i), height: area.height })),
+    "column tiles over the default work area"
+  )
+
+  console.log("tile windows test passed")
+}
+
+main()
+  .catch(error => {
+    console.error(error)
+    process.exitCode = 1
+  })
+  .finally(() => {
+    stopAll()
+    // The window monitor thread keeps the process alive otherwise
+    setTimeout(() => process.exit(), 100)
+  })